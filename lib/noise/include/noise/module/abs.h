@@ -54,6 +54,10 @@ namespace noise
         /// Constructor.
         Abs ();
 
+        virtual void GetRange (double xMin, double yMin, double zMin,
+          double xMax, double yMax, double zMax, double& lower,
+          double& upper) const;
+
         virtual int GetSourceModuleCount () const
         {
           return 1;
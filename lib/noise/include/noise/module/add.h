@@ -55,6 +55,10 @@ namespace noise
         /// Constructor.
         Add ();
 
+        virtual void GetRange (double xMin, double yMin, double zMin,
+          double xMax, double yMax, double zMax, double& lower,
+          double& upper) const;
+
         virtual int GetSourceModuleCount () const
         {
           return 2;
@@ -62,6 +66,9 @@ namespace noise
 
         virtual double GetValue (double x, double y, double z) const;
 
+        virtual void GetValues (const double* x, const double* y,
+          const double* z, double* values, int count) const;
+
     };
 
     /// @}
@@ -139,6 +139,17 @@ namespace noise
           return m_octaveCount;
         }
 
+        /// Returns the period of the billowy noise.
+        ///
+        /// @returns The period of the first octave, in lattice cells, or 0
+        /// if the billowy noise does not repeat.
+        ///
+        /// See SetPeriod().
+        int GetPeriod () const
+        {
+          return m_period;
+        }
+
         /// Returns the persistence value of the billowy noise.
         ///
         /// @returns The persistence value of the billowy noise.
@@ -149,6 +160,10 @@ namespace noise
           return m_persistence;
         }
 
+        virtual void GetRange (double xMin, double yMin, double zMin,
+          double xMax, double yMax, double zMax, double& lower,
+          double& upper) const;
+
         /// Returns the seed value used by the billowy-noise function.
         ///
         /// @returns The seed value.
@@ -164,6 +179,9 @@ namespace noise
 
         virtual double GetValue (double x, double y, double z) const;
 
+        virtual void GetValues (const double* x, const double* y,
+          const double* z, double* values, int count) const;
+
         /// Sets the frequency of the first octave.
         ///
         /// @param frequency The frequency of the first octave.
@@ -221,6 +239,32 @@ namespace noise
           m_octaveCount = octaveCount;
         }
 
+        /// Sets the period of the billowy noise.
+        ///
+        /// @param period The period of the first octave, in lattice cells,
+        /// or 0 to disable periodic noise.
+        ///
+        /// @pre The period ranges from 0 to 1073741824.
+        ///
+        /// @throw noise::ExceptionInvalidParam An invalid parameter was
+        /// specified; see the preconditions for more information.
+        ///
+        /// A periodic billowy noise repeats every @a period / frequency units
+        /// along each axis, so a noise map that covers exactly one period
+        /// tiles without seams.  The period of each following octave is
+        /// the period of the previous one times the lacunarity, rounded to
+        /// a whole number of lattice cells; that octave's frequency is
+        /// adjusted by the same rounding (see MakeIntPeriod()).  A
+        /// periodic billowy noise is therefore not identical to the
+        /// non-periodic one, unless the lacunarity is an integer.
+        void SetPeriod (int period)
+        {
+          if (period < 0 || period > 1073741824) {
+            throw noise::ExceptionInvalidParam ();
+          }
+          m_period = period;
+        }
+
         /// Sets the persistence value of the billowy noise.
         ///
         /// @param persistence The persistence value of the billowy noise.
@@ -259,6 +303,10 @@ namespace noise
         /// Persistence value of the billowy noise.
         double m_persistence;
 
+        /// Period of the first octave, in lattice cells; 0 if the
+        /// billowy noise does not repeat.
+        int m_period;
+
         /// Seed value used by the billowy-noise function.
         int m_seed;
 
@@ -98,6 +98,10 @@ namespace noise
           return *(m_pSourceModule[2]);
         }
 
+        virtual void GetRange (double xMin, double yMin, double zMin,
+          double xMax, double yMax, double zMax, double& lower,
+          double& upper) const;
+
         virtual int GetSourceModuleCount () const
         {
           return 3;
@@ -23,6 +23,8 @@
 #ifndef NOISE_MODULE_CACHE_H
 #define NOISE_MODULE_CACHE_H
 
+#include <atomic>
+
 #include "modulebase.h"
 
 namespace noise
@@ -41,23 +43,34 @@ namespace noise
     /// @addtogroup miscmodules
     /// @{
 
-    /// Noise module that caches the last output value generated by a source
-    /// module.
+    /// Noise module that caches the last output values generated by a
+    /// source module.
     ///
     /// If an application passes an input value to the GetValue() method that
-    /// differs from the previously passed-in input value, this noise module
+    /// differs from the last few passed-in input values, this noise module
     /// instructs the source module to calculate the output value.  This
     /// value, as well as the ( @a x, @a y, @a z ) coordinates of the input
-    /// value, are stored (cached) in this noise module.
+    /// value, are stored (cached) in this noise module, replacing the oldest
+    /// cached value.
     ///
     /// If the application passes an input value to the GetValue() method
-    /// that is equal to the previously passed-in input value, this noise
-    /// module returns the cached output value without having the source
-    /// module recalculate the output value.
+    /// that is equal to one of the last four passed-in input values, this
+    /// noise module returns the cached output value without having the
+    /// source module recalculate the output value.  Consumers that
+    /// interleave their calls (such as a noise::module::Turbulence module
+    /// and another noise module sharing the same source) therefore still
+    /// find their values.  GetReuseCount() returns how many values were
+    /// found this way.
     ///
     /// If an application passes a new source module to the SetSourceModule()
     /// method, the cache is invalidated.
     ///
+    /// Each thread has its own cached input and output values, so one Cache
+    /// noise module can be evaluated from several threads at once.  They are
+    /// kept in a small per-thread table indexed by an identifier of the
+    /// noise module; two Cache noise modules sharing a set of entries only
+    /// evict each other.
+    ///
     /// Caching a noise module is useful if it is used as a source module for
     /// multiple noise modules.  If a source module is not cached, the source
     /// module will redundantly calculate the same output value once for each
@@ -72,6 +85,28 @@ namespace noise
         /// Constructor.
         Cache ();
 
+        virtual void GetRange (double xMin, double yMin, double zMin,
+          double xMax, double yMax, double zMax, double& lower,
+          double& upper) const;
+
+        /// Returns the number of output values that this noise module
+        /// returned from its cache.
+        ///
+        /// @returns The number of cached output values returned since the
+        /// noise module was created or since the last call to
+        /// ResetReuseCount().
+        ///
+        /// Each of them is an evaluation of the source module that was
+        /// avoided.  The count covers every thread.
+        ///
+        /// The count is only kept in builds without NDEBUG; release builds
+        /// always return zero, so that cache hits from several threads do
+        /// not all write to one shared counter.
+        unsigned long long GetReuseCount () const
+        {
+          return m_reuseCount.load (std::memory_order_relaxed);
+        }
+
         virtual int GetSourceModuleCount () const
         {
           return 1;
@@ -79,29 +114,27 @@ namespace noise
 
         virtual double GetValue (double x, double y, double z) const;
 
-        virtual void SetSourceModule (int index, const Module& sourceModule)
+        virtual void GetValues (const double* x, const double* y,
+          const double* z, double* values, int count) const;
+
+        /// Sets the number of cached output values returned back to zero.
+        ///
+        /// See GetReuseCount().
+        void ResetReuseCount ()
         {
-          Module::SetSourceModule (index, sourceModule);
-          m_isCached = false;
+          m_reuseCount = 0;
         }
 
-      protected:
-
-        /// The cached output value at the cached input value.
-        mutable double m_cachedValue;
+        virtual void SetSourceModule (int index, const Module& sourceModule);
 
-        /// Determines if a cached output value is stored in this noise
-        /// module.
-        mutable double m_isCached;
-
-        /// @a x coordinate of the cached input value.
-        mutable double m_xCache;
+      protected:
 
-        /// @a y coordinate of the cached input value.
-        mutable double m_yCache;
+        /// Identifies the cached values of this noise module in the table
+        /// of each thread.  A new identifier invalidates them all.
+        unsigned long long m_cacheId;
 
-        /// @a z coordinate of the cached input value.
-        mutable double m_zCache;
+        /// Number of output values returned from the cache.
+        mutable std::atomic<unsigned long long> m_reuseCount;
 
     };
 
@@ -92,6 +92,10 @@ namespace noise
           return m_lowerBound;
         }
 
+        virtual void GetRange (double xMin, double yMin, double zMin,
+          double xMax, double yMax, double zMax, double& lower,
+          double& upper) const;
+
         virtual int GetSourceModuleCount () const
         {
           return 1;
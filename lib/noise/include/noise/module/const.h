@@ -73,6 +73,14 @@ namespace noise
           return m_constValue;
         }
 
+        virtual void GetRange (double /*xMin*/, double /*yMin*/,
+          double /*zMin*/, double /*xMax*/, double /*yMax*/, double /*zMax*/,
+          double& lower, double& upper) const
+        {
+          lower = m_constValue;
+          upper = m_constValue;
+        }
+
         virtual int GetSourceModuleCount () const
         {
           return 0;
@@ -29,6 +29,7 @@
 #include "../basictypes.h"
 #include "../exception.h"
 #include "../noisegen.h"
+#include "../range.h"
 
 namespace noise
 {
@@ -43,6 +44,11 @@ namespace noise
     /// @addtogroup modules
     /// @{
 
+    /// Number of input values that the GetValues() implementations process
+    /// at a time.  Their intermediate arrays have this size and live on the
+    /// stack, so one module can be evaluated from several threads.
+    const int MODULE_BATCH_SIZE = 64;
+
     /// Abstract base class for noise modules.
     ///
     /// A <i>noise module</i> is an object that calculates and outputs a value
@@ -209,6 +215,10 @@ namespace noise
     /// referenced in the protected @a m_pSourceModule array, mathematically
     /// combine those values, and return the combined value.
     ///
+    /// Optionally override the GetValues() virtual method to generate many
+    /// output values per call.  It must return exactly what GetValue() would
+    /// for each input value.
+    ///
     /// When developing a noise module, you must ensure that your noise module
     /// does not modify any source module or control module connected to it; a
     /// noise module can only modify the output value from those source
@@ -231,6 +241,39 @@ namespace noise
         /// Destructor.
         virtual ~Module ();
 
+        /// Returns a range that contains every output value generated from
+        /// the input values inside a box.
+        ///
+        /// @param xMin The lower @a x coordinate of the box.
+        /// @param yMin The lower @a y coordinate of the box.
+        /// @param zMin The lower @a z coordinate of the box.
+        /// @param xMax The upper @a x coordinate of the box.
+        /// @param yMax The upper @a y coordinate of the box.
+        /// @param zMax The upper @a z coordinate of the box.
+        /// @param lower Receives the lower bound of the output values.
+        /// @param upper Receives the upper bound of the output values.
+        ///
+        /// @pre All source modules required by this noise module have been
+        /// passed to the SetSourceModule() method.
+        /// @pre Each lower coordinate is less than or equal to the matching
+        /// upper coordinate.
+        ///
+        /// The range is conservative: GetValue() never returns a value
+        /// outside of it for an input value inside the box (bounds
+        /// included), but the range may be wider than the output values.
+        /// Noise modules use it to skip work that cannot affect their
+        /// output values, such as the source module of a
+        /// noise::module::Select module that the control module never
+        /// selects.
+        ///
+        /// The default implementation returns an unbounded range ( -HUGE_VAL
+        /// to +HUGE_VAL ).  Generators and modules with a simple range
+        /// override it; see the noise::GetProductRange() family for the
+        /// interval arithmetic they share.
+        virtual void GetRange (double xMin, double yMin, double zMin,
+          double xMax, double yMax, double zMax, double& lower, double& upper)
+          const;
+
         /// Returns a reference to a source module connected to this noise
         /// module.
         ///
@@ -295,6 +338,27 @@ namespace noise
         /// module, call the GetSourceModuleCount() method.
         virtual double GetValue (double x, double y, double z) const = 0;
 
+        /// Generates the output values for an array of input values.
+        ///
+        /// @param x The @a x coordinates of the input values.
+        /// @param y The @a y coordinates of the input values.
+        /// @param z The @a z coordinates of the input values.
+        /// @param values The array that receives the output values.
+        /// @param count The number of input values.
+        ///
+        /// @pre All source modules required by this noise module have been
+        /// passed to the SetSourceModule() method.
+        /// @pre The @a values array does not overlap any coordinate array.
+        ///
+        /// Each output value is the value that GetValue() returns for the
+        /// same coordinates.  The default implementation calls GetValue()
+        /// once per input value; noise modules override it to evaluate the
+        /// whole array with one virtual call, usually by passing the array
+        /// on to their source modules and running each octave over all of
+        /// the input values at once.
+        virtual void GetValues (const double* x, const double* y,
+          const double* z, double* values, int count) const;
+
         /// Connects a source module to this noise module.
         ///
         /// @param index An index value to assign to this source module.
@@ -348,7 +412,7 @@ namespace noise
         /// This restriction is necessary because if this object was copied,
         /// all source modules assigned to this noise module would need to be
         /// copied as well.
-        const Module& operator= (const Module& m)
+        const Module& operator= (const Module&)
         {
           return *this;
         }
@@ -0,0 +1,302 @@
+// program.h
+//
+// This library is free software; you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation; either version 2.1 of the License, or (at
+// your option) any later version.
+//
+// This library is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+// License (COPYING.txt) for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this library; if not, write to the Free Software Foundation,
+// Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+
+#ifndef NOISE_MODULE_PROGRAM_H
+#define NOISE_MODULE_PROGRAM_H
+
+#include <atomic>
+#include <vector>
+
+#include "modulebase.h"
+
+namespace noise
+{
+
+  namespace module
+  {
+
+    /// @addtogroup libnoise
+    /// @{
+
+    /// @addtogroup modules
+    /// @{
+
+    /// @addtogroup miscmodules
+    /// @{
+
+    /// Noise module that evaluates a module graph compiled into a flat
+    /// program.
+    ///
+    /// The Compile() method walks the graph below a source module and emits
+    /// a list of instructions over numbered registers; each register holds
+    /// one value (or one coordinate) for a block of up to
+    /// noise::module::MODULE_BATCH_SIZE input values.  GetValues() then runs
+    /// every instruction over a whole block before the next one, instead of
+    /// descending the graph through a virtual call per noise module.
+    ///
+    /// While compiling:
+    /// - Chains of noise::module::ScaleBias and noise::module::Clamp modules
+    ///   become one instruction, and so do chains of
+    ///   noise::module::ScalePoint and noise::module::TranslatePoint modules.
+    ///   The instruction applies the folded steps one after the other, in the
+    ///   same order as the graph, so the output values do not change.
+    /// - A noise module that is reached more than once with the same input
+    ///   values (a subgraph shared by several noise modules) is evaluated
+    ///   once and its register is reused.  A chain is not folded through
+    ///   a shared noise module.  The source modules of a noise module that
+    ///   lead to a noise::module::Select module are compiled after the
+    ///   others, so that a noise module shared with them is read from the
+    ///   enclosing block rather than evaluated again in a Select block.
+    /// - noise::module::Cache modules are skipped, since the reuse above
+    ///   already covers them.
+    /// - The source modules and the control module of a
+    ///   noise::module::Select module are compiled into separate blocks of
+    ///   instructions, which only run on the input values that need them.
+    ///   The control block is skipped where
+    ///   noise::module::Select::GetRangeSelection() already decides the
+    ///   selection.
+    /// - noise::module::Turbulence becomes an instruction that displaces the
+    ///   coordinate registers.
+    /// - noise::module::Add, noise::module::Multiply, noise::module::Max,
+    ///   noise::module::Min, noise::module::Abs, noise::module::Invert,
+    ///   noise::module::Blend and noise::module::Const become their own
+    ///   instructions.
+    /// - Any other noise module, including the generators, is called
+    ///   through its GetValues() method on the coordinate registers.
+    ///
+    /// The output values are bit-for-bit the values that the source module
+    /// returns.  The program stores the parameters of the modifier and
+    /// combiner modules that it folds, and pointers to every other noise
+    /// module; call Compile() again after changing the graph or the
+    /// parameters of a folded module.  The generators may still be changed
+    /// after compiling.
+    ///
+    /// GetValues() keeps its registers on the caller's side, so a program
+    /// may be evaluated by several threads at once if the noise modules
+    /// that it calls may.
+    ///
+    /// This noise module requires one source module, which Compile() sets.
+    class Program: public Module
+    {
+
+      public:
+
+        /// Constructor.
+        Program ();
+
+        /// Compiles a module graph.
+        ///
+        /// @param sourceModule The noise module at the root of the graph.
+        ///
+        /// @throw noise::ExceptionNoModule A noise module in the graph is
+        /// missing a source module.
+        ///
+        /// This method also connects @a sourceModule as the source module of
+        /// this noise module.
+        void Compile (const Module& sourceModule);
+
+        /// Returns the number of instructions in the compiled program.
+        ///
+        /// @returns The number of instructions, over all blocks.
+        int GetInstructionCount () const;
+
+        virtual void GetRange (double xMin, double yMin, double zMin,
+          double xMax, double yMax, double zMax, double& lower,
+          double& upper) const;
+
+        /// Returns the number of output values that the program reused
+        /// instead of calculating them again.
+        ///
+        /// @returns The number of reused output values since the last call
+        /// to Compile() or ResetReuseCount().
+        ///
+        /// Each time a block reads the output value of a shared noise module
+        /// from a register, instead of evaluating the noise module again,
+        /// counts once per input value.  The count covers every thread that
+        /// evaluates the program.
+        ///
+        /// The count is only kept in builds without NDEBUG; release builds
+        /// always return zero, so that the threads evaluating the program do
+        /// not all write to one shared counter on every block run.
+        unsigned long long GetReuseCount () const
+        {
+          return m_reuseCount.load (std::memory_order_relaxed);
+        }
+
+        /// Returns the number of registers used by the compiled program.
+        ///
+        /// @returns The number of registers, over all blocks.
+        int GetRegisterCount () const
+        {
+          return m_registerCount;
+        }
+
+        /// Returns the number of times the compiled program reads the
+        /// output value of a shared noise module from a register.
+        ///
+        /// @returns The number of reused registers, over all blocks.
+        ///
+        /// Each of them replaces an evaluation of the noise module (and of
+        /// its source modules) for every input value of its block.
+        int GetSharedValueCount () const;
+
+        virtual int GetSourceModuleCount () const
+        {
+          return 1;
+        }
+
+        virtual double GetValue (double x, double y, double z) const;
+
+        virtual void GetValues (const double* x, const double* y,
+          const double* z, double* values, int count) const;
+
+        /// Sets the number of reused output values back to zero.
+        ///
+        /// See GetReuseCount().
+        void ResetReuseCount ()
+        {
+          m_reuseCount = 0;
+        }
+
+        /// Connects a source module to this noise module and compiles it.
+        ///
+        /// Same as Compile().
+        virtual void SetSourceModule (int index, const Module& sourceModule);
+
+      protected:
+
+        /// Operations of the instructions.
+        enum Opcode
+        {
+          /// Calls GetValues() of a noise module.
+          OP_MODULE,
+          /// Fills a register with a constant.
+          OP_CONST,
+          /// Applies folded ScaleBias and Clamp steps to a register.
+          OP_AFFINE,
+          /// Applies folded ScalePoint and TranslatePoint steps to the
+          /// coordinate registers.
+          OP_TRANSFORM,
+          /// Displaces the coordinate registers like a Turbulence module.
+          OP_TURBULENCE,
+          OP_ABS,
+          OP_INVERT,
+          OP_ADD,
+          OP_MULTIPLY,
+          OP_MAX,
+          OP_MIN,
+          OP_BLEND,
+          /// Selects between two registers or two blocks like a Select
+          /// module.
+          OP_SELECT
+        };
+
+        /// Kinds of folded steps.
+        enum StepType
+        {
+          STEP_SCALE_BIAS,
+          STEP_CLAMP,
+          STEP_SCALE_POINT,
+          STEP_TRANSLATE_POINT
+        };
+
+        /// A folded ScaleBias, Clamp, ScalePoint or TranslatePoint module.
+        struct Step
+        {
+          StepType type;
+          /// (scale, bias), (lower bound, upper bound), or the ( @a x,
+          /// @a y, @a z ) scale or translation.
+          double param[3];
+        };
+
+        /// One instruction of a block.
+        struct Instruction
+        {
+          Opcode opcode;
+          /// Register that receives the output value; for OP_TRANSFORM and
+          /// OP_TURBULENCE, the first of three coordinate registers.
+          int dest;
+          /// Registers of the input values.
+          int source[3];
+          /// First of the three coordinate registers that are read.
+          int coords;
+          /// Noise module called by OP_MODULE and OP_TURBULENCE, and the
+          /// noise::module::Select module of OP_SELECT.
+          const Module* pModule;
+          /// Steps of OP_AFFINE and OP_TRANSFORM, in the order they apply.
+          std::vector<Step> steps;
+          /// OP_CONST: the value.  OP_SELECT: the lower bound, the upper
+          /// bound and the edge falloff.
+          double param[3];
+          /// Blocks of the two source modules and of the control module of
+          /// OP_SELECT, or -1 if the value is already in the matching
+          /// source register.
+          int branch[3];
+        };
+
+        /// A list of instructions that runs on one set of input values.
+        /// Registers 0, 1 and 2 of a block hold the coordinates of its
+        /// input values.
+        struct Block
+        {
+          std::vector<Instruction> code;
+          /// First register of this block in the register file.
+          int registerBase;
+          /// Number of registers of this block.
+          int registerCount;
+          /// Register that holds the output value.
+          int result;
+          /// Number of registers that the block reads instead of evaluating
+          /// a noise module again.
+          int reuseCount;
+        };
+
+        struct Compiler;
+
+        /// Runs a block over the input values already in its coordinate
+        /// registers.
+        void Run (int blockIndex, double* registers, int count) const;
+
+        /// Runs a block over the input values listed in @a indices and
+        /// scatters its output values into @a values (indexed like the
+        /// input values).
+        void RunSelected (int blockIndex, double* registers, const double* x,
+          const double* y, const double* z, const int* indices, int count,
+          double* values) const;
+
+        /// Blocks of the program; block 0 evaluates the source module.
+        std::vector<Block> m_blocks;
+
+        /// Total number of registers of all blocks.
+        int m_registerCount;
+
+        /// Number of output values reused by GetValues().
+        mutable std::atomic<unsigned long long> m_reuseCount;
+
+    };
+
+    /// @}
+
+    /// @}
+
+    /// @}
+
+  }
+
+}
+
+#endif
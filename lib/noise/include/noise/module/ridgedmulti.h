@@ -188,6 +188,21 @@ namespace noise
           return m_octaveCount;
         }
 
+        /// Returns the period of the ridged-multifractal noise.
+        ///
+        /// @returns The period of the first octave, in lattice cells, or 0
+        /// if the ridged-multifractal noise does not repeat.
+        ///
+        /// See SetPeriod().
+        int GetPeriod () const
+        {
+          return m_period;
+        }
+
+        virtual void GetRange (double xMin, double yMin, double zMin,
+          double xMax, double yMax, double zMax, double& lower,
+          double& upper) const;
+
         /// Returns the seed value used by the ridged-multifractal-noise
         /// function.
         ///
@@ -204,6 +219,9 @@ namespace noise
 
         virtual double GetValue (double x, double y, double z) const;
 
+        virtual void GetValues (const double* x, const double* y,
+          const double* z, double* values, int count) const;
+
         /// Sets the frequency of the first octave.
         ///
         /// @param frequency The frequency of the first octave.
@@ -263,6 +281,32 @@ namespace noise
           m_octaveCount = octaveCount;
         }
 
+        /// Sets the period of the ridged-multifractal noise.
+        ///
+        /// @param period The period of the first octave, in lattice cells,
+        /// or 0 to disable periodic noise.
+        ///
+        /// @pre The period ranges from 0 to 1073741824.
+        ///
+        /// @throw noise::ExceptionInvalidParam An invalid parameter was
+        /// specified; see the preconditions for more information.
+        ///
+        /// A periodic ridged-multifractal noise repeats every @a period / frequency units
+        /// along each axis, so a noise map that covers exactly one period
+        /// tiles without seams.  The period of each following octave is
+        /// the period of the previous one times the lacunarity, rounded to
+        /// a whole number of lattice cells; that octave's frequency is
+        /// adjusted by the same rounding (see MakeIntPeriod()).  A
+        /// periodic ridged-multifractal noise is therefore not identical to the
+        /// non-periodic one, unless the lacunarity is an integer.
+        void SetPeriod (int period)
+        {
+          if (period < 0 || period > 1073741824) {
+            throw noise::ExceptionInvalidParam ();
+          }
+          m_period = period;
+        }
+
         /// Sets the seed value used by the ridged-multifractal-noise
         /// function.
         ///
@@ -295,6 +339,10 @@ namespace noise
         /// Contains the spectral weights for each octave.
         double m_pSpectralWeights[RIDGED_MAX_OCTAVE];
 
+        /// Period of the first octave, in lattice cells; 0 if the
+        /// ridged-multifractal noise does not repeat.
+        int m_period;
+
         /// Seed value used by the ridged-multfractal-noise function.
         int m_seed;
 
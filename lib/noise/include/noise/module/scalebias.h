@@ -81,6 +81,10 @@ namespace noise
           return m_bias;
         }
 
+        virtual void GetRange (double xMin, double yMin, double zMin,
+          double xMax, double yMax, double zMax, double& lower,
+          double& upper) const;
+
         /// Returns the scaling factor to apply to the output value from the
         /// source module.
         ///
@@ -101,6 +105,9 @@ namespace noise
 
         virtual double GetValue (double x, double y, double z) const;
 
+        virtual void GetValues (const double* x, const double* y,
+          const double* z, double* values, int count) const;
+
         /// Sets the bias to apply to the scaled output value from the source
         /// module.
         ///
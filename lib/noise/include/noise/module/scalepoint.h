@@ -82,6 +82,10 @@ namespace noise
         /// to noise::module::DEFAULT_SCALE_POINT_Z.
         ScalePoint ();
 
+        virtual void GetRange (double xMin, double yMin, double zMin,
+          double xMax, double yMax, double zMax, double& lower,
+          double& upper) const;
+
         virtual int GetSourceModuleCount () const
         {
           return 1;
@@ -51,6 +51,10 @@ namespace noise
     /// noise::module::Select noise module.
     const double DEFAULT_SELECT_UPPER_BOUND = 1.0;
 
+    /// Smallest number of input values that GetRangeSelection() splits
+    /// further.
+    const int SELECT_RANGE_SPLIT_COUNT = 16;
+
     /// Noise module that outputs the value selected from one of two source
     /// modules chosen by the output value from a control module.
     ///
@@ -80,6 +84,12 @@ namespace noise
     /// smooth the transition, pass a non-zero value to the SetEdgeFalloff()
     /// method.  Higher values result in a smoother transition.
     ///
+    /// When it generates many output values at once, this noise module
+    /// first bounds the control module over the input values (see
+    /// GetRangeSelection()); where the bounds already decide the selection,
+    /// neither the control module nor the unselected source module is
+    /// evaluated.
+    ///
     /// This noise module requires three source modules.
     class Select: public Module
     {
@@ -150,6 +160,38 @@ namespace noise
           return m_lowerBound;
         }
 
+        virtual void GetRange (double xMin, double yMin, double zMin,
+          double xMax, double yMax, double zMax, double& lower,
+          double& upper) const;
+
+        /// Selects the source module of input values from the range of the
+        /// control module alone.
+        ///
+        /// @param x The @a x coordinates of the input values.
+        /// @param y The @a y coordinates of the input values.
+        /// @param z The @a z coordinates of the input values.
+        /// @param sources The array that receives, for each input value, the
+        /// index value of the source module whose output value this noise
+        /// module outputs there (0 or 1), or -1 if that depends on the
+        /// output value from the control module.
+        /// @param count The number of input values.
+        ///
+        /// @returns The number of input values that received -1.
+        ///
+        /// @pre All source modules required by this noise module have been
+        /// passed to the SetSourceModule() method.
+        ///
+        /// The input values are split in halves, hierarchically, until the
+        /// range of the control module over the bounding box of a part (see
+        /// Module::GetRange()) falls entirely below, inside, or above the
+        /// selection range and its edge falloff, or until the part is
+        /// smaller than noise::module::SELECT_RANGE_SPLIT_COUNT input
+        /// values.  The bounding boxes are only small when neighbouring
+        /// input values are next to each other in the arrays, as in the rows
+        /// of a noise map.
+        int GetRangeSelection (const double* x, const double* y,
+          const double* z, int* sources, int count) const;
+
         virtual int GetSourceModuleCount () const
         {
           return 3;
@@ -170,6 +212,9 @@ namespace noise
 
         virtual double GetValue (double x, double y, double z) const;
 
+        virtual void GetValues (const double* x, const double* y,
+          const double* z, double* values, int count) const;
+
         /// Sets the lower and upper bounds of the selection range.
         ///
         /// @param lowerBound The lower bound.
@@ -243,6 +288,30 @@ namespace noise
 
       protected:
 
+        /// Returns true if a part of a box over which the control module
+        /// ranges from @a controlLower to @a controlUpper may still select a
+        /// source module with SelectSource().
+        ///
+        /// @param controlLower The lower bound of the control value.
+        /// @param controlUpper The upper bound of the control value.
+        ///
+        /// @returns false if every part of the box reaches into the edge
+        /// falloff, so GetRangeSelection() does not split it further.
+        bool IsSourceSelectable (double controlLower, double controlUpper)
+          const;
+
+        /// Returns the source module selected over a range of output values
+        /// from the control module.
+        ///
+        /// @param controlLower The lower bound of the control value.
+        /// @param controlUpper The upper bound of the control value.
+        ///
+        /// @returns The index value of the source module whose output value
+        /// this noise module outputs for every control value in the range,
+        /// or -1 if the range reaches into the edge falloff or spans
+        /// several cases.
+        int SelectSource (double controlLower, double controlUpper) const;
+
         /// Edge-falloff value.
         double m_edgeFalloff;
 
@@ -40,6 +40,10 @@ namespace noise
     /// @addtogroup transformermodules
     /// @{
 
+    /// Default resolution of the displacement field for the
+    /// noise::module::Turbulence noise module.
+    const int DEFAULT_TURBULENCE_FIELD_RESOLUTION = 0;
+
     /// Default frequency for the noise::module::Turbulence noise module.
     const double DEFAULT_TURBULENCE_FREQUENCY = DEFAULT_PERLIN_FREQUENCY;
 
@@ -109,6 +113,11 @@ namespace noise
     /// that displace the input value; one for the @a x, one for the @a y,
     /// and one for the @a z coordinate.
     ///
+    /// Evaluating them costs about three times as much as a
+    /// noise::module::Perlin source module.  Since the displacement changes
+    /// slowly, an application can instead have it calculated on a grid and
+    /// interpolated between the grid points; see SetFieldResolution().
+    ///
     /// This noise module requires one source module.
     class Turbulence: public Module
     {
@@ -128,8 +137,46 @@ namespace noise
         ///
         /// The default seed value is set to
         /// noise::module::DEFAULT_TURBULENCE_SEED.
+        ///
+        /// The default resolution of the displacement field is set to
+        /// noise::module::DEFAULT_TURBULENCE_FIELD_RESOLUTION.
         Turbulence ();
 
+        /// Displaces an array of input values.
+        ///
+        /// @param x The @a x coordinates of the input values.
+        /// @param y The @a y coordinates of the input values.
+        /// @param z The @a z coordinates of the input values.
+        /// @param xDistort The array that receives the displaced @a x
+        /// coordinates.
+        /// @param yDistort The array that receives the displaced @a y
+        /// coordinates.
+        /// @param zDistort The array that receives the displaced @a z
+        /// coordinates.
+        /// @param count The number of input values.
+        ///
+        /// @pre The output arrays do not overlap any coordinate array.
+        ///
+        /// The displaced coordinates are the ones at which GetValue() and
+        /// GetValues() evaluate the source module.  This lets a caller that
+        /// evaluates the source module itself, such as
+        /// noise::module::Program, apply the same turbulence.
+        void Displace (const double* x, const double* y, const double* z,
+          double* xDistort, double* yDistort, double* zDistort,
+          int count) const;
+
+        /// Returns the resolution of the displacement field.
+        ///
+        /// @returns The number of grid points per wavelength of the highest
+        /// octave of the displacement, or 0 if the displacement is
+        /// calculated for every input value.
+        ///
+        /// See SetFieldResolution().
+        int GetFieldResolution () const
+        {
+          return m_fieldResolution;
+        }
+
         /// Returns the frequency of the turbulence.
         ///
         /// @returns The frequency of the turbulence.
@@ -138,6 +185,17 @@ namespace noise
         /// displacement amount changes.
         double GetFrequency () const;
 
+        /// Returns the period of the turbulence.
+        ///
+        /// @returns The period of the internal Perlin-noise modules, in
+        /// lattice cells, or 0 if the turbulence does not repeat.
+        ///
+        /// See SetPeriod().
+        int GetPeriod () const
+        {
+          return m_xDistortModule.GetPeriod ();
+        }
+
         /// Returns the power of the turbulence.
         ///
         /// @returns The power of the turbulence.
@@ -149,6 +207,10 @@ namespace noise
           return m_power;
         }
 
+        virtual void GetRange (double xMin, double yMin, double zMin,
+          double xMax, double yMax, double zMax, double& lower,
+          double& upper) const;
+
         /// Returns the roughness of the turbulence.
         ///
         /// @returns The roughness of the turbulence.
@@ -179,6 +241,9 @@ namespace noise
 
         virtual double GetValue (double x, double y, double z) const;
 
+        virtual void GetValues (const double* x, const double* y,
+          const double* z, double* values, int count) const;
+
         /// Sets the frequency of the turbulence.
         ///
         /// @param frequency The frequency of the turbulence.
@@ -191,6 +256,67 @@ namespace noise
           m_xDistortModule.SetFrequency (frequency);
           m_yDistortModule.SetFrequency (frequency);
           m_zDistortModule.SetFrequency (frequency);
+          ResetField ();
+        }
+
+        /// Sets the resolution of the displacement field.
+        ///
+        /// @param resolution The number of grid points per wavelength of the
+        /// highest octave of the displacement, or 0 to calculate the
+        /// displacement for every input value.
+        ///
+        /// @pre The resolution is not negative.
+        ///
+        /// @throw noise::ExceptionInvalidParam An invalid parameter was
+        /// specified; see the preconditions for more information.
+        ///
+        /// With a positive resolution, the displacement is calculated on the
+        /// points of a grid with a spacing of 1 / (@a frequency *
+        /// 2^(@a roughness - 1) * @a resolution) along each axis, and
+        /// interpolated between them with Catmull-Rom splines.  Each thread
+        /// keeps the last grid points that it calculated, so neighboring
+        /// input values (such as the rows of a noise map) share them.  An
+        /// input value on a plane of the grid, such as the @a y = 0 plane
+        /// of noise::utils::NoiseMapBuilderPlane, only reads the grid
+        /// points of that plane.
+        ///
+        /// Since the grid follows the frequency and the roughness, the error
+        /// of the displaced coordinates only depends on the resolution and
+        /// the power; it shrinks about four times each time the resolution
+        /// doubles.  The largest errors measured along an axis, for
+        /// roughness values from 1 to 5 and frequencies from 0.5 to 4, are:
+        /// - resolution 1: 1.6 * @a power
+        /// - resolution 2: 0.4 * @a power
+        /// - resolution 4: 0.09 * @a power
+        /// - resolution 8: 0.025 * @a power
+        /// - resolution 16: 0.005 * @a power
+        ///
+        /// A periodic turbulence (see SetPeriod()) stays periodic, since the
+        /// grid divides the period.  Input values beyond about 2^30 grid
+        /// points from the origin fall back to the exact displacement.
+        void SetFieldResolution (int resolution);
+
+        /// Sets the period of the turbulence.
+        ///
+        /// @param period The period of the internal Perlin-noise modules, in
+        /// lattice cells, or 0 to disable periodic turbulence.
+        ///
+        /// @pre The period ranges from 0 to 1073741824.
+        ///
+        /// @throw noise::ExceptionInvalidParam An invalid parameter was
+        /// specified; see the preconditions for more information.
+        ///
+        /// The displacement then repeats every @a period / frequency units
+        /// along each axis (see noise::module::Perlin::SetPeriod()).  The
+        /// output of this noise module only repeats if the source module
+        /// repeats with the same period.
+        void SetPeriod (int period)
+        {
+          // Set the period of each Perlin-noise module.
+          m_xDistortModule.SetPeriod (period);
+          m_yDistortModule.SetPeriod (period);
+          m_zDistortModule.SetPeriod (period);
+          ResetField ();
         }
 
         /// Sets the power of the turbulence.
@@ -224,6 +350,7 @@ namespace noise
           m_xDistortModule.SetOctaveCount (roughness);
           m_yDistortModule.SetOctaveCount (roughness);
           m_zDistortModule.SetOctaveCount (roughness);
+          ResetField ();
         }
 
         /// Sets the seed value of the internal noise modules that are used to
@@ -242,6 +369,38 @@ namespace noise
 
       protected:
 
+        /// Calculates the exact displacement of one input value.
+        void GetExactDisplacement (double x, double y, double z,
+          double* displacement) const;
+
+        /// Interpolates the displacement of up to
+        /// noise::module::MODULE_BATCH_SIZE input values from the
+        /// displacement field.
+        void GetFieldDisplacement (const double* x, const double* y,
+          const double* z, double* xDisplace, double* yDisplace,
+          double* zDisplace, int count) const;
+
+        /// Returns the displacement at a point of the displacement field.
+        ///
+        /// The value comes from the grid points kept by the current thread,
+        /// or is calculated and kept there.
+        const double* GetFieldNode (int ix, int iy, int iz) const;
+
+        /// Returns the spacing of the displacement field.
+        double GetFieldSpacing () const;
+
+        /// Discards the grid points that every thread keeps for this noise
+        /// module, after a parameter of the displacement changed.
+        void ResetField ();
+
+        /// Identifies the grid points of this noise module in the table of
+        /// each thread.
+        unsigned long long m_fieldId;
+
+        /// Resolution of the displacement field, or 0 to calculate the
+        /// displacement for every input value.
+        int m_fieldResolution;
+
         /// The power (scale) of the displacement.
         double m_power;
 
@@ -52,6 +52,11 @@ namespace noise
     /// noise module.
     const int DEFAULT_VORONOI_SEED = 0;
 
+    /// Largest number of unit cubes whose seed points the
+    /// noise::module::Voronoi noise module calculates at once for a batch of
+    /// input values.
+    const int VORONOI_BOX_CELL_COUNT = 512;
+
     /// Noise module that outputs Voronoi cells.
     ///
     /// @image html modulevoronoi.png
@@ -86,6 +91,14 @@ namespace noise
     /// Voronoi cells are often used to generate cracked-mud terrain
     /// formations or crystal-like textures
     ///
+    /// GetValues() calculates the seed points around a batch of input
+    /// values once, and each input value skips the layers and rows of cubes
+    /// that cannot hold a seed point closer than the nearest one found so
+    /// far; input values on a plane, such as the @a y = 0 plane of
+    /// noise::utils::NoiseMapBuilderPlane, mostly search the layers of
+    /// cubes next to that plane.  The output values are the same as those
+    /// of GetValue().
+    ///
     /// This noise module requires no source modules.
     class Voronoi: public Module
     {
@@ -145,11 +158,25 @@ namespace noise
           return m_frequency;
         }
 
+        virtual void GetRange (double xMin, double yMin, double zMin,
+          double xMax, double yMax, double zMax, double& lower,
+          double& upper) const;
+
         virtual int GetSourceModuleCount () const
         {
           return 0;
         }
 
+        /// Returns the period of the Voronoi cells.
+        ///
+        /// @returns The period, in cells, or 0 if the cells do not repeat.
+        ///
+        /// See SetPeriod().
+        int GetPeriod () const
+        {
+          return m_period;
+        }
+
         /// Returns the seed value used by the Voronoi cells
         ///
         /// @returns The seed value.
@@ -179,6 +206,9 @@ namespace noise
 
         virtual double GetValue (double x, double y, double z) const;
 
+        virtual void GetValues (const double* x, const double* y,
+          const double* z, double* values, int count) const;
+
         /// Sets the displacement value of the Voronoi cells.
         ///
         /// @param displacement The displacement value of the Voronoi cells.
@@ -203,6 +233,29 @@ namespace noise
           m_frequency = frequency;
         }
 
+        /// Sets the period of the Voronoi cells.
+        ///
+        /// @param period The period, in cells, or 0 to disable periodic
+        /// cells.
+        ///
+        /// @pre The period ranges from 0 to 1073741824.
+        ///
+        /// @throw noise::ExceptionInvalidParam An invalid parameter was
+        /// specified; see the preconditions for more information.
+        ///
+        /// With a period, the seed point and the value of each cell come
+        /// from its cell coordinates modulo the period, so the cells repeat
+        /// every @a period / frequency units along each axis.  Inside the
+        /// first period, the cells that are not near its edges are identical
+        /// to the non-periodic ones.
+        void SetPeriod (int period)
+        {
+          if (period < 0 || period > 1073741824) {
+            throw noise::ExceptionInvalidParam ();
+          }
+          m_period = period;
+        }
+
         /// Sets the seed value used by the Voronoi cells
         ///
         /// @param seed The seed value.
@@ -217,6 +270,19 @@ namespace noise
 
       protected:
 
+        struct SeedBox;
+
+        /// Returns the output value at an input value already multiplied by
+        /// the frequency (and moved into the first period).
+        ///
+        /// The seed points come from @a pBox if it is not @a NULL; it then
+        /// holds the cubes around the input value.
+        double GetCellValue (double x, double y, double z,
+          const SeedBox* pBox) const;
+
+        /// Calculates the position of the seed point of a unit cube.
+        void GetSeedPoint (int xCur, int yCur, int zCur, double* pos) const;
+
         /// Scale of the random displacement to apply to each Voronoi cell.
         double m_displacement;
 
@@ -227,6 +293,10 @@ namespace noise
         /// Frequency of the seed points.
         double m_frequency;
 
+        /// Period of the Voronoi cells, in cells; 0 if the cells do not
+        /// repeat.
+        int m_period;
+
         /// Seed value used by the coherent-noise function to determine the
         /// positions of the seed points.
         int m_seed;
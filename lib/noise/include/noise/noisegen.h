@@ -77,6 +77,214 @@ namespace noise
   double GradientCoherentNoise3D (double x, double y, double z, int seed = 0,
     NoiseQuality noiseQuality = QUALITY_STD);
 
+  /// Enumerates the instruction sets that the array version of
+  /// GradientCoherentNoise3D() can use.
+  enum SimdLevel
+  {
+
+    /// Plain C++; one input value at a time.
+    SIMD_NONE = 0,
+
+    /// SSE4.1; two input values at a time.
+    SIMD_SSE41 = 1,
+
+    /// AVX2; four input values at a time.
+    SIMD_AVX2 = 2,
+
+    /// AVX-512F; eight input values at a time.
+    SIMD_AVX512 = 3
+
+  };
+
+  /// Generates gradient-coherent-noise values from the coordinates of an
+  /// array of three-dimensional input values.
+  ///
+  /// @param x The @a x coordinates of the input values.
+  /// @param y The @a y coordinates of the input values.
+  /// @param z The @a z coordinates of the input values.
+  /// @param values The array that receives the generated values.
+  /// @param count The number of input values.
+  /// @param seed The random number seed.
+  /// @param noiseQuality The quality of the coherent-noise.
+  ///
+  /// @pre Each coordinate ranges from -1073741824.0 to +1073741824.0 (see
+  /// MakeInt32Range()).
+  ///
+  /// Each generated value is bit-for-bit the value that the single-value
+  /// version returns for the same input value, at every noise quality.  The
+  /// input values are processed in groups, using the instruction set
+  /// returned by GetSimdLevel().
+  void GradientCoherentNoise3D (const double* x, const double* y,
+    const double* z, double* values, int count, int seed = 0,
+    NoiseQuality noiseQuality = QUALITY_STD);
+
+  /// Generates a gradient-coherent-noise value that repeats every @a period
+  /// units along each axis.
+  ///
+  /// @param x The @a x coordinate of the input value.
+  /// @param y The @a y coordinate of the input value.
+  /// @param z The @a z coordinate of the input value.
+  /// @param period The period of the noise, in lattice cells.
+  /// @param seed The random number seed.
+  /// @param noiseQuality The quality of the coherent-noise.
+  ///
+  /// @returns The generated gradient-coherent-noise value.
+  ///
+  /// @pre The period is at least one.
+  ///
+  /// @pre Each coordinate ranges from 0.0 (inclusive) to @a period
+  /// (exclusive); see MakePeriodicRange().
+  ///
+  /// The lattice coordinates of the unit cube around the input value are
+  /// wrapped into the period before they select a gradient vector, so the
+  /// noise near @a period joins the noise near 0.0 without a seam.  Inside
+  /// cubes that do not wrap, the value is the one that
+  /// GradientCoherentNoise3D() returns.
+  ///
+  /// The return value ranges from -1.0 to +1.0.
+  double PeriodicGradientCoherentNoise3D (double x, double y, double z,
+    int period, int seed = 0, NoiseQuality noiseQuality = QUALITY_STD);
+
+  /// Generates periodic gradient-coherent-noise values from the coordinates
+  /// of an array of three-dimensional input values.
+  ///
+  /// @param x The @a x coordinates of the input values.
+  /// @param y The @a y coordinates of the input values.
+  /// @param z The @a z coordinates of the input values.
+  /// @param values The array that receives the generated values.
+  /// @param count The number of input values.
+  /// @param period The period of the noise, in lattice cells.
+  /// @param seed The random number seed.
+  /// @param noiseQuality The quality of the coherent-noise.
+  ///
+  /// @pre The period is at least one.
+  ///
+  /// @pre Each coordinate ranges from 0.0 (inclusive) to @a period
+  /// (exclusive); see MakePeriodicRange().
+  ///
+  /// Array version of PeriodicGradientCoherentNoise3D(), with the same
+  /// guarantees as the array version of GradientCoherentNoise3D().
+  void PeriodicGradientCoherentNoise3D (const double* x, const double* y,
+    const double* z, double* values, int count, int period, int seed = 0,
+    NoiseQuality noiseQuality = QUALITY_STD);
+
+  /// Returns a range that contains every gradient-coherent-noise value
+  /// generated from the input values inside a box.
+  ///
+  /// @param xMin The lower @a x coordinate of the box.
+  /// @param yMin The lower @a y coordinate of the box.
+  /// @param zMin The lower @a z coordinate of the box.
+  /// @param xMax The upper @a x coordinate of the box.
+  /// @param yMax The upper @a y coordinate of the box.
+  /// @param zMax The upper @a z coordinate of the box.
+  /// @param lower Receives the lower bound of the noise values.
+  /// @param upper Receives the upper bound of the noise values.
+  /// @param seed The random number seed.
+  /// @param noiseQuality The quality of the coherent-noise.
+  ///
+  /// @pre Each lower coordinate is less than or equal to the matching upper
+  /// coordinate.
+  ///
+  /// Inside each unit cube that the box overlaps, the noise value at every
+  /// cube corner is linear in the input value, and the S-curve values are
+  /// bounded by the part of the box inside the cube, so the trilinear
+  /// interpolation is bounded with interval arithmetic.  The range is
+  /// widened by a small margin for rounding errors.  A box that overlaps
+  /// many unit cubes, or that leaves the range of MakeInt32Range(), gets
+  /// the range of the noise over every input value instead.
+  void GradientCoherentNoise3DRange (double xMin, double yMin, double zMin,
+    double xMax, double yMax, double zMax, double& lower, double& upper,
+    int seed = 0, NoiseQuality noiseQuality = QUALITY_STD);
+
+  /// Returns a range that contains every periodic gradient-coherent-noise
+  /// value generated from the input values inside a box.
+  ///
+  /// @param xMin The lower @a x coordinate of the box.
+  /// @param yMin The lower @a y coordinate of the box.
+  /// @param zMin The lower @a z coordinate of the box.
+  /// @param xMax The upper @a x coordinate of the box.
+  /// @param yMax The upper @a y coordinate of the box.
+  /// @param zMax The upper @a z coordinate of the box.
+  /// @param lower Receives the lower bound of the noise values.
+  /// @param upper Receives the upper bound of the noise values.
+  /// @param period The period of the noise, in lattice cells.
+  /// @param seed The random number seed.
+  /// @param noiseQuality The quality of the coherent-noise.
+  ///
+  /// @pre The period is at least one.
+  ///
+  /// @pre Each lower coordinate is less than or equal to the matching upper
+  /// coordinate.
+  ///
+  /// The box does not need to be wrapped into the period: the range covers
+  /// PeriodicGradientCoherentNoise3D() at MakePeriodicRange() of every
+  /// input value inside it.  See GradientCoherentNoise3DRange().
+  void PeriodicGradientCoherentNoise3DRange (double xMin, double yMin,
+    double zMin, double xMax, double yMax, double zMax, double& lower,
+    double& upper, int period, int seed = 0,
+    NoiseQuality noiseQuality = QUALITY_STD);
+
+  /// Returns the best instruction set that this processor and operating
+  /// system support.
+  SimdLevel GetSupportedSimdLevel ();
+
+  /// Returns the instruction set used by the array version of
+  /// GradientCoherentNoise3D().
+  ///
+  /// It is GetSupportedSimdLevel() unless SetSimdLevel() was called.
+  SimdLevel GetSimdLevel ();
+
+  /// Sets the instruction set used by the array version of
+  /// GradientCoherentNoise3D().
+  ///
+  /// @param simdLevel The instruction set to use.  Levels above
+  /// GetSupportedSimdLevel() are lowered to it.
+  ///
+  /// Meant for benchmarks and tests; it is not synchronized with threads
+  /// that are generating noise.
+  void SetSimdLevel (SimdLevel simdLevel);
+
+  /// Enumerates the precisions that GradientCoherentNoise3D() and
+  /// PeriodicGradientCoherentNoise3D() can be calculated in.
+  enum NoisePrecision
+  {
+
+    /// Double precision; the default.
+    PRECISION_DOUBLE = 0,
+
+    /// Single precision.  The lower corner of the unit cube around the
+    /// input value is still found in double precision, and the distance
+    /// from it is rounded to float, so the error does not grow with the
+    /// coordinates: the generated values differ from the double-precision
+    /// ones by about 1.0e-7 on average, and by less than 1.0e-5.  The SIMD
+    /// kernels process twice as many input values at a time.
+    PRECISION_SINGLE = 1
+
+  };
+
+  /// Returns the precision of the gradient-coherent noise generated by the
+  /// calling thread.
+  ///
+  /// It is PRECISION_DOUBLE unless SetNoisePrecision() was called on this
+  /// thread.
+  NoisePrecision GetNoisePrecision ();
+
+  /// Sets the precision of the gradient-coherent noise generated by the
+  /// calling thread.
+  ///
+  /// @param noisePrecision The precision.
+  ///
+  /// Applies to both the single-value and the array versions of
+  /// GradientCoherentNoise3D() and PeriodicGradientCoherentNoise3D(), so
+  /// every noise module built on them follows it; in both precisions each
+  /// array value is bit-for-bit the matching single value.  The ranges
+  /// returned by GradientCoherentNoise3DRange() are widened to cover the
+  /// rounding errors of single precision.  The values are still returned
+  /// as double.  The values kept by the Cache and Turbulence noise modules
+  /// are keyed by precision, so a thread that switches precision never
+  /// reads values generated in the other one.
+  void SetNoisePrecision (NoisePrecision noisePrecision);
+
   /// Generates a gradient-noise value from the coordinates of a
   /// three-dimensional input value and the integer coordinates of a
   /// nearby three-dimensional value.
@@ -166,6 +374,49 @@ namespace noise
     }
   }
 
+  /// Wraps a floating-point value into the range of a periodic
+  /// coherent-noise function.
+  ///
+  /// @param n A floating-point number.
+  /// @param period The period of the noise, in lattice cells.
+  ///
+  /// @returns @a n modulo @a period, from 0.0 (inclusive) to @a period
+  /// (exclusive).
+  ///
+  /// Pass the coordinates to this function before calling
+  /// PeriodicGradientCoherentNoise3D().  A remainder that rounds to either
+  /// end of the range becomes 0.0, which generates the same noise value as
+  /// @a period.
+  inline double MakePeriodicRange (double n, int period)
+  {
+    double p = (double)period;
+    n -= floor (n / p) * p;
+    return (n >= 0.0 && n < p)? n: 0.0;
+  }
+
+  /// Rounds the period of an octave of periodic noise to a whole number of
+  /// lattice cells.
+  ///
+  /// @param period The period of the octave, in lattice cells.
+  ///
+  /// @returns The nearest period from 1 to 1073741824 (see
+  /// MakeInt32Range()).
+  ///
+  /// The octaves of a periodic noise module multiply the period of the
+  /// first octave by the lacunarity, which is rarely an integer.  Each
+  /// octave then scales its input by the rounded period divided by the
+  /// exact one, so that all octaves repeat at the same input coordinate.
+  inline int MakeIntPeriod (double period)
+  {
+    if (period >= 1073741824.0) {
+      return 1073741824;
+    } else if (period < 1.5) {
+      return 1;
+    } else {
+      return (int)floor (period + 0.5);
+    }
+  }
+
   /// Generates a value-coherent-noise value from the coordinates of a
   /// three-dimensional input value.
   ///
@@ -0,0 +1,140 @@
+// range.h
+//
+// This library is free software; you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation; either version 2.1 of the License, or (at
+// your option) any later version.
+//
+// This library is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+// License (COPYING.txt) for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this library; if not, write to the Free Software Foundation,
+// Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+
+#ifndef NOISE_RANGE_H
+#define NOISE_RANGE_H
+
+#include "interp.h"
+#include "misc.h"
+
+namespace noise
+{
+
+  /// @addtogroup libnoise
+  /// @{
+
+  // Multiplies two bounds of a range.  A bound of zero cancels an infinite
+  // bound, since a range of exactly zero stays zero whatever it multiplies.
+  inline double MultiplyRangeBound (double a, double b)
+  {
+    return (a == 0.0 || b == 0.0)? 0.0: a * b;
+  }
+
+  // LinearInterp() of two bounds of a range.
+  inline double InterpRangeBound (double n0, double n1, double a)
+  {
+    return MultiplyRangeBound (1.0 - a, n0) + MultiplyRangeBound (a, n1);
+  }
+
+  /// Returns the range of the product of two values.
+  ///
+  /// @param aLower The lower bound of the first value.
+  /// @param aUpper The upper bound of the first value.
+  /// @param bLower The lower bound of the second value.
+  /// @param bUpper The upper bound of the second value.
+  /// @param lower Receives the lower bound of the product.
+  /// @param upper Receives the upper bound of the product.
+  ///
+  /// The bounds may be infinite.
+  inline void GetProductRange (double aLower, double aUpper, double bLower,
+    double bUpper, double& lower, double& upper)
+  {
+    double p0 = MultiplyRangeBound (aLower, bLower);
+    double p1 = MultiplyRangeBound (aLower, bUpper);
+    double p2 = MultiplyRangeBound (aUpper, bLower);
+    double p3 = MultiplyRangeBound (aUpper, bUpper);
+    lower = GetMin (GetMin (p0, p1), GetMin (p2, p3));
+    upper = GetMax (GetMax (p0, p1), GetMax (p2, p3));
+  }
+
+  /// Returns the range of the absolute value of a value.
+  ///
+  /// @param aLower The lower bound of the value.
+  /// @param aUpper The upper bound of the value.
+  /// @param lower Receives the lower bound of the absolute value.
+  /// @param upper Receives the upper bound of the absolute value.
+  inline void GetAbsRange (double aLower, double aUpper, double& lower,
+    double& upper)
+  {
+    if (aLower >= 0.0) {
+      lower = aLower;
+      upper = aUpper;
+    } else if (aUpper <= 0.0) {
+      lower = -aUpper;
+      upper = -aLower;
+    } else {
+      lower = 0.0;
+      upper = GetMax (-aLower, aUpper);
+    }
+  }
+
+  /// Multiplies the bounds of a range by a factor.
+  ///
+  /// @param factor The factor.
+  /// @param lower The lower bound of the range.
+  /// @param upper The upper bound of the range.
+  ///
+  /// The bounds are swapped if the factor is negative, so that the lower
+  /// bound stays below the upper bound.
+  inline void ScaleRange (double factor, double& lower, double& upper)
+  {
+    lower *= factor;
+    upper *= factor;
+    if (factor < 0.0) {
+      SwapValues (lower, upper);
+    }
+  }
+
+  /// Returns the range of LinearInterp().
+  ///
+  /// @param n0Lower The lower bound of the first value.
+  /// @param n0Upper The upper bound of the first value.
+  /// @param n1Lower The lower bound of the second value.
+  /// @param n1Upper The upper bound of the second value.
+  /// @param aLower The lower bound of the alpha value.
+  /// @param aUpper The upper bound of the alpha value.
+  /// @param lower Receives the lower bound of the interpolated value.
+  /// @param upper Receives the upper bound of the interpolated value.
+  ///
+  /// If the alpha value ranges from 0.0 to 1.0, the interpolated value
+  /// grows with both values and is linear in the alpha value, so its bounds
+  /// are found at the bounds of the alpha value.  Otherwise each term of
+  /// the interpolation is bounded on its own.
+  inline void GetLinearInterpRange (double n0Lower, double n0Upper,
+    double n1Lower, double n1Upper, double aLower, double aUpper,
+    double& lower, double& upper)
+  {
+    if (aLower >= 0.0 && aUpper <= 1.0) {
+      lower = GetMin (InterpRangeBound (n0Lower, n1Lower, aLower),
+        InterpRangeBound (n0Lower, n1Lower, aUpper));
+      upper = GetMax (InterpRangeBound (n0Upper, n1Upper, aLower),
+        InterpRangeBound (n0Upper, n1Upper, aUpper));
+    } else {
+      double lower0, upper0, lower1, upper1;
+      GetProductRange (1.0 - aUpper, 1.0 - aLower, n0Lower, n0Upper, lower0,
+        upper0);
+      GetProductRange (aLower, aUpper, n1Lower, n1Upper, lower1, upper1);
+      lower = lower0 + lower1;
+      upper = upper0 + upper1;
+    }
+  }
+
+  /// @}
+
+}
+
+#endif
@@ -29,6 +29,16 @@ Abs::Abs ():
 {
 }
 
+void Abs::GetRange (double xMin, double yMin, double zMin, double xMax,
+  double yMax, double zMax, double& lower, double& upper) const
+{
+  assert (m_pSourceModule[0] != NULL);
+
+  m_pSourceModule[0]->GetRange (xMin, yMin, zMin, xMax, yMax, zMax, lower,
+    upper);
+  GetAbsRange (lower, upper, lower, upper);
+}
+
 double Abs::GetValue (double x, double y, double z) const
 {
   assert (m_pSourceModule[0] != NULL);
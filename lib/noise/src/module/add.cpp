@@ -29,6 +29,21 @@ Add::Add ():
 {
 }
 
+void Add::GetRange (double xMin, double yMin, double zMin, double xMax,
+  double yMax, double zMax, double& lower, double& upper) const
+{
+  assert (m_pSourceModule[0] != NULL);
+  assert (m_pSourceModule[1] != NULL);
+
+  double lower0, upper0, lower1, upper1;
+  m_pSourceModule[0]->GetRange (xMin, yMin, zMin, xMax, yMax, zMax, lower0,
+    upper0);
+  m_pSourceModule[1]->GetRange (xMin, yMin, zMin, xMax, yMax, zMax, lower1,
+    upper1);
+  lower = lower0 + lower1;
+  upper = upper0 + upper1;
+}
+
 double Add::GetValue (double x, double y, double z) const
 {
   assert (m_pSourceModule[0] != NULL);
@@ -37,3 +52,28 @@ double Add::GetValue (double x, double y, double z) const
   return m_pSourceModule[0]->GetValue (x, y, z)
        + m_pSourceModule[1]->GetValue (x, y, z);
 }
+
+void Add::GetValues (const double* x, const double* y, const double* z,
+  double* values, int count) const
+{
+  assert (m_pSourceModule[0] != NULL);
+  assert (m_pSourceModule[1] != NULL);
+
+  double value1[MODULE_BATCH_SIZE];
+
+  for (int first = 0; first < count; first += MODULE_BATCH_SIZE) {
+    int batchSize = count - first;
+    if (batchSize > MODULE_BATCH_SIZE) {
+      batchSize = MODULE_BATCH_SIZE;
+    }
+    double* value = values + first;
+
+    m_pSourceModule[0]->GetValues (x + first, y + first, z + first, value,
+      batchSize);
+    m_pSourceModule[1]->GetValues (x + first, y + first, z + first, value1,
+      batchSize);
+    for (int i = 0; i < batchSize; i++) {
+      value[i] += value1[i];
+    }
+  }
+}
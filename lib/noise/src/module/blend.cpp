@@ -30,6 +30,26 @@ Blend::Blend ():
 {
 }
 
+void Blend::GetRange (double xMin, double yMin, double zMin, double xMax,
+  double yMax, double zMax, double& lower, double& upper) const
+{
+  assert (m_pSourceModule[0] != NULL);
+  assert (m_pSourceModule[1] != NULL);
+  assert (m_pSourceModule[2] != NULL);
+
+  double lower0, upper0, lower1, upper1, alphaLower, alphaUpper;
+  m_pSourceModule[0]->GetRange (xMin, yMin, zMin, xMax, yMax, zMax, lower0,
+    upper0);
+  m_pSourceModule[1]->GetRange (xMin, yMin, zMin, xMax, yMax, zMax, lower1,
+    upper1);
+  m_pSourceModule[2]->GetRange (xMin, yMin, zMin, xMax, yMax, zMax,
+    alphaLower, alphaUpper);
+  alphaLower = (alphaLower + 1.0) / 2.0;
+  alphaUpper = (alphaUpper + 1.0) / 2.0;
+  GetLinearInterpRange (lower0, upper0, lower1, upper1, alphaLower,
+    alphaUpper, lower, upper);
+}
+
 double Blend::GetValue (double x, double y, double z) const
 {
   assert (m_pSourceModule[0] != NULL);
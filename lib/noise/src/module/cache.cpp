@@ -20,26 +20,129 @@
 // off every 'zig'.)
 //
 
+#include <atomic>
+
 #include "module/cache.h"
 
 using namespace noise::module;
 
+namespace
+{
+
+  // Last input value and output value of a Cache noise module, for one
+  // thread.  The noise precision the value was generated with is part of
+  // the key, so that switching precision never returns a stale value.
+  struct CacheEntry
+  {
+    unsigned long long cacheId;
+    noise::NoisePrecision precision;
+    double x, y, z;
+    double value;
+  };
+
+  // Number of sets in the table of each thread, and number of entries in
+  // each set.  A Cache noise module keeps its last CACHE_WAY_COUNT input
+  // values in one set.
+  const int CACHE_SET_COUNT = 16;
+  const int CACHE_WAY_COUNT = 4;
+
+  // Entries of one set, and the entry that the next new value replaces.
+  struct CacheSet
+  {
+    CacheEntry entries[CACHE_WAY_COUNT];
+    int next;
+  };
+
+  // Cached values of the current thread.  Zero-initialized, and zero is
+  // never used as an identifier, so every entry starts out empty.
+  thread_local CacheSet t_cacheSets[CACHE_SET_COUNT];
+
+  // Stores a value in the next entry of a set.
+  inline void StoreEntry (CacheSet& set, unsigned long long cacheId,
+    noise::NoisePrecision precision, double x, double y, double z,
+    double value)
+  {
+    CacheEntry& entry = set.entries[set.next];
+    entry.cacheId = cacheId;
+    entry.precision = precision;
+    entry.x = x;
+    entry.y = y;
+    entry.z = z;
+    entry.value = value;
+    set.next = (set.next + 1) % CACHE_WAY_COUNT;
+  }
+
+  // Next identifier to give to a Cache noise module.
+  std::atomic<unsigned long long> g_nextCacheId (1);
+
+}
+
 Cache::Cache ():
   Module (GetSourceModuleCount ()),
-  m_isCached (false)
+  m_cacheId (g_nextCacheId++),
+  m_reuseCount (0)
 {
 }
 
+void Cache::GetRange (double xMin, double yMin, double zMin, double xMax,
+  double yMax, double zMax, double& lower, double& upper) const
+{
+  assert (m_pSourceModule[0] != NULL);
+
+  m_pSourceModule[0]->GetRange (xMin, yMin, zMin, xMax, yMax, zMax, lower,
+    upper);
+}
+
 double Cache::GetValue (double x, double y, double z) const
 {
   assert (m_pSourceModule[0] != NULL);
 
-  if (!(m_isCached && x == m_xCache && y == m_yCache && z == m_zCache)) {
-    m_cachedValue = m_pSourceModule[0]->GetValue (x, y, z);
-    m_xCache = x;
-    m_yCache = y;
-    m_zCache = z;
+  CacheSet& set = t_cacheSets[m_cacheId % CACHE_SET_COUNT];
+  NoisePrecision precision = GetNoisePrecision ();
+  for (int i = 0; i < CACHE_WAY_COUNT; i++) {
+    const CacheEntry& entry = set.entries[i];
+    if (entry.cacheId == m_cacheId && entry.precision == precision
+      && x == entry.x && y == entry.y && z == entry.z) {
+#ifndef NDEBUG
+      m_reuseCount.fetch_add (1, std::memory_order_relaxed);
+#endif
+      return entry.value;
+    }
+  }
+
+  // The source module may use this set too (through another Cache noise
+  // module), so it is only written after the value is known.
+  double value = m_pSourceModule[0]->GetValue (x, y, z);
+  StoreEntry (set, m_cacheId, precision, x, y, z, value);
+  return value;
+}
+
+void Cache::GetValues (const double* x, const double* y, const double* z,
+  double* values, int count) const
+{
+  assert (m_pSourceModule[0] != NULL);
+
+  if (count <= 0) {
+    return;
   }
-  m_isCached = true;
-  return m_cachedValue;
+
+  // The batch goes straight to the source module; the last input values
+  // are cached as if GetValue() had been called for each one.
+  m_pSourceModule[0]->GetValues (x, y, z, values, count);
+
+  CacheSet& set = t_cacheSets[m_cacheId % CACHE_SET_COUNT];
+  NoisePrecision precision = GetNoisePrecision ();
+  int first = count - CACHE_WAY_COUNT;
+  if (first < 0) {
+    first = 0;
+  }
+  for (int i = first; i < count; i++) {
+    StoreEntry (set, m_cacheId, precision, x[i], y[i], z[i], values[i]);
+  }
+}
+
+void Cache::SetSourceModule (int index, const Module& sourceModule)
+{
+  Module::SetSourceModule (index, sourceModule);
+  m_cacheId = g_nextCacheId++;
 }
@@ -31,6 +31,17 @@ Clamp::Clamp ():
 {
 }
 
+void Clamp::GetRange (double xMin, double yMin, double zMin, double xMax,
+  double yMax, double zMax, double& lower, double& upper) const
+{
+  assert (m_pSourceModule[0] != NULL);
+
+  m_pSourceModule[0]->GetRange (xMin, yMin, zMin, xMax, yMax, zMax, lower,
+    upper);
+  lower = GetMin (GetMax (lower, m_lowerBound), m_upperBound);
+  upper = GetMax (GetMin (upper, m_upperBound), m_lowerBound);
+}
+
 double Clamp::GetValue (double x, double y, double z) const
 {
   assert (m_pSourceModule[0] != NULL);
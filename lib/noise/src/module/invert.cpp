@@ -29,6 +29,18 @@ Invert::Invert ():
 {
 }
 
+void Invert::GetRange (double xMin, double yMin, double zMin, double xMax,
+  double yMax, double zMax, double& lower, double& upper) const
+{
+  assert (m_pSourceModule[0] != NULL);
+
+  double sourceLower, sourceUpper;
+  m_pSourceModule[0]->GetRange (xMin, yMin, zMin, xMax, yMax, zMax,
+    sourceLower, sourceUpper);
+  lower = -sourceUpper;
+  upper = -sourceLower;
+}
+
 double Invert::GetValue (double x, double y, double z) const
 {
   assert (m_pSourceModule[0] != NULL);
@@ -30,6 +30,21 @@ Max::Max ():
 {
 }
 
+void Max::GetRange (double xMin, double yMin, double zMin, double xMax,
+  double yMax, double zMax, double& lower, double& upper) const
+{
+  assert (m_pSourceModule[0] != NULL);
+  assert (m_pSourceModule[1] != NULL);
+
+  double lower0, upper0, lower1, upper1;
+  m_pSourceModule[0]->GetRange (xMin, yMin, zMin, xMax, yMax, zMax, lower0,
+    upper0);
+  m_pSourceModule[1]->GetRange (xMin, yMin, zMin, xMax, yMax, zMax, lower1,
+    upper1);
+  lower = GetMax (lower0, lower1);
+  upper = GetMax (upper0, upper1);
+}
+
 double Max::GetValue (double x, double y, double z) const
 {
   assert (m_pSourceModule[0] != NULL);
@@ -44,3 +44,19 @@ Module::~Module ()
 {
   delete[] m_pSourceModule;
 }
+
+void Module::GetRange (double /*xMin*/, double /*yMin*/, double /*zMin*/,
+  double /*xMax*/, double /*yMax*/, double /*zMax*/, double& lower,
+  double& upper) const
+{
+  lower = -HUGE_VAL;
+  upper = HUGE_VAL;
+}
+
+void Module::GetValues (const double* x, const double* y, const double* z,
+  double* values, int count) const
+{
+  for (int i = 0; i < count; i++) {
+    values[i] = GetValue (x[i], y[i], z[i]);
+  }
+}
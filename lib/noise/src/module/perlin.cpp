@@ -31,10 +31,55 @@ Perlin::Perlin ():
   m_noiseQuality (DEFAULT_PERLIN_QUALITY     ),
   m_octaveCount  (DEFAULT_PERLIN_OCTAVE_COUNT),
   m_persistence  (DEFAULT_PERLIN_PERSISTENCE ),
+  m_period       (0),
   m_seed         (DEFAULT_PERLIN_SEED)
 {
 }
 
+void Perlin::GetRange (double xMin, double yMin, double zMin, double xMax,
+  double yMax, double zMax, double& lower, double& upper) const
+{
+  double curPersistence = 1.0;
+
+  ScaleRange (m_frequency, xMin, xMax);
+  ScaleRange (m_frequency, yMin, yMax);
+  ScaleRange (m_frequency, zMin, zMax);
+
+  // Bound each octave over the box and add the bounds up, like the octaves
+  // themselves.  Once the persistence reaches zero, the remaining octaves
+  // add nothing.
+  lower = 0.0;
+  upper = 0.0;
+  double octavePeriod = m_period;
+  for (int curOctave = 0; curOctave < m_octaveCount && curPersistence != 0.0;
+    curOctave++) {
+    int seed = (m_seed + curOctave) & 0xffffffff;
+    double signalLower, signalUpper;
+    if (m_period > 0) {
+      int period = MakeIntPeriod (octavePeriod);
+      double scale = (double)period / octavePeriod;
+      PeriodicGradientCoherentNoise3DRange (xMin * scale, yMin * scale,
+        zMin * scale, xMax * scale, yMax * scale, zMax * scale, signalLower,
+        signalUpper, period, seed, m_noiseQuality);
+    } else {
+      GradientCoherentNoise3DRange (xMin, yMin, zMin, xMax, yMax, zMax,
+        signalLower, signalUpper, seed, m_noiseQuality);
+    }
+    double termLower, termUpper;
+    GetProductRange (signalLower, signalUpper, curPersistence,
+      curPersistence, termLower, termUpper);
+    lower += termLower;
+    upper += termUpper;
+
+    // Prepare the next octave.
+    ScaleRange (m_lacunarity, xMin, xMax);
+    ScaleRange (m_lacunarity, yMin, yMax);
+    ScaleRange (m_lacunarity, zMin, zMax);
+    curPersistence *= m_persistence;
+    octavePeriod *= m_lacunarity;
+  }
+}
+
 double Perlin::GetValue (double x, double y, double z) const
 {
   double value = 0.0;
@@ -47,18 +92,31 @@ double Perlin::GetValue (double x, double y, double z) const
   y *= m_frequency;
   z *= m_frequency;
 
+  double octavePeriod = m_period;
   for (int curOctave = 0; curOctave < m_octaveCount; curOctave++) {
 
-    // Make sure that these floating-point values have the same range as a 32-
-    // bit integer so that we can pass them to the coherent-noise functions.
-    nx = MakeInt32Range (x);
-    ny = MakeInt32Range (y);
-    nz = MakeInt32Range (z);
-
     // Get the coherent-noise value from the input value and add it to the
     // final result.
     seed = (m_seed + curOctave) & 0xffffffff;
-    signal = GradientCoherentNoise3D (nx, ny, nz, seed, m_noiseQuality);
+    if (m_period > 0) {
+      // Stretch this octave so that its period is a whole number of lattice
+      // cells, and wrap the input value into that period.
+      int period = MakeIntPeriod (octavePeriod);
+      double scale = (double)period / octavePeriod;
+      nx = MakePeriodicRange (x * scale, period);
+      ny = MakePeriodicRange (y * scale, period);
+      nz = MakePeriodicRange (z * scale, period);
+      signal = PeriodicGradientCoherentNoise3D (nx, ny, nz, period, seed,
+        m_noiseQuality);
+    } else {
+      // Make sure that these floating-point values have the same range as a
+      // 32-bit integer so that we can pass them to the coherent-noise
+      // functions.
+      nx = MakeInt32Range (x);
+      ny = MakeInt32Range (y);
+      nz = MakeInt32Range (z);
+      signal = GradientCoherentNoise3D (nx, ny, nz, seed, m_noiseQuality);
+    }
     value += signal * curPersistence;
 
     // Prepare the next octave.
@@ -66,7 +124,72 @@ double Perlin::GetValue (double x, double y, double z) const
     y *= m_lacunarity;
     z *= m_lacunarity;
     curPersistence *= m_persistence;
+    octavePeriod *= m_lacunarity;
   }
 
   return value;
 }
+
+void Perlin::GetValues (const double* x, const double* y, const double* z,
+  double* values, int count) const
+{
+  double xCur[MODULE_BATCH_SIZE];
+  double yCur[MODULE_BATCH_SIZE];
+  double zCur[MODULE_BATCH_SIZE];
+  double nx[MODULE_BATCH_SIZE];
+  double ny[MODULE_BATCH_SIZE];
+  double nz[MODULE_BATCH_SIZE];
+  double signal[MODULE_BATCH_SIZE];
+
+  for (int first = 0; first < count; first += MODULE_BATCH_SIZE) {
+    int batchSize = count - first;
+    if (batchSize > MODULE_BATCH_SIZE) {
+      batchSize = MODULE_BATCH_SIZE;
+    }
+    double* value = values + first;
+
+    for (int i = 0; i < batchSize; i++) {
+      xCur[i] = x[first + i] * m_frequency;
+      yCur[i] = y[first + i] * m_frequency;
+      zCur[i] = z[first + i] * m_frequency;
+      value[i] = 0.0;
+    }
+
+    // Same operations as GetValue(), but each octave runs over the whole
+    // batch: the seed and persistence are computed once per octave and the
+    // coherent noise is generated by the SIMD kernels of noisegen.cpp.
+    double curPersistence = 1.0;
+    double octavePeriod = m_period;
+    for (int curOctave = 0; curOctave < m_octaveCount; curOctave++) {
+      int seed = (m_seed + curOctave) & 0xffffffff;
+      if (m_period > 0) {
+        int period = MakeIntPeriod (octavePeriod);
+        double scale = (double)period / octavePeriod;
+        for (int i = 0; i < batchSize; i++) {
+          nx[i] = MakePeriodicRange (xCur[i] * scale, period);
+          ny[i] = MakePeriodicRange (yCur[i] * scale, period);
+          nz[i] = MakePeriodicRange (zCur[i] * scale, period);
+        }
+        PeriodicGradientCoherentNoise3D (nx, ny, nz, signal, batchSize, period,
+          seed, m_noiseQuality);
+      } else {
+        for (int i = 0; i < batchSize; i++) {
+          nx[i] = MakeInt32Range (xCur[i]);
+          ny[i] = MakeInt32Range (yCur[i]);
+          nz[i] = MakeInt32Range (zCur[i]);
+        }
+        GradientCoherentNoise3D (nx, ny, nz, signal, batchSize, seed,
+          m_noiseQuality);
+      }
+
+      for (int i = 0; i < batchSize; i++) {
+        value[i] += signal[i] * curPersistence;
+        xCur[i] *= m_lacunarity;
+        yCur[i] *= m_lacunarity;
+        zCur[i] *= m_lacunarity;
+      }
+      curPersistence *= m_persistence;
+      octavePeriod *= m_lacunarity;
+    }
+  }
+}
@@ -0,0 +1,726 @@
+// program.cpp
+//
+// This library is free software; you can redistribute it and/or modify it
+// under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation; either version 2.1 of the License, or (at
+// your option) any later version.
+//
+// This library is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+// License (COPYING.txt) for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this library; if not, write to the Free Software Foundation,
+// Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+
+#include <deque>
+#include <map>
+#include <utility>
+
+#include "interp.h"
+#include "misc.h"
+#include "module/abs.h"
+#include "module/add.h"
+#include "module/blend.h"
+#include "module/cache.h"
+#include "module/clamp.h"
+#include "module/const.h"
+#include "module/invert.h"
+#include "module/max.h"
+#include "module/min.h"
+#include "module/multiply.h"
+#include "module/program.h"
+#include "module/scalebias.h"
+#include "module/scalepoint.h"
+#include "module/select.h"
+#include "module/translatepoint.h"
+#include "module/turbulence.h"
+
+using namespace noise::module;
+
+/////////////////////////////////////////////////////////////////////////////
+// Compiler
+
+// Builds the blocks of a program.  A value is identified by the noise module
+// that generates it and the coordinate registers that it is evaluated on, so
+// a subgraph that is reached twice with the same coordinates is compiled
+// once per block.
+struct Program::Compiler
+{
+  typedef std::pair<const Module*, int> ValueKey;
+
+  Compiler ()
+  {
+    NewBlock ();
+  }
+
+  // Counts how many noise modules use each noise module as a source.
+  void CountReferences (const Module& module)
+  {
+    for (int i = 0; i < module.GetSourceModuleCount (); i++) {
+      const Module& sourceModule = module.GetSourceModule (i);
+      if (m_referenceCount[&sourceModule]++ == 0) {
+        CountReferences (sourceModule);
+      }
+    }
+  }
+
+  int NewBlock ()
+  {
+    Block block;
+    // The coordinates of the input values.
+    block.registerBase = 0;
+    block.registerCount = 3;
+    block.result = 0;
+    block.reuseCount = 0;
+    m_blocks.push_back (block);
+    m_values.push_back (std::map<ValueKey, int> ());
+    return (int)m_blocks.size () - 1;
+  }
+
+  static Instruction NewInstruction (Opcode opcode, int coords)
+  {
+    Instruction instruction;
+    instruction.opcode = opcode;
+    instruction.dest = -1;
+    instruction.source[0] = instruction.source[1] = instruction.source[2] =
+      -1;
+    instruction.coords = coords;
+    instruction.pModule = NULL;
+    instruction.param[0] = instruction.param[1] = instruction.param[2] = 0.0;
+    instruction.branch[0] = instruction.branch[1] = instruction.branch[2] =
+      -1;
+    return instruction;
+  }
+
+  // Appends an instruction that writes registerCount new registers and
+  // returns the first one.
+  int Emit (int blockIndex, Instruction& instruction, int registerCount = 1)
+  {
+    Block& block = m_blocks[blockIndex];
+    instruction.dest = block.registerCount;
+    block.registerCount += registerCount;
+    block.code.push_back (instruction);
+    return instruction.dest;
+  }
+
+  bool IsShared (const Module& module)
+  {
+    return m_referenceCount[&module] > 1;
+  }
+
+  // Returns true if the output value of a noise module depends on a Select
+  // module, whose source modules are compiled into blocks of their own.
+  bool HasBranch (const Module& module)
+  {
+    std::map<const Module*, bool>::const_iterator found =
+      m_hasBranch.find (&module);
+    if (found != m_hasBranch.end ()) {
+      return found->second;
+    }
+    bool hasBranch = dynamic_cast<const Select*> (&module) != NULL;
+    for (int i = 0; !hasBranch && i < module.GetSourceModuleCount (); i++) {
+      hasBranch = HasBranch (module.GetSourceModule (i));
+    }
+    m_hasBranch[&module] = hasBranch;
+    return hasBranch;
+  }
+
+  static bool IsValueStep (const Module& module)
+  {
+    return dynamic_cast<const ScaleBias*> (&module) != NULL
+      || dynamic_cast<const Clamp*> (&module) != NULL;
+  }
+
+  static bool IsPointStep (const Module& module)
+  {
+    return dynamic_cast<const ScalePoint*> (&module) != NULL
+      || dynamic_cast<const TranslatePoint*> (&module) != NULL;
+  }
+
+  static Step MakeStep (const Module& module)
+  {
+    Step step;
+    step.param[2] = 0.0;
+    if (const ScaleBias* pScaleBias = dynamic_cast<const ScaleBias*> (
+      &module)) {
+      step.type = STEP_SCALE_BIAS;
+      step.param[0] = pScaleBias->GetScale ();
+      step.param[1] = pScaleBias->GetBias ();
+    } else if (const Clamp* pClamp = dynamic_cast<const Clamp*> (&module)) {
+      step.type = STEP_CLAMP;
+      step.param[0] = pClamp->GetLowerBound ();
+      step.param[1] = pClamp->GetUpperBound ();
+    } else if (const ScalePoint* pScalePoint =
+      dynamic_cast<const ScalePoint*> (&module)) {
+      step.type = STEP_SCALE_POINT;
+      step.param[0] = pScalePoint->GetXScale ();
+      step.param[1] = pScalePoint->GetYScale ();
+      step.param[2] = pScalePoint->GetZScale ();
+    } else {
+      const TranslatePoint& translatePoint =
+        dynamic_cast<const TranslatePoint&> (module);
+      step.type = STEP_TRANSLATE_POINT;
+      step.param[0] = translatePoint.GetXTranslation ();
+      step.param[1] = translatePoint.GetYTranslation ();
+      step.param[2] = translatePoint.GetZTranslation ();
+    }
+    return step;
+  }
+
+  // Compiles the output value of a noise module, evaluated on the
+  // coordinates in registers coords to coords + 2, and returns the register
+  // that holds it.
+  int CompileValue (int blockIndex, const Module& module, int coords)
+  {
+    ValueKey key (&module, coords);
+    std::map<ValueKey, int>::const_iterator found =
+      m_values[blockIndex].find (key);
+    if (found != m_values[blockIndex].end ()) {
+      m_blocks[blockIndex].reuseCount++;
+      return found->second;
+    }
+
+    int result;
+    Instruction instruction = NewInstruction (OP_MODULE, coords);
+
+    if (dynamic_cast<const Cache*> (&module) != NULL) {
+      result = CompileValue (blockIndex, module.GetSourceModule (0), coords);
+
+    } else if (IsValueStep (module)) {
+      // Fold the chain of ScaleBias and Clamp modules, innermost step
+      // first.
+      std::vector<Step> steps;
+      const Module* pModule = &module;
+      do {
+        steps.insert (steps.begin (), MakeStep (*pModule));
+        pModule = &pModule->GetSourceModule (0);
+      } while (IsValueStep (*pModule) && !IsShared (*pModule));
+      instruction.opcode = OP_AFFINE;
+      instruction.source[0] = CompileValue (blockIndex, *pModule, coords);
+      instruction.steps = steps;
+      result = Emit (blockIndex, instruction);
+
+    } else if (IsPointStep (module)) {
+      // Fold the chain of ScalePoint and TranslatePoint modules; the
+      // outermost module transforms the input value first.
+      const Module* pModule = &module;
+      do {
+        instruction.steps.push_back (MakeStep (*pModule));
+        pModule = &pModule->GetSourceModule (0);
+      } while (IsPointStep (*pModule) && !IsShared (*pModule));
+      instruction.opcode = OP_TRANSFORM;
+      int transformed = Emit (blockIndex, instruction, 3);
+      result = CompileValue (blockIndex, *pModule, transformed);
+
+    } else if (dynamic_cast<const Turbulence*> (&module) != NULL) {
+      instruction.opcode = OP_TURBULENCE;
+      instruction.pModule = &module;
+      int displaced = Emit (blockIndex, instruction, 3);
+      result = CompileValue (blockIndex, module.GetSourceModule (0),
+        displaced);
+
+    } else if (const Const* pConst = dynamic_cast<const Const*> (&module)) {
+      instruction.opcode = OP_CONST;
+      instruction.param[0] = pConst->GetConstValue ();
+      result = Emit (blockIndex, instruction);
+
+    } else if (const Select* pSelect = dynamic_cast<const Select*> (
+      &module)) {
+      instruction.opcode = OP_SELECT;
+      instruction.pModule = &module;
+      // A source module or control module that this block already evaluates
+      // is read from its register; the others get a block that only runs on
+      // the input values that need them.
+      for (int i = 0; i < 3; i++) {
+        const Module& sourceModule = pSelect->GetSourceModule (i);
+        found = m_values[blockIndex].find (ValueKey (&sourceModule, coords));
+        if (found != m_values[blockIndex].end ()) {
+          m_blocks[blockIndex].reuseCount++;
+          instruction.source[i] = found->second;
+        } else {
+          int branch = NewBlock ();
+          int branchResult = CompileValue (branch, sourceModule, 0);
+          m_blocks[branch].result = branchResult;
+          instruction.branch[i] = branch;
+        }
+      }
+      instruction.param[0] = pSelect->GetLowerBound ();
+      instruction.param[1] = pSelect->GetUpperBound ();
+      instruction.param[2] = pSelect->GetEdgeFalloff ();
+      result = Emit (blockIndex, instruction);
+
+    } else {
+      int sourceCount = 0;
+      if (dynamic_cast<const Abs*> (&module) != NULL) {
+        instruction.opcode = OP_ABS;
+        sourceCount = 1;
+      } else if (dynamic_cast<const Invert*> (&module) != NULL) {
+        instruction.opcode = OP_INVERT;
+        sourceCount = 1;
+      } else if (dynamic_cast<const Add*> (&module) != NULL) {
+        instruction.opcode = OP_ADD;
+        sourceCount = 2;
+      } else if (dynamic_cast<const Multiply*> (&module) != NULL) {
+        instruction.opcode = OP_MULTIPLY;
+        sourceCount = 2;
+      } else if (dynamic_cast<const Max*> (&module) != NULL) {
+        instruction.opcode = OP_MAX;
+        sourceCount = 2;
+      } else if (dynamic_cast<const Min*> (&module) != NULL) {
+        instruction.opcode = OP_MIN;
+        sourceCount = 2;
+      } else if (dynamic_cast<const Blend*> (&module) != NULL) {
+        instruction.opcode = OP_BLEND;
+        sourceCount = 3;
+      } else {
+        // Generators and every other noise module evaluate themselves.
+        instruction.pModule = &module;
+      }
+      // Source modules that lead to a Select module are compiled last, so
+      // that a noise module they share with the other source modules is
+      // already in a register of this block when the Select module looks
+      // for it, instead of being evaluated again in one of its blocks.
+      for (int pass = 0; pass < 2; pass++) {
+        for (int i = 0; i < sourceCount; i++) {
+          const Module& sourceModule = module.GetSourceModule (i);
+          if (HasBranch (sourceModule) == (pass == 1)) {
+            instruction.source[i] = CompileValue (blockIndex, sourceModule,
+              coords);
+          }
+        }
+      }
+      result = Emit (blockIndex, instruction);
+    }
+
+    m_values[blockIndex][key] = result;
+    return result;
+  }
+
+  std::vector<Block> m_blocks;
+  std::vector<std::map<ValueKey, int> > m_values;
+  std::map<const Module*, int> m_referenceCount;
+  std::map<const Module*, bool> m_hasBranch;
+};
+
+/////////////////////////////////////////////////////////////////////////////
+// Program
+
+// Returns a register of a block.
+static inline double* GetRegister (double* base, int index)
+{
+  return base + index * MODULE_BATCH_SIZE;
+}
+
+// Register files of the programs that the current thread is running, one
+// per nesting level: a program can run another one through OP_MODULE.  They
+// are kept between calls, so GetValues() only allocates when a file grows.
+// A deque, so that adding a level does not move the files already in use.
+static thread_local std::deque<std::vector<double> > t_registerFiles;
+static thread_local size_t t_registerDepth = 0;
+
+// The register file of one GetValues() call, with at least the given number
+// of values.
+class RegisterFile
+{
+
+  public:
+
+    explicit RegisterFile (size_t size)
+    {
+      if (t_registerDepth == t_registerFiles.size ()) {
+        t_registerFiles.push_back (std::vector<double> ());
+      }
+      std::vector<double>& file = t_registerFiles[t_registerDepth++];
+      if (file.size () < size) {
+        file.resize (size);
+      }
+      m_pRegisters = &file[0];
+    }
+
+    ~RegisterFile ()
+    {
+      t_registerDepth--;
+    }
+
+    double* Get () const
+    {
+      return m_pRegisters;
+    }
+
+  private:
+
+    double* m_pRegisters;
+
+};
+
+Program::Program ():
+  Module (GetSourceModuleCount ()),
+  m_registerCount (0),
+  m_reuseCount (0)
+{
+}
+
+void Program::Compile (const Module& sourceModule)
+{
+  Compiler compiler;
+  compiler.CountReferences (sourceModule);
+  compiler.m_blocks[0].result = compiler.CompileValue (0, sourceModule, 0);
+
+  // Give each block its own registers.
+  int registerCount = 0;
+  for (size_t i = 0; i < compiler.m_blocks.size (); i++) {
+    compiler.m_blocks[i].registerBase = registerCount;
+    registerCount += compiler.m_blocks[i].registerCount;
+  }
+
+  m_blocks.swap (compiler.m_blocks);
+  m_registerCount = registerCount;
+  m_reuseCount = 0;
+  Module::SetSourceModule (0, sourceModule);
+}
+
+int Program::GetInstructionCount () const
+{
+  int count = 0;
+  for (size_t i = 0; i < m_blocks.size (); i++) {
+    count += (int)m_blocks[i].code.size ();
+  }
+  return count;
+}
+
+int Program::GetSharedValueCount () const
+{
+  int count = 0;
+  for (size_t i = 0; i < m_blocks.size (); i++) {
+    count += m_blocks[i].reuseCount;
+  }
+  return count;
+}
+
+void Program::GetRange (double xMin, double yMin, double zMin, double xMax,
+  double yMax, double zMax, double& lower, double& upper) const
+{
+  assert (m_pSourceModule[0] != NULL);
+
+  m_pSourceModule[0]->GetRange (xMin, yMin, zMin, xMax, yMax, zMax, lower,
+    upper);
+}
+
+double Program::GetValue (double x, double y, double z) const
+{
+  double value;
+  GetValues (&x, &y, &z, &value, 1);
+  return value;
+}
+
+void Program::GetValues (const double* x, const double* y, const double* z,
+  double* values, int count) const
+{
+  assert (m_pSourceModule[0] != NULL);
+
+  RegisterFile registers (m_registerCount * MODULE_BATCH_SIZE);
+  double* base = registers.Get ()
+    + m_blocks[0].registerBase * MODULE_BATCH_SIZE;
+  const double* result = GetRegister (base, m_blocks[0].result);
+
+  for (int first = 0; first < count; first += MODULE_BATCH_SIZE) {
+    int batchSize = count - first;
+    if (batchSize > MODULE_BATCH_SIZE) {
+      batchSize = MODULE_BATCH_SIZE;
+    }
+
+    double* xReg = GetRegister (base, 0);
+    double* yReg = GetRegister (base, 1);
+    double* zReg = GetRegister (base, 2);
+    for (int i = 0; i < batchSize; i++) {
+      xReg[i] = x[first + i];
+      yReg[i] = y[first + i];
+      zReg[i] = z[first + i];
+    }
+
+    Run (0, registers.Get (), batchSize);
+
+    for (int i = 0; i < batchSize; i++) {
+      values[first + i] = result[i];
+    }
+  }
+}
+
+void Program::Run (int blockIndex, double* registers, int count) const
+{
+  // How each output value of OP_SELECT is calculated; the same cases as
+  // Select::GetValue().
+  enum {
+    SOURCE_0,
+    SOURCE_1,
+    CURVE_0_TO_1,
+    CURVE_1_TO_0
+  };
+
+  const Block& block = m_blocks[blockIndex];
+  double* base = registers + block.registerBase * MODULE_BATCH_SIZE;
+
+#ifndef NDEBUG
+  // One addition per block run; the counter is shared by every thread.
+  if (block.reuseCount > 0) {
+    m_reuseCount.fetch_add ((unsigned long long)block.reuseCount * count,
+      std::memory_order_relaxed);
+  }
+#endif
+
+  for (size_t n = 0; n < block.code.size (); n++) {
+    const Instruction& instruction = block.code[n];
+    double* dest = GetRegister (base, instruction.dest);
+    const double* x = GetRegister (base, instruction.coords);
+    const double* y = x + MODULE_BATCH_SIZE;
+    const double* z = y + MODULE_BATCH_SIZE;
+    const double* source0 = GetRegister (base, instruction.source[0]);
+    const double* source1 = GetRegister (base, instruction.source[1]);
+    const double* source2 = GetRegister (base, instruction.source[2]);
+
+    switch (instruction.opcode) {
+
+      case OP_MODULE:
+        instruction.pModule->GetValues (x, y, z, dest, count);
+        break;
+
+      case OP_CONST:
+        for (int i = 0; i < count; i++) {
+          dest[i] = instruction.param[0];
+        }
+        break;
+
+      case OP_AFFINE:
+        for (int i = 0; i < count; i++) {
+          dest[i] = source0[i];
+        }
+        for (size_t s = 0; s < instruction.steps.size (); s++) {
+          const Step& step = instruction.steps[s];
+          if (step.type == STEP_SCALE_BIAS) {
+            for (int i = 0; i < count; i++) {
+              dest[i] = dest[i] * step.param[0] + step.param[1];
+            }
+          } else {
+            for (int i = 0; i < count; i++) {
+              if (dest[i] < step.param[0]) {
+                dest[i] = step.param[0];
+              } else if (dest[i] > step.param[1]) {
+                dest[i] = step.param[1];
+              }
+            }
+          }
+        }
+        break;
+
+      case OP_TRANSFORM:
+        for (int axis = 0; axis < 3; axis++) {
+          const double* coord = x + axis * MODULE_BATCH_SIZE;
+          double* destCoord = dest + axis * MODULE_BATCH_SIZE;
+          for (int i = 0; i < count; i++) {
+            destCoord[i] = coord[i];
+          }
+          for (size_t s = 0; s < instruction.steps.size (); s++) {
+            const Step& step = instruction.steps[s];
+            if (step.type == STEP_SCALE_POINT) {
+              for (int i = 0; i < count; i++) {
+                destCoord[i] *= step.param[axis];
+              }
+            } else {
+              for (int i = 0; i < count; i++) {
+                destCoord[i] += step.param[axis];
+              }
+            }
+          }
+        }
+        break;
+
+      case OP_TURBULENCE:
+        static_cast<const Turbulence*> (instruction.pModule)->Displace (x, y,
+          z, dest, dest + MODULE_BATCH_SIZE, dest + 2 * MODULE_BATCH_SIZE,
+          count);
+        break;
+
+      case OP_ABS:
+        for (int i = 0; i < count; i++) {
+          dest[i] = fabs (source0[i]);
+        }
+        break;
+
+      case OP_INVERT:
+        for (int i = 0; i < count; i++) {
+          dest[i] = -(source0[i]);
+        }
+        break;
+
+      case OP_ADD:
+        for (int i = 0; i < count; i++) {
+          dest[i] = source0[i] + source1[i];
+        }
+        break;
+
+      case OP_MULTIPLY:
+        for (int i = 0; i < count; i++) {
+          dest[i] = source0[i] * source1[i];
+        }
+        break;
+
+      case OP_MAX:
+        for (int i = 0; i < count; i++) {
+          dest[i] = GetMax (source0[i], source1[i]);
+        }
+        break;
+
+      case OP_MIN:
+        for (int i = 0; i < count; i++) {
+          dest[i] = GetMin (source0[i], source1[i]);
+        }
+        break;
+
+      case OP_BLEND:
+        for (int i = 0; i < count; i++) {
+          double alpha = (source2[i] + 1.0) / 2.0;
+          dest[i] = LinearInterp (source0[i], source1[i], alpha);
+        }
+        break;
+
+      case OP_SELECT: {
+        double lowerBound = instruction.param[0];
+        double upperBound = instruction.param[1];
+        double edgeFalloff = instruction.param[2];
+        double alpha[MODULE_BATCH_SIZE];
+        int selection[MODULE_BATCH_SIZE];
+        int sources[MODULE_BATCH_SIZE];
+        int indices[2][MODULE_BATCH_SIZE];
+        int selectedCount[2] = {0, 0};
+
+        // A control module with its own block only runs on the input values
+        // that its range leaves open.
+        double controlBuffer[MODULE_BATCH_SIZE];
+        const double* controlValues = source2;
+        if (instruction.branch[2] >= 0) {
+          const Select* pSelect = static_cast<const Select*> (
+            instruction.pModule);
+          int openCount = pSelect->GetRangeSelection (x, y, z, sources,
+            count);
+          for (int i = 0, open = 0; open < openCount; i++) {
+            if (sources[i] < 0) {
+              indices[0][open++] = i;
+            }
+          }
+          RunSelected (instruction.branch[2], registers, x, y, z, indices[0],
+            openCount, controlBuffer);
+          controlValues = controlBuffer;
+        } else {
+          for (int i = 0; i < count; i++) {
+            sources[i] = -1;
+          }
+        }
+
+        for (int i = 0; i < count; i++) {
+          if (sources[i] >= 0) {
+            selection[i] = (sources[i] == 0)? SOURCE_0: SOURCE_1;
+          } else if (edgeFalloff > 0.0) {
+            double control = controlValues[i];
+            if (control < (lowerBound - edgeFalloff)) {
+              selection[i] = SOURCE_0;
+            } else if (control < (lowerBound + edgeFalloff)) {
+              double lowerCurve = (lowerBound - edgeFalloff);
+              double upperCurve = (lowerBound + edgeFalloff);
+              alpha[i] = SCurve3 (
+                (control - lowerCurve) / (upperCurve - lowerCurve));
+              selection[i] = CURVE_0_TO_1;
+            } else if (control < (upperBound - edgeFalloff)) {
+              selection[i] = SOURCE_1;
+            } else if (control < (upperBound + edgeFalloff)) {
+              double lowerCurve = (upperBound - edgeFalloff);
+              double upperCurve = (upperBound + edgeFalloff);
+              alpha[i] = SCurve3 (
+                (control - lowerCurve) / (upperCurve - lowerCurve));
+              selection[i] = CURVE_1_TO_0;
+            } else {
+              selection[i] = SOURCE_0;
+            }
+          } else {
+            double control = controlValues[i];
+            if (control < lowerBound || control > upperBound) {
+              selection[i] = SOURCE_0;
+            } else {
+              selection[i] = SOURCE_1;
+            }
+          }
+
+          if (selection[i] != SOURCE_1) {
+            indices[0][selectedCount[0]++] = i;
+          }
+          if (selection[i] != SOURCE_0) {
+            indices[1][selectedCount[1]++] = i;
+          }
+        }
+
+        // Run the block of each source module on the input values that
+        // select it.
+        double selected[2][MODULE_BATCH_SIZE];
+        const double* value[2] = {source0, source1};
+        for (int s = 0; s < 2; s++) {
+          if (instruction.branch[s] >= 0) {
+            RunSelected (instruction.branch[s], registers, x, y, z,
+              indices[s], selectedCount[s], selected[s]);
+            value[s] = selected[s];
+          }
+        }
+
+        for (int i = 0; i < count; i++) {
+          switch (selection[i]) {
+            case SOURCE_0:
+              dest[i] = value[0][i];
+              break;
+            case SOURCE_1:
+              dest[i] = value[1][i];
+              break;
+            case CURVE_0_TO_1:
+              dest[i] = LinearInterp (value[0][i], value[1][i], alpha[i]);
+              break;
+            case CURVE_1_TO_0:
+              dest[i] = LinearInterp (value[1][i], value[0][i], alpha[i]);
+              break;
+          }
+        }
+        break;
+      }
+    }
+  }
+}
+
+void Program::RunSelected (int blockIndex, double* registers,
+  const double* x, const double* y, const double* z, const int* indices,
+  int count, double* values) const
+{
+  if (count == 0) {
+    return;
+  }
+
+  const Block& block = m_blocks[blockIndex];
+  double* base = registers + block.registerBase * MODULE_BATCH_SIZE;
+  double* xBlock = GetRegister (base, 0);
+  double* yBlock = GetRegister (base, 1);
+  double* zBlock = GetRegister (base, 2);
+  for (int i = 0; i < count; i++) {
+    xBlock[i] = x[indices[i]];
+    yBlock[i] = y[indices[i]];
+    zBlock[i] = z[indices[i]];
+  }
+  Run (blockIndex, registers, count);
+  const double* result = GetRegister (base, block.result);
+  for (int i = 0; i < count; i++) {
+    values[indices[i]] = result[i];
+  }
+}
+
+void Program::SetSourceModule (int index, const Module& sourceModule)
+{
+  Module::SetSourceModule (index, sourceModule);
+  Compile (sourceModule);
+}
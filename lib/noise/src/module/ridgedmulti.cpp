@@ -30,6 +30,7 @@ RidgedMulti::RidgedMulti ():
   m_lacunarity   (DEFAULT_RIDGED_LACUNARITY  ),
   m_noiseQuality (DEFAULT_RIDGED_QUALITY     ),
   m_octaveCount  (DEFAULT_RIDGED_OCTAVE_COUNT),
+  m_period       (0),
   m_seed         (DEFAULT_RIDGED_SEED)
 {
   CalcSpectralWeights ();
@@ -50,6 +51,69 @@ void RidgedMulti::CalcSpectralWeights ()
   }
 }
 
+void RidgedMulti::GetRange (double xMin, double yMin, double zMin, double xMax,
+  double yMax, double zMax, double& lower, double& upper) const
+{
+  ScaleRange (m_frequency, xMin, xMax);
+  ScaleRange (m_frequency, yMin, yMax);
+  ScaleRange (m_frequency, zMin, zMax);
+
+  double offset = 1.0;
+  double gain = 2.0;
+
+  // Follow the signal, the weight and the output value of GetValue() with
+  // their ranges.
+  double weightLower = 1.0;
+  double weightUpper = 1.0;
+  lower = 0.0;
+  upper = 0.0;
+  double octavePeriod = m_period;
+  for (int curOctave = 0; curOctave < m_octaveCount; curOctave++) {
+    int seed = (m_seed + curOctave) & 0x7fffffff;
+    double signalLower, signalUpper;
+    if (m_period > 0) {
+      int period = MakeIntPeriod (octavePeriod);
+      double scale = (double)period / octavePeriod;
+      PeriodicGradientCoherentNoise3DRange (xMin * scale, yMin * scale,
+        zMin * scale, xMax * scale, yMax * scale, zMax * scale, signalLower,
+        signalUpper, period, seed, m_noiseQuality);
+    } else {
+      GradientCoherentNoise3DRange (xMin, yMin, zMin, xMax, yMax, zMax,
+        signalLower, signalUpper, seed, m_noiseQuality);
+    }
+
+    // Make the ridges and square them.
+    GetAbsRange (signalLower, signalUpper, signalLower, signalUpper);
+    double ridgeLower = offset - signalUpper;
+    double ridgeUpper = offset - signalLower;
+    GetAbsRange (ridgeLower, ridgeUpper, ridgeLower, ridgeUpper);
+    signalLower = ridgeLower * ridgeLower;
+    signalUpper = ridgeUpper * ridgeUpper;
+
+    // Apply the weight and calculate the next one.
+    GetProductRange (signalLower, signalUpper, weightLower, weightUpper,
+      signalLower, signalUpper);
+    weightLower = GetMax (GetMin (signalLower * gain, 1.0), 0.0);
+    weightUpper = GetMax (GetMin (signalUpper * gain, 1.0), 0.0);
+
+    double termLower, termUpper;
+    GetProductRange (signalLower, signalUpper,
+      m_pSpectralWeights[curOctave], m_pSpectralWeights[curOctave],
+      termLower, termUpper);
+    lower += termLower;
+    upper += termUpper;
+
+    // Prepare the next octave.
+    ScaleRange (m_lacunarity, xMin, xMax);
+    ScaleRange (m_lacunarity, yMin, yMax);
+    ScaleRange (m_lacunarity, zMin, zMax);
+    octavePeriod *= m_lacunarity;
+  }
+
+  lower = (lower * 1.25) - 1.0;
+  upper = (upper * 1.25) - 1.0;
+}
+
 // Multifractal code originally written by F. Kenton "Doc Mojo" Musgrave,
 // 1998.  Modified by jas for use with libnoise.
 double RidgedMulti::GetValue (double x, double y, double z) const
@@ -67,18 +131,31 @@ double RidgedMulti::GetValue (double x, double y, double z) const
   double offset = 1.0;
   double gain = 2.0;
 
+  double octavePeriod = m_period;
   for (int curOctave = 0; curOctave < m_octaveCount; curOctave++) {
 
-    // Make sure that these floating-point values have the same range as a 32-
-    // bit integer so that we can pass them to the coherent-noise functions.
     double nx, ny, nz;
-    nx = MakeInt32Range (x);
-    ny = MakeInt32Range (y);
-    nz = MakeInt32Range (z);
-
     // Get the coherent-noise value.
     int seed = (m_seed + curOctave) & 0x7fffffff;
-    signal = GradientCoherentNoise3D (nx, ny, nz, seed, m_noiseQuality);
+    if (m_period > 0) {
+      // Stretch this octave so that its period is a whole number of lattice
+      // cells, and wrap the input value into that period.
+      int period = MakeIntPeriod (octavePeriod);
+      double scale = (double)period / octavePeriod;
+      nx = MakePeriodicRange (x * scale, period);
+      ny = MakePeriodicRange (y * scale, period);
+      nz = MakePeriodicRange (z * scale, period);
+      signal = PeriodicGradientCoherentNoise3D (nx, ny, nz, period, seed,
+        m_noiseQuality);
+    } else {
+      // Make sure that these floating-point values have the same range as a
+      // 32-bit integer so that we can pass them to the coherent-noise
+      // functions.
+      nx = MakeInt32Range (x);
+      ny = MakeInt32Range (y);
+      nz = MakeInt32Range (z);
+      signal = GradientCoherentNoise3D (nx, ny, nz, seed, m_noiseQuality);
+    }
 
     // Make the ridges.
     signal = fabs (signal);
@@ -108,7 +185,90 @@ double RidgedMulti::GetValue (double x, double y, double z) const
     x *= m_lacunarity;
     y *= m_lacunarity;
     z *= m_lacunarity;
+    octavePeriod *= m_lacunarity;
   }
 
   return (value * 1.25) - 1.0;
 }
+
+void RidgedMulti::GetValues (const double* x, const double* y,
+  const double* z, double* values, int count) const
+{
+  double xCur[MODULE_BATCH_SIZE];
+  double yCur[MODULE_BATCH_SIZE];
+  double zCur[MODULE_BATCH_SIZE];
+  double nx[MODULE_BATCH_SIZE];
+  double ny[MODULE_BATCH_SIZE];
+  double nz[MODULE_BATCH_SIZE];
+  double coherentNoise[MODULE_BATCH_SIZE];
+  double weight[MODULE_BATCH_SIZE];
+
+  // Same parameters as GetValue().
+  double offset = 1.0;
+  double gain = 2.0;
+
+  for (int first = 0; first < count; first += MODULE_BATCH_SIZE) {
+    int batchSize = count - first;
+    if (batchSize > MODULE_BATCH_SIZE) {
+      batchSize = MODULE_BATCH_SIZE;
+    }
+    double* value = values + first;
+
+    for (int i = 0; i < batchSize; i++) {
+      xCur[i] = x[first + i] * m_frequency;
+      yCur[i] = y[first + i] * m_frequency;
+      zCur[i] = z[first + i] * m_frequency;
+      weight[i] = 1.0;
+      value[i] = 0.0;
+    }
+
+    double octavePeriod = m_period;
+    for (int curOctave = 0; curOctave < m_octaveCount; curOctave++) {
+      int seed = (m_seed + curOctave) & 0x7fffffff;
+      if (m_period > 0) {
+        int period = MakeIntPeriod (octavePeriod);
+        double scale = (double)period / octavePeriod;
+        for (int i = 0; i < batchSize; i++) {
+          nx[i] = MakePeriodicRange (xCur[i] * scale, period);
+          ny[i] = MakePeriodicRange (yCur[i] * scale, period);
+          nz[i] = MakePeriodicRange (zCur[i] * scale, period);
+        }
+        PeriodicGradientCoherentNoise3D (nx, ny, nz, coherentNoise,
+          batchSize, period, seed, m_noiseQuality);
+      } else {
+        for (int i = 0; i < batchSize; i++) {
+          nx[i] = MakeInt32Range (xCur[i]);
+          ny[i] = MakeInt32Range (yCur[i]);
+          nz[i] = MakeInt32Range (zCur[i]);
+        }
+        GradientCoherentNoise3D (nx, ny, nz, coherentNoise, batchSize, seed,
+          m_noiseQuality);
+      }
+
+      for (int i = 0; i < batchSize; i++) {
+        double signal = fabs (coherentNoise[i]);
+        signal = offset - signal;
+        signal *= signal;
+        signal *= weight[i];
+
+        weight[i] = signal * gain;
+        if (weight[i] > 1.0) {
+          weight[i] = 1.0;
+        }
+        if (weight[i] < 0.0) {
+          weight[i] = 0.0;
+        }
+
+        value[i] += (signal * m_pSpectralWeights[curOctave]);
+        xCur[i] *= m_lacunarity;
+        yCur[i] *= m_lacunarity;
+        zCur[i] *= m_lacunarity;
+      }
+      octavePeriod *= m_lacunarity;
+    }
+
+    for (int i = 0; i < batchSize; i++) {
+      value[i] = (value[i] * 1.25) - 1.0;
+    }
+  }
+}
@@ -31,9 +31,32 @@ ScaleBias::ScaleBias ():
 {
 }
 
+void ScaleBias::GetRange (double xMin, double yMin, double zMin, double xMax,
+  double yMax, double zMax, double& lower, double& upper) const
+{
+  assert (m_pSourceModule[0] != NULL);
+
+  m_pSourceModule[0]->GetRange (xMin, yMin, zMin, xMax, yMax, zMax, lower,
+    upper);
+  GetProductRange (lower, upper, m_scale, m_scale, lower, upper);
+  lower += m_bias;
+  upper += m_bias;
+}
+
 double ScaleBias::GetValue (double x, double y, double z) const
 {
   assert (m_pSourceModule[0] != NULL);
 
   return m_pSourceModule[0]->GetValue (x, y, z) * m_scale + m_bias;
 }
+
+void ScaleBias::GetValues (const double* x, const double* y,
+  const double* z, double* values, int count) const
+{
+  assert (m_pSourceModule[0] != NULL);
+
+  m_pSourceModule[0]->GetValues (x, y, z, values, count);
+  for (int i = 0; i < count; i++) {
+    values[i] = values[i] * m_scale + m_bias;
+  }
+}
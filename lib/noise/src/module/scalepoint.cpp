@@ -32,6 +32,18 @@ ScalePoint::ScalePoint ():
 {
 }
 
+void ScalePoint::GetRange (double xMin, double yMin, double zMin, double xMax,
+  double yMax, double zMax, double& lower, double& upper) const
+{
+  assert (m_pSourceModule[0] != NULL);
+
+  ScaleRange (m_xScale, xMin, xMax);
+  ScaleRange (m_yScale, yMin, yMax);
+  ScaleRange (m_zScale, zMin, zMax);
+  m_pSourceModule[0]->GetRange (xMin, yMin, zMin, xMax, yMax, zMax, lower,
+    upper);
+}
+
 double ScalePoint::GetValue (double x, double y, double z) const
 {
   assert (m_pSourceModule[0] != NULL);
@@ -21,6 +21,7 @@
 //
 
 #include "interp.h"
+#include "misc.h"
 #include "module/select.h"
 
 using namespace noise::module;
@@ -33,6 +34,72 @@ Select::Select ():
 {
 }
 
+void Select::GetRange (double xMin, double yMin, double zMin, double xMax,
+  double yMax, double zMax, double& lower, double& upper) const
+{
+  assert (m_pSourceModule[0] != NULL);
+  assert (m_pSourceModule[1] != NULL);
+  assert (m_pSourceModule[2] != NULL);
+
+  double controlLower, controlUpper;
+  m_pSourceModule[2]->GetRange (xMin, yMin, zMin, xMax, yMax, zMax,
+    controlLower, controlUpper);
+  int source = SelectSource (controlLower, controlUpper);
+  if (source >= 0) {
+    m_pSourceModule[source]->GetRange (xMin, yMin, zMin, xMax, yMax, zMax,
+      lower, upper);
+    return;
+  }
+
+  // The edge falloff interpolates between the two output values, which
+  // stays between them.
+  double lower0, upper0, lower1, upper1;
+  m_pSourceModule[0]->GetRange (xMin, yMin, zMin, xMax, yMax, zMax, lower0,
+    upper0);
+  m_pSourceModule[1]->GetRange (xMin, yMin, zMin, xMax, yMax, zMax, lower1,
+    upper1);
+  lower = GetMin (lower0, lower1);
+  upper = GetMax (upper0, upper1);
+}
+
+int Select::GetRangeSelection (const double* x, const double* y,
+  const double* z, int* sources, int count) const
+{
+  assert (m_pSourceModule[2] != NULL);
+
+  if (count <= 0) {
+    return 0;
+  }
+
+  double xMin = x[0], yMin = y[0], zMin = z[0];
+  double xMax = x[0], yMax = y[0], zMax = z[0];
+  for (int i = 1; i < count; i++) {
+    xMin = GetMin (xMin, x[i]);
+    yMin = GetMin (yMin, y[i]);
+    zMin = GetMin (zMin, z[i]);
+    xMax = GetMax (xMax, x[i]);
+    yMax = GetMax (yMax, y[i]);
+    zMax = GetMax (zMax, z[i]);
+  }
+  double controlLower, controlUpper;
+  m_pSourceModule[2]->GetRange (xMin, yMin, zMin, xMax, yMax, zMax,
+    controlLower, controlUpper);
+
+  int source = SelectSource (controlLower, controlUpper);
+  if (source >= 0 || count < 2 * SELECT_RANGE_SPLIT_COUNT
+    || !IsSourceSelectable (controlLower, controlUpper)) {
+    for (int i = 0; i < count; i++) {
+      sources[i] = source;
+    }
+    return (source >= 0)? 0: count;
+  }
+
+  int half = count / 2;
+  return GetRangeSelection (x, y, z, sources, half)
+    + GetRangeSelection (x + half, y + half, z + half, sources + half,
+      count - half);
+}
+
 double Select::GetValue (double x, double y, double z) const
 {
   assert (m_pSourceModule[0] != NULL);
@@ -90,6 +157,196 @@ double Select::GetValue (double x, double y, double z) const
   }
 }
 
+// Evaluates the source module for the input values listed in indices and
+// scatters the output values into values (indexed like the input values).
+// The caller only calls this function for a non-empty selection.
+static void GetSelectedValues (const Module& sourceModule, const double* x,
+  const double* y, const double* z, const int* indices, int count,
+  double* values)
+{
+  assert (count > 0 && count <= MODULE_BATCH_SIZE);
+
+  double xSel[MODULE_BATCH_SIZE];
+  double ySel[MODULE_BATCH_SIZE];
+  double zSel[MODULE_BATCH_SIZE];
+  double valueSel[MODULE_BATCH_SIZE];
+
+  int i = 0;
+  do {
+    xSel[i] = x[indices[i]];
+    ySel[i] = y[indices[i]];
+    zSel[i] = z[indices[i]];
+  } while (++i < count);
+  sourceModule.GetValues (xSel, ySel, zSel, valueSel, count);
+  for (int i = 0; i < count; i++) {
+    values[indices[i]] = valueSel[i];
+  }
+}
+
+void Select::GetValues (const double* x, const double* y, const double* z,
+  double* values, int count) const
+{
+  assert (m_pSourceModule[0] != NULL);
+  assert (m_pSourceModule[1] != NULL);
+  assert (m_pSourceModule[2] != NULL);
+
+  // How each output value is calculated; the same cases as GetValue().
+  enum {
+    SOURCE_0,
+    SOURCE_1,
+    CURVE_0_TO_1,
+    CURVE_1_TO_0
+  };
+
+  double controlValue[MODULE_BATCH_SIZE];
+  double alpha[MODULE_BATCH_SIZE];
+  double value0[MODULE_BATCH_SIZE];
+  double value1[MODULE_BATCH_SIZE];
+  int selection[MODULE_BATCH_SIZE];
+  int sources[MODULE_BATCH_SIZE];
+  int indices0[MODULE_BATCH_SIZE];
+  int indices1[MODULE_BATCH_SIZE];
+
+  for (int first = 0; first < count; first += MODULE_BATCH_SIZE) {
+    int batchSize = count - first;
+    if (batchSize > MODULE_BATCH_SIZE) {
+      batchSize = MODULE_BATCH_SIZE;
+    }
+    const double* xIn = x + first;
+    const double* yIn = y + first;
+    const double* zIn = z + first;
+    double* value = values + first;
+
+    // The control module is only evaluated for the input values that the
+    // range of the control module leaves open.
+    int controlCount = GetRangeSelection (xIn, yIn, zIn, sources, batchSize);
+    if (controlCount == batchSize) {
+      m_pSourceModule[2]->GetValues (xIn, yIn, zIn, controlValue, batchSize);
+    } else if (controlCount > 0) {
+      int openCount = 0;
+      for (int i = 0; i < batchSize; i++) {
+        if (sources[i] < 0) {
+          indices0[openCount++] = i;
+        }
+      }
+      GetSelectedValues (*m_pSourceModule[2], xIn, yIn, zIn, indices0,
+        openCount, controlValue);
+    }
+
+    // Only the source modules that an output value depends on are evaluated
+    // for it, as in GetValue().
+    int count0 = 0;
+    int count1 = 0;
+    for (int i = 0; i < batchSize; i++) {
+      if (sources[i] >= 0) {
+        selection[i] = (sources[i] == 0)? SOURCE_0: SOURCE_1;
+      } else {
+        double control = controlValue[i];
+        if (m_edgeFalloff > 0.0) {
+          if (control < (m_lowerBound - m_edgeFalloff)) {
+            selection[i] = SOURCE_0;
+          } else if (control < (m_lowerBound + m_edgeFalloff)) {
+            double lowerCurve = (m_lowerBound - m_edgeFalloff);
+            double upperCurve = (m_lowerBound + m_edgeFalloff);
+            alpha[i] = SCurve3 (
+              (control - lowerCurve) / (upperCurve - lowerCurve));
+            selection[i] = CURVE_0_TO_1;
+          } else if (control < (m_upperBound - m_edgeFalloff)) {
+            selection[i] = SOURCE_1;
+          } else if (control < (m_upperBound + m_edgeFalloff)) {
+            double lowerCurve = (m_upperBound - m_edgeFalloff);
+            double upperCurve = (m_upperBound + m_edgeFalloff);
+            alpha[i] = SCurve3 (
+              (control - lowerCurve) / (upperCurve - lowerCurve));
+            selection[i] = CURVE_1_TO_0;
+          } else {
+            selection[i] = SOURCE_0;
+          }
+        } else {
+          if (control < m_lowerBound || control > m_upperBound) {
+            selection[i] = SOURCE_0;
+          } else {
+            selection[i] = SOURCE_1;
+          }
+        }
+      }
+
+      if (selection[i] != SOURCE_1) {
+        indices0[count0++] = i;
+      }
+      if (selection[i] != SOURCE_0) {
+        indices1[count1++] = i;
+      }
+    }
+
+    if (count0 > 0) {
+      GetSelectedValues (*m_pSourceModule[0], xIn, yIn, zIn, indices0, count0,
+        value0);
+    }
+    if (count1 > 0) {
+      GetSelectedValues (*m_pSourceModule[1], xIn, yIn, zIn, indices1, count1,
+        value1);
+    }
+
+    for (int i = 0; i < batchSize; i++) {
+      switch (selection[i]) {
+        case SOURCE_0:
+          value[i] = value0[i];
+          break;
+        case SOURCE_1:
+          value[i] = value1[i];
+          break;
+        case CURVE_0_TO_1:
+          value[i] = LinearInterp (value0[i], value1[i], alpha[i]);
+          break;
+        case CURVE_1_TO_0:
+          value[i] = LinearInterp (value1[i], value0[i], alpha[i]);
+          break;
+      }
+    }
+  }
+}
+
+bool Select::IsSourceSelectable (double controlLower, double controlUpper)
+  const
+{
+  // A part of the box has control values inside this range, so its range
+  // overlaps it too; check whether that still leaves room for one of the
+  // cases of SelectSource().
+  if (m_edgeFalloff > 0.0) {
+    return controlLower < (m_lowerBound - m_edgeFalloff)
+      || controlUpper >= (m_upperBound + m_edgeFalloff)
+      || (controlUpper >= (m_lowerBound + m_edgeFalloff)
+        && controlLower < (m_upperBound - m_edgeFalloff));
+  } else {
+    return controlLower < m_lowerBound
+      || controlUpper > m_upperBound
+      || (controlUpper >= m_lowerBound && controlLower <= m_upperBound);
+  }
+}
+
+int Select::SelectSource (double controlLower, double controlUpper) const
+{
+  // The same cases as GetValue().
+  if (m_edgeFalloff > 0.0) {
+    if (controlUpper < (m_lowerBound - m_edgeFalloff)
+      || controlLower >= (m_upperBound + m_edgeFalloff)) {
+      return 0;
+    } else if (controlLower >= (m_lowerBound + m_edgeFalloff)
+      && controlUpper < (m_upperBound - m_edgeFalloff)) {
+      return 1;
+    }
+  } else {
+    if (controlUpper < m_lowerBound || controlLower > m_upperBound) {
+      return 0;
+    } else if (controlLower >= m_lowerBound
+      && controlUpper <= m_upperBound) {
+      return 1;
+    }
+  }
+  return -1;
+}
+
 void Select::SetBounds (double lowerBound, double upperBound)
 {
   assert (lowerBound < upperBound);
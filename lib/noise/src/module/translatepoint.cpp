@@ -32,6 +32,16 @@ TranslatePoint::TranslatePoint ():
 {
 }
 
+void TranslatePoint::GetRange (double xMin, double yMin, double zMin, double xMax,
+  double yMax, double zMax, double& lower, double& upper) const
+{
+  assert (m_pSourceModule[0] != NULL);
+
+  m_pSourceModule[0]->GetRange (xMin + m_xTranslation, yMin + m_yTranslation,
+    zMin + m_zTranslation, xMax + m_xTranslation, yMax + m_yTranslation,
+    zMax + m_zTranslation, lower, upper);
+}
+
 double TranslatePoint::GetValue (double x, double y, double z) const
 {
   assert (m_pSourceModule[0] != NULL);
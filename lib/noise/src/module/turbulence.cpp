@@ -20,12 +20,76 @@
 // off every 'zig'.)
 //
 
+#include <atomic>
+
 #include "module/turbulence.h"
 
 using namespace noise::module;
 
+namespace
+{
+
+  // Offsets added to the input value before each Perlin-noise module is
+  // evaluated; see GetValue().
+  const double DISTORT_OFFSET[3][3] = {
+    {12414.0 / 65536.0, 65124.0 / 65536.0, 31337.0 / 65536.0},
+    {26519.0 / 65536.0, 18128.0 / 65536.0, 60493.0 / 65536.0},
+    {53820.0 / 65536.0, 11213.0 / 65536.0, 44845.0 / 65536.0}
+  };
+
+  // A point of the displacement field of a Turbulence noise module, kept by
+  // one thread.  The noise precision the displacement was generated with is
+  // part of the key, so that switching precision never returns a stale
+  // displacement.
+  struct FieldNode
+  {
+    unsigned long long fieldId;
+    noise::NoisePrecision precision;
+    int ix, iy, iz;
+    double displacement[3];
+  };
+
+  // Number of points in the table of each thread; a power of two.
+  const int FIELD_NODE_COUNT = 2048;
+
+  // Points of the displacement field kept by the current thread.
+  // Zero-initialized, and zero is never used as an identifier, so every
+  // entry starts out empty.
+  thread_local FieldNode t_fieldNodes[FIELD_NODE_COUNT];
+
+  // Next identifier to give to a displacement field.
+  std::atomic<unsigned long long> g_nextFieldId (1);
+
+  // Input values farther than this many grid points from the origin use the
+  // exact displacement, so that the grid coordinates fit in an int.
+  const double FIELD_COORD_LIMIT = 1073741824.0;
+
+  // Largest number of grid points that one batch of input values reads
+  // together; beyond it, each input value reads its own points.
+  const int FIELD_BOX_NODE_COUNT = 512;
+
+  // Largest sum of the absolute values of the weights of a tricubic
+  // Catmull-Rom interpolation: 1.25 along each axis.
+  const double FIELD_WEIGHT_SUM = 1.25 * 1.25 * 1.25;
+
+  // Calculates the weights of the four grid points of a Catmull-Rom spline
+  // at the position a (0.0 to 1.0) between the second and third points.
+  inline void GetCatmullRomWeights (double a, double* weights)
+  {
+    double a2 = a * a;
+    double a3 = a2 * a;
+    weights[0] = 0.5 * (-a3 + 2.0 * a2 - a);
+    weights[1] = 0.5 * (3.0 * a3 - 5.0 * a2 + 2.0);
+    weights[2] = 0.5 * (-3.0 * a3 + 4.0 * a2 + a);
+    weights[3] = 0.5 * (a3 - a2);
+  }
+
+}
+
 Turbulence::Turbulence ():
   Module (GetSourceModuleCount ()),
+  m_fieldId (g_nextFieldId++),
+  m_fieldResolution (DEFAULT_TURBULENCE_FIELD_RESOLUTION),
   m_power (DEFAULT_TURBULENCE_POWER)
 {
   SetSeed (DEFAULT_TURBULENCE_SEED);
@@ -33,6 +97,179 @@ Turbulence::Turbulence ():
   SetRoughness (DEFAULT_TURBULENCE_ROUGHNESS);
 }
 
+void Turbulence::GetExactDisplacement (double x, double y, double z,
+  double* displacement) const
+{
+  const Perlin* pDistortModule[3] = {
+    &m_xDistortModule, &m_yDistortModule, &m_zDistortModule
+  };
+  for (int i = 0; i < 3; i++) {
+    displacement[i] = pDistortModule[i]->Perlin::GetValue (
+      x + DISTORT_OFFSET[i][0], y + DISTORT_OFFSET[i][1],
+      z + DISTORT_OFFSET[i][2]);
+  }
+}
+
+void Turbulence::GetFieldDisplacement (const double* x, const double* y,
+  const double* z, double* xDisplace, double* yDisplace, double* zDisplace,
+  int count) const
+{
+  assert (count <= MODULE_BATCH_SIZE);
+
+  // Along each axis, each input value reads the four grid points around it
+  // with Catmull-Rom weights, or only the grid point it lies on.
+  const double* coord[3] = {x, y, z};
+  double* displace[3] = {xDisplace, yDisplace, zDisplace};
+  int firstNode[3][MODULE_BATCH_SIZE];
+  int nodeCount[3][MODULE_BATCH_SIZE];
+  double weight[3][MODULE_BATCH_SIZE][4];
+  bool isExact[MODULE_BATCH_SIZE];
+  int gridCount = 0;
+  int grid[MODULE_BATCH_SIZE];
+  double spacing = GetFieldSpacing ();
+  for (int i = 0; i < count; i++) {
+    isExact[i] = false;
+    for (int axis = 0; axis < 3; axis++) {
+      double u = coord[axis][i] / spacing;
+      if (!(fabs (u) < FIELD_COORD_LIMIT)) {
+        isExact[i] = true;
+        break;
+      }
+      int cell = (int)u;
+      if (cell > u) {
+        cell--;
+      }
+      double a = u - cell;
+      if (a == 0.0) {
+        firstNode[axis][i] = cell;
+        nodeCount[axis][i] = 1;
+        weight[axis][i][0] = 1.0;
+      } else {
+        firstNode[axis][i] = cell - 1;
+        nodeCount[axis][i] = 4;
+        GetCatmullRomWeights (a, weight[axis][i]);
+      }
+    }
+    if (isExact[i]) {
+      double displacement[3];
+      GetExactDisplacement (x[i], y[i], z[i], displacement);
+      xDisplace[i] = displacement[0];
+      yDisplace[i] = displacement[1];
+      zDisplace[i] = displacement[2];
+    } else {
+      grid[gridCount++] = i;
+    }
+  }
+  if (gridCount == 0) {
+    return;
+  }
+
+  // Read the grid points of the whole batch at once if they fit in a small
+  // box, otherwise read the grid points of each input value on its own.
+  // The output values do not depend on the choice.
+  int boxMin[3];
+  int boxMax[3];
+  for (int axis = 0; axis < 3; axis++) {
+    boxMin[axis] = firstNode[axis][grid[0]];
+    boxMax[axis] = boxMin[axis] + nodeCount[axis][grid[0]] - 1;
+    for (int n = 1; n < gridCount; n++) {
+      int i = grid[n];
+      boxMin[axis] = GetMin (boxMin[axis], firstNode[axis][i]);
+      boxMax[axis] = GetMax (boxMax[axis],
+        firstNode[axis][i] + nodeCount[axis][i] - 1);
+    }
+  }
+  double boxVolume = 1.0;
+  for (int axis = 0; axis < 3; axis++) {
+    boxVolume *= (double)boxMax[axis] - boxMin[axis] + 1.0;
+  }
+  int groupSize = (boxVolume <= FIELD_BOX_NODE_COUNT)? gridCount: 1;
+
+  double box[FIELD_BOX_NODE_COUNT][3];
+  for (int group = 0; group < gridCount; group += groupSize) {
+    if (groupSize == 1) {
+      for (int axis = 0; axis < 3; axis++) {
+        boxMin[axis] = firstNode[axis][grid[group]];
+        boxMax[axis] = boxMin[axis] + nodeCount[axis][grid[group]] - 1;
+      }
+    }
+    int xSize = boxMax[0] - boxMin[0] + 1;
+    int ySize = boxMax[1] - boxMin[1] + 1;
+    int zSize = boxMax[2] - boxMin[2] + 1;
+    for (int iz = 0; iz < zSize; iz++) {
+      for (int iy = 0; iy < ySize; iy++) {
+        for (int ix = 0; ix < xSize; ix++) {
+          const double* node = GetFieldNode (boxMin[0] + ix, boxMin[1] + iy,
+            boxMin[2] + iz);
+          double* boxNode = box[(iz * ySize + iy) * xSize + ix];
+          boxNode[0] = node[0];
+          boxNode[1] = node[1];
+          boxNode[2] = node[2];
+        }
+      }
+    }
+
+    for (int n = group; n < group + groupSize; n++) {
+      int i = grid[n];
+      double displacement[3] = {0.0, 0.0, 0.0};
+      for (int k = 0; k < nodeCount[2][i]; k++) {
+        for (int j = 0; j < nodeCount[1][i]; j++) {
+          double yzWeight = weight[2][i][k] * weight[1][i][j];
+          const double* row = box[((firstNode[2][i] - boxMin[2] + k) * ySize
+            + (firstNode[1][i] - boxMin[1] + j)) * xSize
+            + (firstNode[0][i] - boxMin[0])];
+          const double* xWeight = weight[0][i];
+          if (nodeCount[0][i] == 4) {
+            for (int axis = 0; axis < 3; axis++) {
+              displacement[axis] += yzWeight * (xWeight[0] * row[axis]
+                + xWeight[1] * row[axis + 3] + xWeight[2] * row[axis + 6]
+                + xWeight[3] * row[axis + 9]);
+            }
+          } else {
+            for (int axis = 0; axis < 3; axis++) {
+              displacement[axis] += yzWeight * row[axis];
+            }
+          }
+        }
+      }
+      for (int axis = 0; axis < 3; axis++) {
+        displace[axis][i] = displacement[axis];
+      }
+    }
+  }
+}
+
+const double* Turbulence::GetFieldNode (int ix, int iy, int iz) const
+{
+  // Unsigned arithmetic: the grid coordinates reach FIELD_COORD_LIMIT, so
+  // the products would overflow an int.
+  FieldNode& node = t_fieldNodes[(1619u * (unsigned int)ix
+    + 31337u * (unsigned int)iy + 6971u * (unsigned int)iz
+    + 1013u * (unsigned int)m_fieldId) & (FIELD_NODE_COUNT - 1)];
+  NoisePrecision precision = GetNoisePrecision ();
+  if (!(node.fieldId == m_fieldId && node.precision == precision
+    && node.ix == ix && node.iy == iy && node.iz == iz)) {
+    double spacing = GetFieldSpacing ();
+    GetExactDisplacement (ix * spacing, iy * spacing, iz * spacing,
+      node.displacement);
+    node.fieldId = m_fieldId;
+    node.precision = precision;
+    node.ix = ix;
+    node.iy = iy;
+    node.iz = iz;
+  }
+  return node.displacement;
+}
+
+double Turbulence::GetFieldSpacing () const
+{
+  double highestFrequency = GetFrequency ();
+  for (int i = 1; i < GetRoughnessCount (); i++) {
+    highestFrequency *= m_xDistortModule.GetLacunarity ();
+  }
+  return 1.0 / (highestFrequency * m_fieldResolution);
+}
+
 double Turbulence::GetFrequency () const
 {
   // Since each noise::module::Perlin noise module has the same frequency, it
@@ -40,6 +277,50 @@ double Turbulence::GetFrequency () const
   return m_xDistortModule.GetFrequency ();
 }
 
+void Turbulence::GetRange (double xMin, double yMin, double zMin, double xMax,
+  double yMax, double zMax, double& lower, double& upper) const
+{
+  assert (m_pSourceModule[0] != NULL);
+
+  // Bound the displacement along each axis with the range of its
+  // noise::module::Perlin noise module over the offset box, and take the
+  // range of the source module over the box grown by that displacement.
+  // The displacement field reads grid points up to two grid spacings away,
+  // and its interpolation may overshoot them.
+  const double (&offset)[3][3] = DISTORT_OFFSET;
+  double fieldMargin = 0.0;
+  if (m_fieldResolution > 0) {
+    fieldMargin = 2.0 * GetFieldSpacing ();
+  }
+  const Perlin* pDistortModule[3] = {
+    &m_xDistortModule, &m_yDistortModule, &m_zDistortModule
+  };
+  double boxMin[3] = {xMin, yMin, zMin};
+  double boxMax[3] = {xMax, yMax, zMax};
+  if (m_power != 0.0) {
+    for (int i = 0; i < 3; i++) {
+      double distortLower, distortUpper;
+      pDistortModule[i]->GetRange (xMin - fieldMargin + offset[i][0],
+        yMin - fieldMargin + offset[i][1], zMin - fieldMargin + offset[i][2],
+        xMax + fieldMargin + offset[i][0], yMax + fieldMargin + offset[i][1],
+        zMax + fieldMargin + offset[i][2], distortLower, distortUpper);
+      if (m_fieldResolution > 0) {
+        double overshoot = (FIELD_WEIGHT_SUM - 1.0) * 0.5
+          * (distortUpper - distortLower);
+        distortLower -= overshoot;
+        distortUpper += overshoot;
+      }
+      GetProductRange (distortLower, distortUpper, m_power, m_power,
+        distortLower, distortUpper);
+      boxMin[i] += distortLower;
+      boxMax[i] += distortUpper;
+    }
+  }
+
+  m_pSourceModule[0]->GetRange (boxMin[0], boxMin[1], boxMin[2], boxMax[0],
+    boxMax[1], boxMax[2], lower, upper);
+}
+
 int Turbulence::GetSeed () const
 {
   return m_xDistortModule.GetSeed ();
@@ -49,6 +330,14 @@ double Turbulence::GetValue (double x, double y, double z) const
 {
   assert (m_pSourceModule[0] != NULL);
 
+  if (m_fieldResolution > 0) {
+    double displacement[3];
+    GetFieldDisplacement (&x, &y, &z, &displacement[0], &displacement[1],
+      &displacement[2], 1);
+    return m_pSourceModule[0]->GetValue (x + (displacement[0] * m_power),
+      y + (displacement[1] * m_power), z + (displacement[2] * m_power));
+  }
+
   // Get the values from the three noise::module::Perlin noise modules and
   // add each value to each coordinate of the input value.  There are also
   // some offsets added to the coordinates of the input values.  This prevents
@@ -80,6 +369,75 @@ double Turbulence::GetValue (double x, double y, double z) const
   return m_pSourceModule[0]->GetValue (xDistort, yDistort, zDistort);
 }
 
+void Turbulence::Displace (const double* x, const double* y,
+  const double* z, double* xDistort, double* yDistort, double* zDistort,
+  int count) const
+{
+  double xOffset[MODULE_BATCH_SIZE];
+  double yOffset[MODULE_BATCH_SIZE];
+  double zOffset[MODULE_BATCH_SIZE];
+
+  for (int first = 0; first < count; first += MODULE_BATCH_SIZE) {
+    int batchSize = count - first;
+    if (batchSize > MODULE_BATCH_SIZE) {
+      batchSize = MODULE_BATCH_SIZE;
+    }
+    const double* xIn = x + first;
+    const double* yIn = y + first;
+    const double* zIn = z + first;
+    double* xOut = xDistort + first;
+    double* yOut = yDistort + first;
+    double* zOut = zDistort + first;
+
+    if (m_fieldResolution > 0) {
+      GetFieldDisplacement (xIn, yIn, zIn, xOut, yOut, zOut, batchSize);
+    } else {
+      // Same offsets as GetValue(); each distortion module evaluates the
+      // whole batch before the next one.
+      const Perlin* pDistortModule[3] = {
+        &m_xDistortModule, &m_yDistortModule, &m_zDistortModule
+      };
+      double* out[3] = {xOut, yOut, zOut};
+      for (int axis = 0; axis < 3; axis++) {
+        for (int i = 0; i < batchSize; i++) {
+          xOffset[i] = xIn[i] + DISTORT_OFFSET[axis][0];
+          yOffset[i] = yIn[i] + DISTORT_OFFSET[axis][1];
+          zOffset[i] = zIn[i] + DISTORT_OFFSET[axis][2];
+        }
+        pDistortModule[axis]->Perlin::GetValues (xOffset, yOffset, zOffset,
+          out[axis], batchSize);
+      }
+    }
+
+    for (int i = 0; i < batchSize; i++) {
+      xOut[i] = xIn[i] + (xOut[i] * m_power);
+      yOut[i] = yIn[i] + (yOut[i] * m_power);
+      zOut[i] = zIn[i] + (zOut[i] * m_power);
+    }
+  }
+}
+
+void Turbulence::GetValues (const double* x, const double* y,
+  const double* z, double* values, int count) const
+{
+  assert (m_pSourceModule[0] != NULL);
+
+  double xDistort[MODULE_BATCH_SIZE];
+  double yDistort[MODULE_BATCH_SIZE];
+  double zDistort[MODULE_BATCH_SIZE];
+
+  for (int first = 0; first < count; first += MODULE_BATCH_SIZE) {
+    int batchSize = count - first;
+    if (batchSize > MODULE_BATCH_SIZE) {
+      batchSize = MODULE_BATCH_SIZE;
+    }
+    Displace (x + first, y + first, z + first, xDistort, yDistort, zDistort,
+      batchSize);
+    m_pSourceModule[0]->GetValues (xDistort, yDistort, zDistort,
+      values + first, batchSize);
+  }
+}
+
 void Turbulence::SetSeed (int seed)
 {
   // Set the seed of each noise::module::Perlin noise modules.  To prevent any
@@ -88,4 +446,19 @@ void Turbulence::SetSeed (int seed)
   m_xDistortModule.SetSeed (seed    );
   m_yDistortModule.SetSeed (seed + 1);
   m_zDistortModule.SetSeed (seed + 2);
+  ResetField ();
+}
+
+void Turbulence::ResetField ()
+{
+  m_fieldId = g_nextFieldId++;
+}
+
+void Turbulence::SetFieldResolution (int resolution)
+{
+  if (resolution < 0) {
+    throw noise::ExceptionInvalidParam ();
+  }
+  m_fieldResolution = resolution;
+  ResetField ();
 }
@@ -30,49 +30,128 @@ Voronoi::Voronoi ():
   m_displacement   (DEFAULT_VORONOI_DISPLACEMENT),
   m_enableDistance (false                       ),
   m_frequency      (DEFAULT_VORONOI_FREQUENCY   ),
+  m_period         (0                           ),
   m_seed           (DEFAULT_VORONOI_SEED        )
 {
 }
 
-double Voronoi::GetValue (double x, double y, double z) const
+// Wraps a cell coordinate into the period; a period of 0 leaves it
+// unchanged.
+static inline int WrapCell (int cell, int period)
 {
-  // This method could be more efficient by caching the seed values.  Fix
-  // later.
+  if (period == 0) {
+    return cell;
+  }
+  cell %= period;
+  return (cell < 0)? cell + period: cell;
+}
 
-  x *= m_frequency;
-  y *= m_frequency;
-  z *= m_frequency;
+void Voronoi::GetRange (double /*xMin*/, double /*yMin*/, double /*zMin*/,
+  double /*xMax*/, double /*yMax*/, double /*zMax*/, double& lower,
+  double& upper) const
+{
+  // The nearest seed point is no farther than the seed point of the cube
+  // around the input value, which is less than two units away along each
+  // axis.
+  if (m_enableDistance) {
+    lower = -1.0;
+    upper = (2.0 * SQRT_3) * SQRT_3 - 1.0;
+  } else {
+    lower = 0.0;
+    upper = 0.0;
+  }
+
+  // ValueNoise3D() ranges from -1.0 to 1.0.
+  lower -= fabs (m_displacement);
+  upper += fabs (m_displacement);
+}
+
+// Seed points of a box of unit cubes, for the input values of one batch.
+struct Voronoi::SeedBox
+{
+  // Lowest cube of the box, and its number of cubes along each axis.
+  int xMin, yMin, zMin;
+  int xSize, ySize, zSize;
+  // Position of the seed point of each cube; x varies fastest.
+  double pos[VORONOI_BOX_CELL_COUNT][3];
+};
+
+// Order in which the cubes around an input value are searched along each
+// axis, relative to the cube that holds it: the cubes that may hold the
+// nearest seed point come first.
+static const int CELL_ORDER[5] = {0, 1, -1, 2, -2};
 
+// Returns the smallest distance, along one axis, from a coordinate to the
+// seed point of a cube.  A seed point is at most one unit away from the
+// lower corner of its cube, so it lies between cur - 1 and cur + 1.
+static inline double GetSeedDistanceBound (int cur, double coord)
+{
+  double below = (cur - 1) - coord;
+  double above = coord - (cur + 1);
+  return noise::GetMax (0.0, noise::GetMax (below, above));
+}
+
+double Voronoi::GetCellValue (double x, double y, double z,
+  const SeedBox* pBox) const
+{
   int xInt = (x > 0.0? (int)x: (int)x - 1);
   int yInt = (y > 0.0? (int)y: (int)y - 1);
   int zInt = (z > 0.0? (int)z: (int)z - 1);
 
   double minDist = 2147483647.0;
+  int minIndex = -1;
   double xCandidate = 0;
   double yCandidate = 0;
   double zCandidate = 0;
 
   // Inside each unit cube, there is a seed point at a random position.  Go
   // through each of the nearby cubes until we find a cube with a seed point
-  // that is closest to the specified position.
-  for (int zCur = zInt - 2; zCur <= zInt + 2; zCur++) {
-    for (int yCur = yInt - 2; yCur <= yInt + 2; yCur++) {
-      for (int xCur = xInt - 2; xCur <= xInt + 2; xCur++) {
-
-        // Calculate the position and distance to the seed point inside of
-        // this unit cube.
-        double xPos = xCur + ValueNoise3D (xCur, yCur, zCur, m_seed    );
-        double yPos = yCur + ValueNoise3D (xCur, yCur, zCur, m_seed + 1);
-        double zPos = zCur + ValueNoise3D (xCur, yCur, zCur, m_seed + 2);
+  // that is closest to the specified position.  The cubes are searched
+  // from the nearest ones, and a layer or a row of cubes is skipped when
+  // even its closest possible seed point is farther than the nearest one
+  // found so far.  A tie goes to the cube that comes first in z, y, x
+  // order, so the nearest seed point does not depend on the search order.
+  for (int k = 0; k < 5; k++) {
+    int zCur = zInt + CELL_ORDER[k];
+    double zBound = GetSeedDistanceBound (zCur, z);
+    double zBound2 = zBound * zBound;
+    if (zBound2 > minDist) {
+      continue;
+    }
+    for (int j = 0; j < 5; j++) {
+      int yCur = yInt + CELL_ORDER[j];
+      double yBound = GetSeedDistanceBound (yCur, y);
+      if (yBound * yBound + zBound2 > minDist) {
+        continue;
+      }
+
+      // Positions of the seed points of the row of cubes.
+      double rowBuffer[5][3];
+      const double (*row)[3] = rowBuffer;
+      if (pBox != NULL) {
+        row = &pBox->pos[((zCur - pBox->zMin) * pBox->ySize
+          + (yCur - pBox->yMin)) * pBox->xSize + (xInt - 2 - pBox->xMin)];
+      } else {
+        for (int i = 0; i < 5; i++) {
+          GetSeedPoint (xInt - 2 + i, yCur, zCur, rowBuffer[i]);
+        }
+      }
+
+      for (int i = 0; i < 5; i++) {
+        double xPos = row[i][0];
+        double yPos = row[i][1];
+        double zPos = row[i][2];
         double xDist = xPos - x;
         double yDist = yPos - y;
         double zDist = zPos - z;
         double dist = xDist * xDist + yDist * yDist + zDist * zDist;
+        int index = ((zCur - zInt + 2) * 5 + (yCur - yInt + 2)) * 5 + i;
 
-        if (dist < minDist) {
+        if (dist < minDist || (dist == minDist && index < minIndex)) {
           // This seed point is closer to any others found so far, so record
           // this seed point.
           minDist = dist;
+          minIndex = index;
           xCandidate = xPos;
           yCandidate = yPos;
           zCandidate = zPos;
@@ -95,7 +174,110 @@ double Voronoi::GetValue (double x, double y, double z) const
 
   // Return the calculated distance with the displacement value applied.
   return value + (m_displacement * (double)ValueNoise3D (
-    (int)(floor (xCandidate)),
-    (int)(floor (yCandidate)),
-    (int)(floor (zCandidate))));
+    WrapCell ((int)(floor (xCandidate)), m_period),
+    WrapCell ((int)(floor (yCandidate)), m_period),
+    WrapCell ((int)(floor (zCandidate)), m_period)));
+}
+
+void Voronoi::GetSeedPoint (int xCur, int yCur, int zCur, double* pos) const
+{
+  // With a period, the cube takes its seed point from the cube that it
+  // repeats.
+  int xCell = WrapCell (xCur, m_period);
+  int yCell = WrapCell (yCur, m_period);
+  int zCell = WrapCell (zCur, m_period);
+  pos[0] = xCur + ValueNoise3D (xCell, yCell, zCell, m_seed    );
+  pos[1] = yCur + ValueNoise3D (xCell, yCell, zCell, m_seed + 1);
+  pos[2] = zCur + ValueNoise3D (xCell, yCell, zCell, m_seed + 2);
+}
+
+double Voronoi::GetValue (double x, double y, double z) const
+{
+  x *= m_frequency;
+  y *= m_frequency;
+  z *= m_frequency;
+
+  if (m_period > 0) {
+    // Periodic cells: move the input value into the first period.  The
+    // cells around it are wrapped by GetSeedPoint().
+    x = MakePeriodicRange (x, m_period);
+    y = MakePeriodicRange (y, m_period);
+    z = MakePeriodicRange (z, m_period);
+  }
+
+  return GetCellValue (x, y, z, NULL);
+}
+
+void Voronoi::GetValues (const double* x, const double* y, const double* z,
+  double* values, int count) const
+{
+  double xCell[MODULE_BATCH_SIZE];
+  double yCell[MODULE_BATCH_SIZE];
+  double zCell[MODULE_BATCH_SIZE];
+  SeedBox box;
+
+  for (int first = 0; first < count; first += MODULE_BATCH_SIZE) {
+    int batchSize = count - first;
+    if (batchSize > MODULE_BATCH_SIZE) {
+      batchSize = MODULE_BATCH_SIZE;
+    }
+
+    // Same coordinates as GetValue().
+    for (int i = 0; i < batchSize; i++) {
+      xCell[i] = x[first + i] * m_frequency;
+      yCell[i] = y[first + i] * m_frequency;
+      zCell[i] = z[first + i] * m_frequency;
+      if (m_period > 0) {
+        xCell[i] = MakePeriodicRange (xCell[i], m_period);
+        yCell[i] = MakePeriodicRange (yCell[i], m_period);
+        zCell[i] = MakePeriodicRange (zCell[i], m_period);
+      }
+    }
+
+    // Calculate the seed points of the cubes around the whole batch once,
+    // if they fit in the box.
+    const double* coord[3] = {xCell, yCell, zCell};
+    int boxMin[3];
+    int boxMax[3];
+    for (int axis = 0; axis < 3; axis++) {
+      for (int i = 0; i < batchSize; i++) {
+        double c = coord[axis][i];
+        int cur = (c > 0.0? (int)c: (int)c - 1);
+        if (i == 0 || cur < boxMin[axis]) {
+          boxMin[axis] = cur;
+        }
+        if (i == 0 || cur > boxMax[axis]) {
+          boxMax[axis] = cur;
+        }
+      }
+    }
+    double cellCount = 1.0;
+    for (int axis = 0; axis < 3; axis++) {
+      cellCount *= (double)boxMax[axis] - boxMin[axis] + 5.0;
+    }
+
+    const SeedBox* pBox = NULL;
+    if (cellCount <= VORONOI_BOX_CELL_COUNT) {
+      box.xMin = boxMin[0] - 2;
+      box.yMin = boxMin[1] - 2;
+      box.zMin = boxMin[2] - 2;
+      box.xSize = boxMax[0] - boxMin[0] + 5;
+      box.ySize = boxMax[1] - boxMin[1] + 5;
+      box.zSize = boxMax[2] - boxMin[2] + 5;
+      int n = 0;
+      for (int zCur = 0; zCur < box.zSize; zCur++) {
+        for (int yCur = 0; yCur < box.ySize; yCur++) {
+          for (int xCur = 0; xCur < box.xSize; xCur++) {
+            GetSeedPoint (box.xMin + xCur, box.yMin + yCur, box.zMin + zCur,
+              box.pos[n++]);
+          }
+        }
+      }
+      pBox = &box;
+    }
+
+    for (int i = 0; i < batchSize; i++) {
+      values[first + i] = GetCellValue (xCell[i], yCell[i], zCell[i], pBox);
+    }
+  }
 }
@@ -22,6 +22,7 @@
 
 #include "noisegen.h"
 #include "interp.h"
+#include "range.h"
 #include "vectortable.h"
 
 using namespace noise;
@@ -55,8 +56,50 @@ const int SEED_NOISE_GEN = 1013;
 const int SHIFT_NOISE_GEN = 8;
 #endif
 
-double noise::GradientCoherentNoise3D (double x, double y, double z, int seed,
-  NoiseQuality noiseQuality)
+// Gradient noise at the lattice point (ix, iy, iz), with the gradient vector
+// chosen from the lattice point (hx, hy, hz).  Periodic noise passes the
+// lattice point wrapped into the period.
+static inline double GradientNoise3DWrapped (double fx, double fy, double fz,
+  int ix, int iy, int iz, int hx, int hy, int hz, int seed)
+{
+  // Randomly generate a gradient vector given the integer coordinates of the
+  // input value.  This implementation generates a random number and uses it
+  // as an index into a normalized-vector lookup table.  The hash wraps
+  // around, so it is calculated in unsigned arithmetic.
+  int vectorIndex = (int)(
+      (unsigned int)X_NOISE_GEN    * (unsigned int)hx
+    + (unsigned int)Y_NOISE_GEN    * (unsigned int)hy
+    + (unsigned int)Z_NOISE_GEN    * (unsigned int)hz
+    + (unsigned int)SEED_NOISE_GEN * (unsigned int)seed);
+  vectorIndex ^= (vectorIndex >> SHIFT_NOISE_GEN);
+  vectorIndex &= 0xff;
+
+  double xvGradient = g_randomVectors[(vectorIndex << 2)    ];
+  double yvGradient = g_randomVectors[(vectorIndex << 2) + 1];
+  double zvGradient = g_randomVectors[(vectorIndex << 2) + 2];
+
+  // Set up us another vector equal to the distance between the two vectors
+  // passed to this function.
+  double xvPoint = (fx - (double)ix);
+  double yvPoint = (fy - (double)iy);
+  double zvPoint = (fz - (double)iz);
+
+  // Now compute the dot product of the gradient vector with the distance
+  // vector.  The resulting value is gradient noise.  Apply a scaling value
+  // so that this noise value ranges from -1.0 to 1.0.
+  return ((xvGradient * xvPoint)
+    + (yvGradient * yvPoint)
+    + (zvGradient * zvPoint)) * 2.12;
+}
+
+// Body of GradientCoherentNoise3D() and PeriodicGradientCoherentNoise3D().
+// The cube corners are wrapped into [0, period) before they select a
+// gradient vector.  The input coordinates are already in [0, period), so
+// only a lower corner of -1 (at a coordinate of exactly 0.0) and an upper
+// corner of period need wrapping.  With a period of 0 both wraps leave the
+// corners unchanged.
+static inline double GradientCoherentNoise3DWrapped (double x, double y,
+  double z, int period, int seed, NoiseQuality noiseQuality)
 {
   // Create a unit-length cube aligned along an integer boundary.  This cube
   // surrounds the input point.
@@ -66,6 +109,12 @@ double noise::GradientCoherentNoise3D (double x, double y, double z, int seed,
   int y1 = y0 + 1;
   int z0 = (z > 0.0? (int)z: (int)z - 1);
   int z1 = z0 + 1;
+  int hx0 = (x0 < 0)? x0 + period: x0;
+  int hx1 = (x1 == period)? 0: x1;
+  int hy0 = (y0 < 0)? y0 + period: y0;
+  int hy1 = (y1 == period)? 0: y1;
+  int hz0 = (z0 < 0)? z0 + period: z0;
+  int hz1 = (z1 == period)? 0: z1;
 
   // Map the difference between the coordinates of the input value and the
   // coordinates of the cube's outer-lower-left vertex onto an S-curve.
@@ -93,69 +142,1461 @@ double noise::GradientCoherentNoise3D (double x, double y, double z, int seed,
   // noise values using the S-curve value as the interpolant (trilinear
   // interpolation.)
   double n0, n1, ix0, ix1, iy0, iy1;
-  n0   = GradientNoise3D (x, y, z, x0, y0, z0, seed);
-  n1   = GradientNoise3D (x, y, z, x1, y0, z0, seed);
+  n0   = GradientNoise3DWrapped (x, y, z, x0, y0, z0,
+    hx0, hy0, hz0, seed);
+  n1   = GradientNoise3DWrapped (x, y, z, x1, y0, z0,
+    hx1, hy0, hz0, seed);
   ix0  = LinearInterp (n0, n1, xs);
-  n0   = GradientNoise3D (x, y, z, x0, y1, z0, seed);
-  n1   = GradientNoise3D (x, y, z, x1, y1, z0, seed);
+  n0   = GradientNoise3DWrapped (x, y, z, x0, y1, z0,
+    hx0, hy1, hz0, seed);
+  n1   = GradientNoise3DWrapped (x, y, z, x1, y1, z0,
+    hx1, hy1, hz0, seed);
   ix1  = LinearInterp (n0, n1, xs);
   iy0  = LinearInterp (ix0, ix1, ys);
-  n0   = GradientNoise3D (x, y, z, x0, y0, z1, seed);
-  n1   = GradientNoise3D (x, y, z, x1, y0, z1, seed);
+  n0   = GradientNoise3DWrapped (x, y, z, x0, y0, z1,
+    hx0, hy0, hz1, seed);
+  n1   = GradientNoise3DWrapped (x, y, z, x1, y0, z1,
+    hx1, hy0, hz1, seed);
   ix0  = LinearInterp (n0, n1, xs);
-  n0   = GradientNoise3D (x, y, z, x0, y1, z1, seed);
-  n1   = GradientNoise3D (x, y, z, x1, y1, z1, seed);
+  n0   = GradientNoise3DWrapped (x, y, z, x0, y1, z1,
+    hx0, hy1, hz1, seed);
+  n1   = GradientNoise3DWrapped (x, y, z, x1, y1, z1,
+    hx1, hy1, hz1, seed);
   ix1  = LinearInterp (n0, n1, xs);
   iy1  = LinearInterp (ix0, ix1, ys);
 
   return LinearInterp (iy0, iy1, zs);
 }
 
-double noise::GradientNoise3D (double fx, double fy, double fz, int ix,
-  int iy, int iz, int seed)
+/////////////////////////////////////////////////////////////////////////////
+// Single-precision version of GradientCoherentNoise3D()
+//
+// The cube corners are found in double precision, like in
+// GradientCoherentNoise3DWrapped(); the distance from the lower corner is
+// then rounded to float and everything else is calculated in float, in the
+// same order as the double-precision version.  The gradient vectors are
+// g_randomVectors rounded to float.
+
+// Precision of the calling thread; see SetNoisePrecision().
+static thread_local NoisePrecision t_noisePrecision = PRECISION_DOUBLE;
+
+NoisePrecision noise::GetNoisePrecision ()
 {
-  // Randomly generate a gradient vector given the integer coordinates of the
-  // input value.  This implementation generates a random number and uses it
-  // as an index into a normalized-vector lookup table.
-  int vectorIndex = (
-      X_NOISE_GEN    * ix
-    + Y_NOISE_GEN    * iy
-    + Z_NOISE_GEN    * iz
-    + SEED_NOISE_GEN * seed)
-    & 0xffffffff;
+  return t_noisePrecision;
+}
+
+void noise::SetNoisePrecision (NoisePrecision noisePrecision)
+{
+  t_noisePrecision = noisePrecision;
+}
+
+// g_randomVectors rounded to float.  It is built on first use, so noise
+// generated during static initialization may use it too.
+static const float* GetRandomVectorsSingle ()
+{
+  static const struct RandomVectorsSingle {
+    float values[256 * 4];
+    RandomVectorsSingle ()
+    {
+      for (int i = 0; i < 256 * 4; i++) {
+        values[i] = (float)g_randomVectors[i];
+      }
+    }
+  } randomVectors;
+  return randomVectors.values;
+}
+
+// GradientNoise3DWrapped() in single precision, from the distance vector
+// between the lattice point and the input value.  The hash is calculated
+// in unsigned arithmetic, which wraps around like the 32-bit int
+// arithmetic of the double-precision version.
+static inline float GradientNoise3DSingle (float xvPoint, float yvPoint,
+  float zvPoint, int hx, int hy, int hz, int seed,
+  const float* randomVectors)
+{
+  int vectorIndex = (int)(
+      (unsigned int)X_NOISE_GEN    * (unsigned int)hx
+    + (unsigned int)Y_NOISE_GEN    * (unsigned int)hy
+    + (unsigned int)Z_NOISE_GEN    * (unsigned int)hz
+    + (unsigned int)SEED_NOISE_GEN * (unsigned int)seed);
   vectorIndex ^= (vectorIndex >> SHIFT_NOISE_GEN);
   vectorIndex &= 0xff;
 
-  double xvGradient = g_randomVectors[(vectorIndex << 2)    ];
-  double yvGradient = g_randomVectors[(vectorIndex << 2) + 1];
-  double zvGradient = g_randomVectors[(vectorIndex << 2) + 2];
+  const float* gradient = randomVectors + (vectorIndex << 2);
+  return ((gradient[0] * xvPoint)
+    + (gradient[1] * yvPoint)
+    + (gradient[2] * zvPoint)) * 2.12f;
+}
 
-  // Set up us another vector equal to the distance between the two vectors
-  // passed to this function.
-  double xvPoint = (fx - (double)ix);
-  double yvPoint = (fy - (double)iy);
-  double zvPoint = (fz - (double)iz);
+static inline float LinearInterpSingle (float n0, float n1, float a)
+{
+  return ((1.0f - a) * n0) + (a * n1);
+}
 
-  // Now compute the dot product of the gradient vector with the distance
-  // vector.  The resulting value is gradient noise.  Apply a scaling value
-  // so that this noise value ranges from -1.0 to 1.0.
-  return ((xvGradient * xvPoint)
-    + (yvGradient * yvPoint)
-    + (zvGradient * zvPoint)) * 2.12;
+static inline float SCurveSingle (float a, NoiseQuality noiseQuality)
+{
+  switch (noiseQuality) {
+    case QUALITY_STD:
+      return (a * a * (3.0f - 2.0f * a));
+    case QUALITY_BEST: {
+      float a3 = a * a * a;
+      float a4 = a3 * a;
+      float a5 = a4 * a;
+      return (6.0f * a5) - (15.0f * a4) + (10.0f * a3);
+    }
+    default:
+      return a;
+  }
+}
+
+// GradientCoherentNoise3DWrapped() in single precision.
+static inline double GradientCoherentNoise3DWrappedSingle (double x,
+  double y, double z, int period, int seed, NoiseQuality noiseQuality)
+{
+  int x0 = (x > 0.0? (int)x: (int)x - 1);
+  int x1 = x0 + 1;
+  int y0 = (y > 0.0? (int)y: (int)y - 1);
+  int y1 = y0 + 1;
+  int z0 = (z > 0.0? (int)z: (int)z - 1);
+  int z1 = z0 + 1;
+  int hx0 = (x0 < 0)? x0 + period: x0;
+  int hx1 = (x1 == period)? 0: x1;
+  int hy0 = (y0 < 0)? y0 + period: y0;
+  int hy1 = (y1 == period)? 0: y1;
+  int hz0 = (z0 < 0)? z0 + period: z0;
+  int hz1 = (z1 == period)? 0: z1;
+
+  // Distances from the lower and the upper corners of the cube.
+  float xd0 = (float)(x - (double)x0);
+  float yd0 = (float)(y - (double)y0);
+  float zd0 = (float)(z - (double)z0);
+  float xd1 = xd0 - 1.0f;
+  float yd1 = yd0 - 1.0f;
+  float zd1 = zd0 - 1.0f;
+
+  float xs = SCurveSingle (xd0, noiseQuality);
+  float ys = SCurveSingle (yd0, noiseQuality);
+  float zs = SCurveSingle (zd0, noiseQuality);
+
+  const float* randomVectors = GetRandomVectorsSingle ();
+  float n0, n1, ix0, ix1, iy0, iy1;
+  n0   = GradientNoise3DSingle (xd0, yd0, zd0, hx0, hy0, hz0, seed,
+    randomVectors);
+  n1   = GradientNoise3DSingle (xd1, yd0, zd0, hx1, hy0, hz0, seed,
+    randomVectors);
+  ix0  = LinearInterpSingle (n0, n1, xs);
+  n0   = GradientNoise3DSingle (xd0, yd1, zd0, hx0, hy1, hz0, seed,
+    randomVectors);
+  n1   = GradientNoise3DSingle (xd1, yd1, zd0, hx1, hy1, hz0, seed,
+    randomVectors);
+  ix1  = LinearInterpSingle (n0, n1, xs);
+  iy0  = LinearInterpSingle (ix0, ix1, ys);
+  n0   = GradientNoise3DSingle (xd0, yd0, zd1, hx0, hy0, hz1, seed,
+    randomVectors);
+  n1   = GradientNoise3DSingle (xd1, yd0, zd1, hx1, hy0, hz1, seed,
+    randomVectors);
+  ix0  = LinearInterpSingle (n0, n1, xs);
+  n0   = GradientNoise3DSingle (xd0, yd1, zd1, hx0, hy1, hz1, seed,
+    randomVectors);
+  n1   = GradientNoise3DSingle (xd1, yd1, zd1, hx1, hy1, hz1, seed,
+    randomVectors);
+  ix1  = LinearInterpSingle (n0, n1, xs);
+  iy1  = LinearInterpSingle (ix0, ix1, ys);
+
+  return (double)LinearInterpSingle (iy0, iy1, zs);
+}
+
+double noise::GradientCoherentNoise3D (double x, double y, double z, int seed,
+  NoiseQuality noiseQuality)
+{
+  if (t_noisePrecision == PRECISION_SINGLE) {
+    return GradientCoherentNoise3DWrappedSingle (x, y, z, 0, seed,
+      noiseQuality);
+  }
+  return GradientCoherentNoise3DWrapped (x, y, z, 0, seed, noiseQuality);
+}
+
+double noise::PeriodicGradientCoherentNoise3D (double x, double y, double z,
+  int period, int seed, NoiseQuality noiseQuality)
+{
+  if (t_noisePrecision == PRECISION_SINGLE) {
+    return GradientCoherentNoise3DWrappedSingle (x, y, z, period, seed,
+      noiseQuality);
+  }
+  return GradientCoherentNoise3DWrapped (x, y, z, period, seed,
+    noiseQuality);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Ranges of GradientCoherentNoise3D()
+
+// Margin added to both bounds of a noise range.  The bounds are calculated
+// with other operations than the noise values, so they may round the other
+// way; the rounding errors are many orders of magnitude below this margin.
+const double NOISE_RANGE_MARGIN = 1.0e-9;
+
+// Margin added instead in single precision, well above the rounding errors
+// of the float calculation (up to a few 1.0e-6 per noise value with
+// QUALITY_BEST, whose S-curve subtracts large terms).
+const double SINGLE_NOISE_RANGE_MARGIN = 1.0e-4;
+
+// Margin of the precision of the calling thread.
+static inline double GetNoiseRangeMargin ()
+{
+  return (t_noisePrecision == PRECISION_SINGLE)? SINGLE_NOISE_RANGE_MARGIN:
+    NOISE_RANGE_MARGIN;
+}
+
+// Largest number of unit cubes that a range is calculated over, one cube at
+// a time.  Larger boxes get the range of the noise over every input value.
+const int MAX_NOISE_RANGE_CUBES = 64;
+
+// Largest magnitude of GradientNoise3D() for an input value inside a unit
+// cube around the lattice point: every coordinate of the distance vector
+// ranges from -1.0 to 1.0.
+static double GetGradientNoiseBound ()
+{
+  static const double bound = [] () {
+    double maxLength = 0.0;
+    for (int i = 0; i < 256; i++) {
+      double length = fabs (g_randomVectors[(i << 2)    ])
+        + fabs (g_randomVectors[(i << 2) + 1])
+        + fabs (g_randomVectors[(i << 2) + 2]);
+      maxLength = GetMax (maxLength, length);
+    }
+    return maxLength * 2.12;
+  } ();
+  return bound + GetNoiseRangeMargin ();
+}
+
+// Lower corner of the unit cube around n, as in
+// GradientCoherentNoise3DWrapped().
+static inline int GetLatticeCorner (double n)
+{
+  return (n > 0.0? (int)n: (int)n - 1);
+}
+
+// S-curve of the noise quality, as in GradientCoherentNoise3DWrapped().
+static inline double GetNoiseSCurve (double a, NoiseQuality noiseQuality)
+{
+  switch (noiseQuality) {
+    case QUALITY_FAST:
+      return a;
+    case QUALITY_STD:
+      return SCurve3 (a);
+    case QUALITY_BEST:
+      return SCurve5 (a);
+  }
+  return a;
+}
+
+// Range of GradientNoise3DWrapped() at the lattice point (ix, iy, iz) over
+// the input values whose distance from the lower corner of the cube ranges
+// from fMin to fMax.  (ox, oy, oz) is the offset of the lattice point from
+// that corner.
+static inline void GetGradientNoiseRange (const double* fMin,
+  const double* fMax, int ox, int oy, int oz, int hx, int hy, int hz,
+  int seed, double& lower, double& upper)
+{
+  int vectorIndex = (int)(
+      (unsigned int)X_NOISE_GEN    * (unsigned int)hx
+    + (unsigned int)Y_NOISE_GEN    * (unsigned int)hy
+    + (unsigned int)Z_NOISE_GEN    * (unsigned int)hz
+    + (unsigned int)SEED_NOISE_GEN * (unsigned int)seed);
+  vectorIndex ^= (vectorIndex >> SHIFT_NOISE_GEN);
+  vectorIndex &= 0xff;
+
+  const int offset[3] = {ox, oy, oz};
+  lower = 0.0;
+  upper = 0.0;
+  for (int i = 0; i < 3; i++) {
+    double gradient = g_randomVectors[(vectorIndex << 2) + i];
+    double a = gradient * (fMin[i] - (double)offset[i]);
+    double b = gradient * (fMax[i] - (double)offset[i]);
+    lower += GetMin (a, b);
+    upper += GetMax (a, b);
+  }
+  lower *= 2.12;
+  upper *= 2.12;
+}
+
+// Body of GradientCoherentNoise3DRange() and
+// PeriodicGradientCoherentNoise3DRange().  The lattice points of each cube
+// are wrapped into the period, which leaves them unchanged for a period of
+// 0.
+static void GradientCoherentNoise3DWrappedRange (const double* boxMin,
+  const double* boxMax, int period, int seed, NoiseQuality noiseQuality,
+  double& lower, double& upper)
+{
+  int cornerMin[3], cornerMax[3];
+  int cubeCount = 1;
+  for (int i = 0; i < 3; i++) {
+    if (!(boxMin[i] > -1073741824.0 && boxMax[i] < 1073741824.0)) {
+      lower = -GetGradientNoiseBound ();
+      upper = GetGradientNoiseBound ();
+      return;
+    }
+    cornerMin[i] = GetLatticeCorner (boxMin[i]);
+    cornerMax[i] = GetLatticeCorner (boxMax[i]);
+    int axisCount = cornerMax[i] - cornerMin[i] + 1;
+    cubeCount = (axisCount > MAX_NOISE_RANGE_CUBES)? axisCount:
+      cubeCount * axisCount;
+    if (cubeCount > MAX_NOISE_RANGE_CUBES) {
+      break;
+    }
+  }
+  if (cubeCount > MAX_NOISE_RANGE_CUBES) {
+    lower = -GetGradientNoiseBound ();
+    upper = GetGradientNoiseBound ();
+    return;
+  }
+
+  lower = HUGE_VAL;
+  upper = -HUGE_VAL;
+  int corner[3];
+  for (corner[2] = cornerMin[2]; corner[2] <= cornerMax[2]; corner[2]++) {
+    for (corner[1] = cornerMin[1]; corner[1] <= cornerMax[1]; corner[1]++) {
+      for (corner[0] = cornerMin[0]; corner[0] <= cornerMax[0];
+        corner[0]++) {
+
+        // Part of the box inside this cube, relative to its lower corner,
+        // and the range of the S-curve values over it.
+        double fMin[3], fMax[3], sMin[3], sMax[3];
+        int h0[3], h1[3];
+        for (int i = 0; i < 3; i++) {
+          fMin[i] = GetMax (boxMin[i] - (double)corner[i], 0.0);
+          fMax[i] = GetMin (boxMax[i] - (double)corner[i], 1.0);
+          sMin[i] = GetNoiseSCurve (fMin[i], noiseQuality);
+          sMax[i] = GetNoiseSCurve (fMax[i], noiseQuality);
+          if (period > 0) {
+            h0[i] = corner[i] % period;
+            if (h0[i] < 0) {
+              h0[i] += period;
+            }
+            h1[i] = (h0[i] + 1 == period)? 0: h0[i] + 1;
+          } else {
+            h0[i] = corner[i];
+            h1[i] = corner[i] + 1;
+          }
+        }
+
+        // Interpolate the ranges at the cube corners in the same order as
+        // GradientCoherentNoise3DWrapped().
+        double edgeLower[4], edgeUpper[4];
+        for (int edge = 0; edge < 4; edge++) {
+          int oy = edge & 1;
+          int oz = edge >> 1;
+          int hy = oy? h1[1]: h0[1];
+          int hz = oz? h1[2]: h0[2];
+          double n0Lower, n0Upper, n1Lower, n1Upper;
+          GetGradientNoiseRange (fMin, fMax, 0, oy, oz, h0[0], hy, hz, seed,
+            n0Lower, n0Upper);
+          GetGradientNoiseRange (fMin, fMax, 1, oy, oz, h1[0], hy, hz, seed,
+            n1Lower, n1Upper);
+          GetLinearInterpRange (n0Lower, n0Upper, n1Lower, n1Upper, sMin[0],
+            sMax[0], edgeLower[edge], edgeUpper[edge]);
+        }
+        double y0Lower, y0Upper, y1Lower, y1Upper, cubeLower, cubeUpper;
+        GetLinearInterpRange (edgeLower[0], edgeUpper[0], edgeLower[1],
+          edgeUpper[1], sMin[1], sMax[1], y0Lower, y0Upper);
+        GetLinearInterpRange (edgeLower[2], edgeUpper[2], edgeLower[3],
+          edgeUpper[3], sMin[1], sMax[1], y1Lower, y1Upper);
+        GetLinearInterpRange (y0Lower, y0Upper, y1Lower, y1Upper, sMin[2],
+          sMax[2], cubeLower, cubeUpper);
+
+        lower = GetMin (lower, cubeLower);
+        upper = GetMax (upper, cubeUpper);
+      }
+    }
+  }
+
+  lower -= GetNoiseRangeMargin ();
+  upper += GetNoiseRangeMargin ();
+}
+
+void noise::GradientCoherentNoise3DRange (double xMin, double yMin,
+  double zMin, double xMax, double yMax, double zMax, double& lower,
+  double& upper, int seed, NoiseQuality noiseQuality)
+{
+  const double boxMin[3] = {xMin, yMin, zMin};
+  const double boxMax[3] = {xMax, yMax, zMax};
+  GradientCoherentNoise3DWrappedRange (boxMin, boxMax, 0, seed, noiseQuality,
+    lower, upper);
+}
+
+void noise::PeriodicGradientCoherentNoise3DRange (double xMin, double yMin,
+  double zMin, double xMax, double yMax, double zMax, double& lower,
+  double& upper, int period, int seed, NoiseQuality noiseQuality)
+{
+  const double boxMin[3] = {xMin, yMin, zMin};
+  const double boxMax[3] = {xMax, yMax, zMax};
+  GradientCoherentNoise3DWrappedRange (boxMin, boxMax, period, seed,
+    noiseQuality, lower, upper);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Array version of GradientCoherentNoise3D()
+//
+// The SIMD kernels repeat the operations of the single-value version in the
+// same order, lane by lane, so the results are identical:
+// - (int)x is the truncation of x, which _mm_round_pd() computes exactly for
+//   the coordinates allowed by MakeInt32Range(), and (double)(x0 + 1) equals
+//   (double)x0 + 1.0.
+// - The integer hash wraps around like the 32-bit int arithmetic of
+//   GradientNoise3D(), and its right shift is arithmetic.
+// - The cube corners are wrapped into the period like in
+//   GradientCoherentNoise3DWrapped(), which also leaves them unchanged for a
+//   period of 0.
+// - Multiplications and additions are never fused: this file is compiled
+//   with -ffp-contract=off (see CMakeLists.txt), since the avx512f target
+//   also enables FMA.
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) \
+  || defined(_M_IX86)
+#define NOISE_SIMD_X86 1
+#else
+#define NOISE_SIMD_X86 0
+#endif
+
+#if NOISE_SIMD_X86
+#if defined(_MSC_VER)
+#include <intrin.h>
+#include <immintrin.h>
+// MSVC accepts the intrinsics of every instruction set without compiler
+// flags.
+#define NOISE_TARGET_SSE41
+#define NOISE_TARGET_AVX2
+#define NOISE_TARGET_AVX512
+#else
+#include <immintrin.h>
+#define NOISE_TARGET_SSE41 __attribute__((target("sse4.1")))
+#define NOISE_TARGET_AVX2 __attribute__((target("avx2")))
+#define NOISE_TARGET_AVX512 __attribute__((target("avx512f")))
+#endif
+#endif
+
+// Instruction set used by the array version.  It is zero-initialized
+// (SIMD_NONE) until the dynamic initializer below runs, so noise generated
+// during static initialization still falls back to plain C++.
+static SimdLevel g_simdLevel = GetSupportedSimdLevel ();
+
+SimdLevel noise::GetSupportedSimdLevel ()
+{
+#if !NOISE_SIMD_X86
+  return SIMD_NONE;
+#elif defined(_MSC_VER)
+  int info[4];
+  __cpuid (info, 0);
+  int maxLeaf = info[0];
+  __cpuid (info, 1);
+  if ((info[2] & (1 << 19)) == 0) {
+    return SIMD_NONE;
+  }
+  // AVX2 and AVX-512 also need the operating system to save the ymm (and
+  // zmm) registers.
+  bool osAvx = (info[2] & (1 << 27)) != 0 && (info[2] & (1 << 28)) != 0;
+  if (maxLeaf < 7 || !osAvx) {
+    return SIMD_SSE41;
+  }
+  unsigned long long xcr0 = _xgetbv (0);
+  __cpuidex (info, 7, 0);
+  if ((info[1] & (1 << 16)) != 0 && (xcr0 & 0xe6) == 0xe6) {
+    return SIMD_AVX512;
+  }
+  if ((info[1] & (1 << 5)) != 0 && (xcr0 & 0x6) == 0x6) {
+    return SIMD_AVX2;
+  }
+  return SIMD_SSE41;
+#else
+  __builtin_cpu_init ();
+  if (__builtin_cpu_supports ("avx512f")) {
+    return SIMD_AVX512;
+  }
+  if (__builtin_cpu_supports ("avx2")) {
+    return SIMD_AVX2;
+  }
+  if (__builtin_cpu_supports ("sse4.1")) {
+    return SIMD_SSE41;
+  }
+  return SIMD_NONE;
+#endif
+}
+
+SimdLevel noise::GetSimdLevel ()
+{
+  return g_simdLevel;
+}
+
+void noise::SetSimdLevel (SimdLevel simdLevel)
+{
+  SimdLevel supported = GetSupportedSimdLevel ();
+  g_simdLevel = (simdLevel > supported)? supported: simdLevel;
+}
+
+#if NOISE_SIMD_X86
+
+// SSE4.1: two input values per __m128d.  There is no gather instruction, so
+// the gradient vectors are loaded one lane at a time.
+
+NOISE_TARGET_SSE41 static inline __m128d GradientNoise3DSse41 (__m128d fx,
+  __m128d fy, __m128d fz, __m128d dx, __m128d dy, __m128d dz, __m128i ix,
+  __m128i iy, __m128i iz, __m128i seedTerm)
+{
+  __m128i vectorIndex = _mm_add_epi32 (
+    _mm_add_epi32 (_mm_mullo_epi32 (ix, _mm_set1_epi32 (X_NOISE_GEN)),
+                   _mm_mullo_epi32 (iy, _mm_set1_epi32 (Y_NOISE_GEN))),
+    _mm_add_epi32 (_mm_mullo_epi32 (iz, _mm_set1_epi32 (Z_NOISE_GEN)),
+                   seedTerm));
+  vectorIndex = _mm_xor_si128 (vectorIndex,
+    _mm_srai_epi32 (vectorIndex, SHIFT_NOISE_GEN));
+  vectorIndex = _mm_slli_epi32 (
+    _mm_and_si128 (vectorIndex, _mm_set1_epi32 (0xff)), 2);
+
+  const double* v0 = g_randomVectors + _mm_cvtsi128_si32 (vectorIndex);
+  const double* v1 = g_randomVectors + _mm_extract_epi32 (vectorIndex, 1);
+  __m128d xvGradient = _mm_set_pd (v1[0], v0[0]);
+  __m128d yvGradient = _mm_set_pd (v1[1], v0[1]);
+  __m128d zvGradient = _mm_set_pd (v1[2], v0[2]);
+
+  __m128d dot = _mm_add_pd (
+    _mm_add_pd (_mm_mul_pd (xvGradient, _mm_sub_pd (fx, dx)),
+                _mm_mul_pd (yvGradient, _mm_sub_pd (fy, dy))),
+    _mm_mul_pd (zvGradient, _mm_sub_pd (fz, dz)));
+  return _mm_mul_pd (dot, _mm_set1_pd (2.12));
+}
+
+NOISE_TARGET_SSE41 static inline __m128d LinearInterpSse41 (__m128d n0,
+  __m128d n1, __m128d a)
+{
+  return _mm_add_pd (_mm_mul_pd (_mm_sub_pd (_mm_set1_pd (1.0), a), n0),
+    _mm_mul_pd (a, n1));
+}
+
+NOISE_TARGET_SSE41 static inline __m128d SCurveSse41 (__m128d a,
+  NoiseQuality noiseQuality)
+{
+  switch (noiseQuality) {
+    case QUALITY_STD:
+      return _mm_mul_pd (_mm_mul_pd (a, a),
+        _mm_sub_pd (_mm_set1_pd (3.0), _mm_mul_pd (_mm_set1_pd (2.0), a)));
+    case QUALITY_BEST: {
+      __m128d a3 = _mm_mul_pd (_mm_mul_pd (a, a), a);
+      __m128d a4 = _mm_mul_pd (a3, a);
+      __m128d a5 = _mm_mul_pd (a4, a);
+      return _mm_add_pd (
+        _mm_sub_pd (_mm_mul_pd (_mm_set1_pd (6.0), a5),
+                    _mm_mul_pd (_mm_set1_pd (15.0), a4)),
+        _mm_mul_pd (_mm_set1_pd (10.0), a3));
+    }
+    default:
+      return a;
+  }
+}
+
+// Lower corner of the unit cube around x: (double)(x > 0.0? (int)x:
+// (int)x - 1).
+NOISE_TARGET_SSE41 static inline __m128d CubeFloorSse41 (__m128d x)
+{
+  __m128d truncated = _mm_round_pd (x, _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC);
+  __m128d positive = _mm_cmpgt_pd (x, _mm_setzero_pd ());
+  return _mm_sub_pd (truncated, _mm_andnot_pd (positive, _mm_set1_pd (1.0)));
+}
+
+// Wraps the lower and upper cube corners into the period, like
+// GradientCoherentNoise3DWrapped().
+NOISE_TARGET_SSE41 static inline void WrapCornersSse41 (__m128i& lower,
+  __m128i& upper, __m128i period)
+{
+  lower = _mm_add_epi32 (lower,
+    _mm_and_si128 (_mm_cmpgt_epi32 (_mm_setzero_si128 (), lower), period));
+  upper = _mm_andnot_si128 (_mm_cmpeq_epi32 (upper, period), upper);
+}
+
+NOISE_TARGET_SSE41 static int GradientCoherentNoise3DSse41 (const double* x,
+  const double* y, const double* z, double* values, int count, int period,
+  int seed, NoiseQuality noiseQuality)
+{
+  const __m128d one = _mm_set1_pd (1.0);
+  const __m128i intOne = _mm_set1_epi32 (1);
+  const __m128i seedTerm = _mm_set1_epi32 (
+    (int)((unsigned int)SEED_NOISE_GEN * (unsigned int)seed));
+  const __m128i periodTerm = _mm_set1_epi32 (period);
+
+  int i = 0;
+  for (; i + 2 <= count; i += 2) {
+    __m128d fx = _mm_loadu_pd (x + i);
+    __m128d fy = _mm_loadu_pd (y + i);
+    __m128d fz = _mm_loadu_pd (z + i);
+
+    __m128d dx0 = CubeFloorSse41 (fx);
+    __m128d dy0 = CubeFloorSse41 (fy);
+    __m128d dz0 = CubeFloorSse41 (fz);
+    __m128d dx1 = _mm_add_pd (dx0, one);
+    __m128d dy1 = _mm_add_pd (dy0, one);
+    __m128d dz1 = _mm_add_pd (dz0, one);
+    __m128i ix0 = _mm_cvttpd_epi32 (dx0);
+    __m128i iy0 = _mm_cvttpd_epi32 (dy0);
+    __m128i iz0 = _mm_cvttpd_epi32 (dz0);
+    __m128i ix1 = _mm_add_epi32 (ix0, intOne);
+    __m128i iy1 = _mm_add_epi32 (iy0, intOne);
+    __m128i iz1 = _mm_add_epi32 (iz0, intOne);
+    __m128i hx0 = ix0, hx1 = ix1, hy0 = iy0, hy1 = iy1, hz0 = iz0, hz1 = iz1;
+    WrapCornersSse41 (hx0, hx1, periodTerm);
+    WrapCornersSse41 (hy0, hy1, periodTerm);
+    WrapCornersSse41 (hz0, hz1, periodTerm);
+
+    __m128d xs = SCurveSse41 (_mm_sub_pd (fx, dx0), noiseQuality);
+    __m128d ys = SCurveSse41 (_mm_sub_pd (fy, dy0), noiseQuality);
+    __m128d zs = SCurveSse41 (_mm_sub_pd (fz, dz0), noiseQuality);
+
+    __m128d n0, n1, ix0v, ix1v, iy0v, iy1v;
+    n0   = GradientNoise3DSse41 (fx, fy, fz, dx0, dy0, dz0, hx0, hy0, hz0, seedTerm);
+    n1   = GradientNoise3DSse41 (fx, fy, fz, dx1, dy0, dz0, hx1, hy0, hz0, seedTerm);
+    ix0v = LinearInterpSse41 (n0, n1, xs);
+    n0   = GradientNoise3DSse41 (fx, fy, fz, dx0, dy1, dz0, hx0, hy1, hz0, seedTerm);
+    n1   = GradientNoise3DSse41 (fx, fy, fz, dx1, dy1, dz0, hx1, hy1, hz0, seedTerm);
+    ix1v = LinearInterpSse41 (n0, n1, xs);
+    iy0v = LinearInterpSse41 (ix0v, ix1v, ys);
+    n0   = GradientNoise3DSse41 (fx, fy, fz, dx0, dy0, dz1, hx0, hy0, hz1, seedTerm);
+    n1   = GradientNoise3DSse41 (fx, fy, fz, dx1, dy0, dz1, hx1, hy0, hz1, seedTerm);
+    ix0v = LinearInterpSse41 (n0, n1, xs);
+    n0   = GradientNoise3DSse41 (fx, fy, fz, dx0, dy1, dz1, hx0, hy1, hz1, seedTerm);
+    n1   = GradientNoise3DSse41 (fx, fy, fz, dx1, dy1, dz1, hx1, hy1, hz1, seedTerm);
+    ix1v = LinearInterpSse41 (n0, n1, xs);
+    iy1v = LinearInterpSse41 (ix0v, ix1v, ys);
+
+    _mm_storeu_pd (values + i, LinearInterpSse41 (iy0v, iy1v, zs));
+  }
+
+  return i;
+}
+
+// AVX2: four input values per __m256d, with gathered gradient vectors.
+
+NOISE_TARGET_AVX2 static inline __m256d GradientNoise3DAvx2 (__m256d fx,
+  __m256d fy, __m256d fz, __m256d dx, __m256d dy, __m256d dz, __m128i ix,
+  __m128i iy, __m128i iz, __m128i seedTerm)
+{
+  __m128i vectorIndex = _mm_add_epi32 (
+    _mm_add_epi32 (_mm_mullo_epi32 (ix, _mm_set1_epi32 (X_NOISE_GEN)),
+                   _mm_mullo_epi32 (iy, _mm_set1_epi32 (Y_NOISE_GEN))),
+    _mm_add_epi32 (_mm_mullo_epi32 (iz, _mm_set1_epi32 (Z_NOISE_GEN)),
+                   seedTerm));
+  vectorIndex = _mm_xor_si128 (vectorIndex,
+    _mm_srai_epi32 (vectorIndex, SHIFT_NOISE_GEN));
+  vectorIndex = _mm_slli_epi32 (
+    _mm_and_si128 (vectorIndex, _mm_set1_epi32 (0xff)), 2);
+
+  // Masked gathers with a zero source: the unmasked intrinsics start from an
+  // undefined register, which GCC reports as maybe-uninitialized.  Every
+  // lane is loaded, so the values are the same.
+  const __m256d allLanes = _mm256_castsi256_pd (_mm256_set1_epi64x (-1));
+  __m256d xvGradient = _mm256_mask_i32gather_pd (_mm256_setzero_pd (),
+    g_randomVectors    , vectorIndex, allLanes, 8);
+  __m256d yvGradient = _mm256_mask_i32gather_pd (_mm256_setzero_pd (),
+    g_randomVectors + 1, vectorIndex, allLanes, 8);
+  __m256d zvGradient = _mm256_mask_i32gather_pd (_mm256_setzero_pd (),
+    g_randomVectors + 2, vectorIndex, allLanes, 8);
+
+  __m256d dot = _mm256_add_pd (
+    _mm256_add_pd (_mm256_mul_pd (xvGradient, _mm256_sub_pd (fx, dx)),
+                   _mm256_mul_pd (yvGradient, _mm256_sub_pd (fy, dy))),
+    _mm256_mul_pd (zvGradient, _mm256_sub_pd (fz, dz)));
+  return _mm256_mul_pd (dot, _mm256_set1_pd (2.12));
+}
+
+NOISE_TARGET_AVX2 static inline __m256d LinearInterpAvx2 (__m256d n0,
+  __m256d n1, __m256d a)
+{
+  return _mm256_add_pd (
+    _mm256_mul_pd (_mm256_sub_pd (_mm256_set1_pd (1.0), a), n0),
+    _mm256_mul_pd (a, n1));
+}
+
+NOISE_TARGET_AVX2 static inline __m256d SCurveAvx2 (__m256d a,
+  NoiseQuality noiseQuality)
+{
+  switch (noiseQuality) {
+    case QUALITY_STD:
+      return _mm256_mul_pd (_mm256_mul_pd (a, a),
+        _mm256_sub_pd (_mm256_set1_pd (3.0),
+                       _mm256_mul_pd (_mm256_set1_pd (2.0), a)));
+    case QUALITY_BEST: {
+      __m256d a3 = _mm256_mul_pd (_mm256_mul_pd (a, a), a);
+      __m256d a4 = _mm256_mul_pd (a3, a);
+      __m256d a5 = _mm256_mul_pd (a4, a);
+      return _mm256_add_pd (
+        _mm256_sub_pd (_mm256_mul_pd (_mm256_set1_pd (6.0), a5),
+                       _mm256_mul_pd (_mm256_set1_pd (15.0), a4)),
+        _mm256_mul_pd (_mm256_set1_pd (10.0), a3));
+    }
+    default:
+      return a;
+  }
+}
+
+NOISE_TARGET_AVX2 static inline __m256d CubeFloorAvx2 (__m256d x)
+{
+  __m256d truncated = _mm256_round_pd (x,
+    _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC);
+  __m256d positive = _mm256_cmp_pd (x, _mm256_setzero_pd (), _CMP_GT_OQ);
+  return _mm256_sub_pd (truncated,
+    _mm256_andnot_pd (positive, _mm256_set1_pd (1.0)));
+}
+
+// Wraps the lower and upper cube corners into the period, like
+// GradientCoherentNoise3DWrapped().
+NOISE_TARGET_AVX2 static inline void WrapCornersAvx2 (__m128i& lower,
+  __m128i& upper, __m128i period)
+{
+  lower = _mm_add_epi32 (lower,
+    _mm_and_si128 (_mm_cmpgt_epi32 (_mm_setzero_si128 (), lower), period));
+  upper = _mm_andnot_si128 (_mm_cmpeq_epi32 (upper, period), upper);
+}
+
+NOISE_TARGET_AVX2 static int GradientCoherentNoise3DAvx2 (const double* x,
+  const double* y, const double* z, double* values, int count, int period,
+  int seed, NoiseQuality noiseQuality)
+{
+  const __m256d one = _mm256_set1_pd (1.0);
+  const __m128i intOne = _mm_set1_epi32 (1);
+  const __m128i seedTerm = _mm_set1_epi32 (
+    (int)((unsigned int)SEED_NOISE_GEN * (unsigned int)seed));
+  const __m128i periodTerm = _mm_set1_epi32 (period);
+
+  int i = 0;
+  for (; i + 4 <= count; i += 4) {
+    __m256d fx = _mm256_loadu_pd (x + i);
+    __m256d fy = _mm256_loadu_pd (y + i);
+    __m256d fz = _mm256_loadu_pd (z + i);
+
+    __m256d dx0 = CubeFloorAvx2 (fx);
+    __m256d dy0 = CubeFloorAvx2 (fy);
+    __m256d dz0 = CubeFloorAvx2 (fz);
+    __m256d dx1 = _mm256_add_pd (dx0, one);
+    __m256d dy1 = _mm256_add_pd (dy0, one);
+    __m256d dz1 = _mm256_add_pd (dz0, one);
+    __m128i ix0 = _mm256_cvttpd_epi32 (dx0);
+    __m128i iy0 = _mm256_cvttpd_epi32 (dy0);
+    __m128i iz0 = _mm256_cvttpd_epi32 (dz0);
+    __m128i ix1 = _mm_add_epi32 (ix0, intOne);
+    __m128i iy1 = _mm_add_epi32 (iy0, intOne);
+    __m128i iz1 = _mm_add_epi32 (iz0, intOne);
+    __m128i hx0 = ix0, hx1 = ix1, hy0 = iy0, hy1 = iy1, hz0 = iz0, hz1 = iz1;
+    WrapCornersAvx2 (hx0, hx1, periodTerm);
+    WrapCornersAvx2 (hy0, hy1, periodTerm);
+    WrapCornersAvx2 (hz0, hz1, periodTerm);
+
+    __m256d xs = SCurveAvx2 (_mm256_sub_pd (fx, dx0), noiseQuality);
+    __m256d ys = SCurveAvx2 (_mm256_sub_pd (fy, dy0), noiseQuality);
+    __m256d zs = SCurveAvx2 (_mm256_sub_pd (fz, dz0), noiseQuality);
+
+    __m256d n0, n1, ix0v, ix1v, iy0v, iy1v;
+    n0   = GradientNoise3DAvx2 (fx, fy, fz, dx0, dy0, dz0, hx0, hy0, hz0, seedTerm);
+    n1   = GradientNoise3DAvx2 (fx, fy, fz, dx1, dy0, dz0, hx1, hy0, hz0, seedTerm);
+    ix0v = LinearInterpAvx2 (n0, n1, xs);
+    n0   = GradientNoise3DAvx2 (fx, fy, fz, dx0, dy1, dz0, hx0, hy1, hz0, seedTerm);
+    n1   = GradientNoise3DAvx2 (fx, fy, fz, dx1, dy1, dz0, hx1, hy1, hz0, seedTerm);
+    ix1v = LinearInterpAvx2 (n0, n1, xs);
+    iy0v = LinearInterpAvx2 (ix0v, ix1v, ys);
+    n0   = GradientNoise3DAvx2 (fx, fy, fz, dx0, dy0, dz1, hx0, hy0, hz1, seedTerm);
+    n1   = GradientNoise3DAvx2 (fx, fy, fz, dx1, dy0, dz1, hx1, hy0, hz1, seedTerm);
+    ix0v = LinearInterpAvx2 (n0, n1, xs);
+    n0   = GradientNoise3DAvx2 (fx, fy, fz, dx0, dy1, dz1, hx0, hy1, hz1, seedTerm);
+    n1   = GradientNoise3DAvx2 (fx, fy, fz, dx1, dy1, dz1, hx1, hy1, hz1, seedTerm);
+    ix1v = LinearInterpAvx2 (n0, n1, xs);
+    iy1v = LinearInterpAvx2 (ix0v, ix1v, ys);
+
+    _mm256_storeu_pd (values + i, LinearInterpAvx2 (iy0v, iy1v, zs));
+  }
+
+  return i;
+}
+
+// AVX-512F: eight input values per __m512d, with gathered gradient vectors
+// and the eight hashes in one __m256i.
+
+NOISE_TARGET_AVX512 static inline __m512d GradientNoise3DAvx512 (__m512d fx,
+  __m512d fy, __m512d fz, __m512d dx, __m512d dy, __m512d dz, __m256i ix,
+  __m256i iy, __m256i iz, __m256i seedTerm)
+{
+  __m256i vectorIndex = _mm256_add_epi32 (
+    _mm256_add_epi32 (_mm256_mullo_epi32 (ix, _mm256_set1_epi32 (X_NOISE_GEN)),
+                      _mm256_mullo_epi32 (iy, _mm256_set1_epi32 (Y_NOISE_GEN))),
+    _mm256_add_epi32 (_mm256_mullo_epi32 (iz, _mm256_set1_epi32 (Z_NOISE_GEN)),
+                      seedTerm));
+  vectorIndex = _mm256_xor_si256 (vectorIndex,
+    _mm256_srai_epi32 (vectorIndex, SHIFT_NOISE_GEN));
+  vectorIndex = _mm256_slli_epi32 (
+    _mm256_and_si256 (vectorIndex, _mm256_set1_epi32 (0xff)), 2);
+
+  // Masked gathers with a zero source, as in GradientNoise3DAvx2().
+  __m512d xvGradient = _mm512_mask_i32gather_pd (_mm512_setzero_pd (), 0xff,
+    vectorIndex, g_randomVectors    , 8);
+  __m512d yvGradient = _mm512_mask_i32gather_pd (_mm512_setzero_pd (), 0xff,
+    vectorIndex, g_randomVectors + 1, 8);
+  __m512d zvGradient = _mm512_mask_i32gather_pd (_mm512_setzero_pd (), 0xff,
+    vectorIndex, g_randomVectors + 2, 8);
+
+  __m512d dot = _mm512_add_pd (
+    _mm512_add_pd (_mm512_mul_pd (xvGradient, _mm512_sub_pd (fx, dx)),
+                   _mm512_mul_pd (yvGradient, _mm512_sub_pd (fy, dy))),
+    _mm512_mul_pd (zvGradient, _mm512_sub_pd (fz, dz)));
+  return _mm512_mul_pd (dot, _mm512_set1_pd (2.12));
+}
+
+NOISE_TARGET_AVX512 static inline __m512d LinearInterpAvx512 (__m512d n0,
+  __m512d n1, __m512d a)
+{
+  return _mm512_add_pd (
+    _mm512_mul_pd (_mm512_sub_pd (_mm512_set1_pd (1.0), a), n0),
+    _mm512_mul_pd (a, n1));
+}
+
+NOISE_TARGET_AVX512 static inline __m512d SCurveAvx512 (__m512d a,
+  NoiseQuality noiseQuality)
+{
+  switch (noiseQuality) {
+    case QUALITY_STD:
+      return _mm512_mul_pd (_mm512_mul_pd (a, a),
+        _mm512_sub_pd (_mm512_set1_pd (3.0),
+                       _mm512_mul_pd (_mm512_set1_pd (2.0), a)));
+    case QUALITY_BEST: {
+      __m512d a3 = _mm512_mul_pd (_mm512_mul_pd (a, a), a);
+      __m512d a4 = _mm512_mul_pd (a3, a);
+      __m512d a5 = _mm512_mul_pd (a4, a);
+      return _mm512_add_pd (
+        _mm512_sub_pd (_mm512_mul_pd (_mm512_set1_pd (6.0), a5),
+                       _mm512_mul_pd (_mm512_set1_pd (15.0), a4)),
+        _mm512_mul_pd (_mm512_set1_pd (10.0), a3));
+    }
+    default:
+      return a;
+  }
+}
+
+NOISE_TARGET_AVX512 static inline __m512d CubeFloorAvx512 (__m512d x)
+{
+  // The zero-masked forms here and in the callers avoid the undefined
+  // source registers of the unmasked ones; see GradientNoise3DAvx2().
+  __m512d truncated = _mm512_maskz_roundscale_pd (0xff, x,
+    _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC);
+  __mmask8 positive = _mm512_cmp_pd_mask (x, _mm512_setzero_pd (),
+    _CMP_GT_OQ);
+  return _mm512_mask_sub_pd (truncated, (__mmask8)~positive, truncated,
+    _mm512_set1_pd (1.0));
+}
+
+// Wraps the lower and upper cube corners into the period, like
+// GradientCoherentNoise3DWrapped().
+NOISE_TARGET_AVX512 static inline void WrapCornersAvx512 (__m256i& lower,
+  __m256i& upper, __m256i period)
+{
+  lower = _mm256_add_epi32 (lower,
+    _mm256_and_si256 (_mm256_cmpgt_epi32 (_mm256_setzero_si256 (), lower), period));
+  upper = _mm256_andnot_si256 (_mm256_cmpeq_epi32 (upper, period), upper);
+}
+
+NOISE_TARGET_AVX512 static int GradientCoherentNoise3DAvx512 (
+  const double* x, const double* y, const double* z, double* values,
+  int count, int period, int seed, NoiseQuality noiseQuality)
+{
+  const __m512d one = _mm512_set1_pd (1.0);
+  const __m256i intOne = _mm256_set1_epi32 (1);
+  const __m256i seedTerm = _mm256_set1_epi32 (
+    (int)((unsigned int)SEED_NOISE_GEN * (unsigned int)seed));
+  const __m256i periodTerm = _mm256_set1_epi32 (period);
+
+  int i = 0;
+  for (; i + 8 <= count; i += 8) {
+    __m512d fx = _mm512_loadu_pd (x + i);
+    __m512d fy = _mm512_loadu_pd (y + i);
+    __m512d fz = _mm512_loadu_pd (z + i);
+
+    __m512d dx0 = CubeFloorAvx512 (fx);
+    __m512d dy0 = CubeFloorAvx512 (fy);
+    __m512d dz0 = CubeFloorAvx512 (fz);
+    __m512d dx1 = _mm512_add_pd (dx0, one);
+    __m512d dy1 = _mm512_add_pd (dy0, one);
+    __m512d dz1 = _mm512_add_pd (dz0, one);
+    __m256i ix0 = _mm512_maskz_cvttpd_epi32 (0xff, dx0);
+    __m256i iy0 = _mm512_maskz_cvttpd_epi32 (0xff, dy0);
+    __m256i iz0 = _mm512_maskz_cvttpd_epi32 (0xff, dz0);
+    __m256i ix1 = _mm256_add_epi32 (ix0, intOne);
+    __m256i iy1 = _mm256_add_epi32 (iy0, intOne);
+    __m256i iz1 = _mm256_add_epi32 (iz0, intOne);
+    __m256i hx0 = ix0, hx1 = ix1, hy0 = iy0, hy1 = iy1, hz0 = iz0, hz1 = iz1;
+    WrapCornersAvx512 (hx0, hx1, periodTerm);
+    WrapCornersAvx512 (hy0, hy1, periodTerm);
+    WrapCornersAvx512 (hz0, hz1, periodTerm);
+
+    __m512d xs = SCurveAvx512 (_mm512_sub_pd (fx, dx0), noiseQuality);
+    __m512d ys = SCurveAvx512 (_mm512_sub_pd (fy, dy0), noiseQuality);
+    __m512d zs = SCurveAvx512 (_mm512_sub_pd (fz, dz0), noiseQuality);
+
+    __m512d n0, n1, ix0v, ix1v, iy0v, iy1v;
+    n0   = GradientNoise3DAvx512 (fx, fy, fz, dx0, dy0, dz0, hx0, hy0, hz0, seedTerm);
+    n1   = GradientNoise3DAvx512 (fx, fy, fz, dx1, dy0, dz0, hx1, hy0, hz0, seedTerm);
+    ix0v = LinearInterpAvx512 (n0, n1, xs);
+    n0   = GradientNoise3DAvx512 (fx, fy, fz, dx0, dy1, dz0, hx0, hy1, hz0, seedTerm);
+    n1   = GradientNoise3DAvx512 (fx, fy, fz, dx1, dy1, dz0, hx1, hy1, hz0, seedTerm);
+    ix1v = LinearInterpAvx512 (n0, n1, xs);
+    iy0v = LinearInterpAvx512 (ix0v, ix1v, ys);
+    n0   = GradientNoise3DAvx512 (fx, fy, fz, dx0, dy0, dz1, hx0, hy0, hz1, seedTerm);
+    n1   = GradientNoise3DAvx512 (fx, fy, fz, dx1, dy0, dz1, hx1, hy0, hz1, seedTerm);
+    ix0v = LinearInterpAvx512 (n0, n1, xs);
+    n0   = GradientNoise3DAvx512 (fx, fy, fz, dx0, dy1, dz1, hx0, hy1, hz1, seedTerm);
+    n1   = GradientNoise3DAvx512 (fx, fy, fz, dx1, dy1, dz1, hx1, hy1, hz1, seedTerm);
+    ix1v = LinearInterpAvx512 (n0, n1, xs);
+    iy1v = LinearInterpAvx512 (ix0v, ix1v, ys);
+
+    _mm512_storeu_pd (values + i, LinearInterpAvx512 (iy0v, iy1v, zs));
+  }
+
+  return i;
+}
+
+// Single-precision kernels: the same steps as
+// GradientCoherentNoise3DWrappedSingle(), with twice as many input values
+// per register as the double-precision kernels.  Each group of input
+// values is loaded in two halves, whose cube corners are found with the
+// double-precision helpers above; the distances from the lower corners are
+// then rounded to float and packed into one register.
+
+// SSE4.1: four input values per __m128.
+
+NOISE_TARGET_SSE41 static inline void LoadCubeSse41Single (const double* n,
+  __m128& distance, __m128i& corner)
+{
+  __m128d n0 = _mm_loadu_pd (n);
+  __m128d n1 = _mm_loadu_pd (n + 2);
+  __m128d d0 = CubeFloorSse41 (n0);
+  __m128d d1 = CubeFloorSse41 (n1);
+  distance = _mm_movelh_ps (_mm_cvtpd_ps (_mm_sub_pd (n0, d0)),
+    _mm_cvtpd_ps (_mm_sub_pd (n1, d1)));
+  corner = _mm_unpacklo_epi64 (_mm_cvttpd_epi32 (d0),
+    _mm_cvttpd_epi32 (d1));
+}
+
+NOISE_TARGET_SSE41 static inline __m128 GradientNoise3DSse41Single (
+  __m128 xvPoint, __m128 yvPoint, __m128 zvPoint, __m128i ix, __m128i iy,
+  __m128i iz, __m128i seedTerm, const float* randomVectors)
+{
+  __m128i vectorIndex = _mm_add_epi32 (
+    _mm_add_epi32 (_mm_mullo_epi32 (ix, _mm_set1_epi32 (X_NOISE_GEN)),
+                   _mm_mullo_epi32 (iy, _mm_set1_epi32 (Y_NOISE_GEN))),
+    _mm_add_epi32 (_mm_mullo_epi32 (iz, _mm_set1_epi32 (Z_NOISE_GEN)),
+                   seedTerm));
+  vectorIndex = _mm_xor_si128 (vectorIndex,
+    _mm_srai_epi32 (vectorIndex, SHIFT_NOISE_GEN));
+  vectorIndex = _mm_slli_epi32 (
+    _mm_and_si128 (vectorIndex, _mm_set1_epi32 (0xff)), 2);
+
+  // Load the four gradient vectors as rows and transpose them.
+  __m128 xvGradient = _mm_loadu_ps (randomVectors
+    + _mm_cvtsi128_si32 (vectorIndex));
+  __m128 yvGradient = _mm_loadu_ps (randomVectors
+    + _mm_extract_epi32 (vectorIndex, 1));
+  __m128 zvGradient = _mm_loadu_ps (randomVectors
+    + _mm_extract_epi32 (vectorIndex, 2));
+  __m128 wvGradient = _mm_loadu_ps (randomVectors
+    + _mm_extract_epi32 (vectorIndex, 3));
+  _MM_TRANSPOSE4_PS (xvGradient, yvGradient, zvGradient, wvGradient);
+
+  __m128 dot = _mm_add_ps (
+    _mm_add_ps (_mm_mul_ps (xvGradient, xvPoint),
+                _mm_mul_ps (yvGradient, yvPoint)),
+    _mm_mul_ps (zvGradient, zvPoint));
+  return _mm_mul_ps (dot, _mm_set1_ps (2.12f));
+}
+
+NOISE_TARGET_SSE41 static inline __m128 LinearInterpSse41Single (__m128 n0,
+  __m128 n1, __m128 a)
+{
+  return _mm_add_ps (_mm_mul_ps (_mm_sub_ps (_mm_set1_ps (1.0f), a), n0),
+    _mm_mul_ps (a, n1));
+}
+
+NOISE_TARGET_SSE41 static inline __m128 SCurveSse41Single (__m128 a,
+  NoiseQuality noiseQuality)
+{
+  switch (noiseQuality) {
+    case QUALITY_STD:
+      return _mm_mul_ps (_mm_mul_ps (a, a),
+        _mm_sub_ps (_mm_set1_ps (3.0f), _mm_mul_ps (_mm_set1_ps (2.0f), a)));
+    case QUALITY_BEST: {
+      __m128 a3 = _mm_mul_ps (_mm_mul_ps (a, a), a);
+      __m128 a4 = _mm_mul_ps (a3, a);
+      __m128 a5 = _mm_mul_ps (a4, a);
+      return _mm_add_ps (
+        _mm_sub_ps (_mm_mul_ps (_mm_set1_ps (6.0f), a5),
+                    _mm_mul_ps (_mm_set1_ps (15.0f), a4)),
+        _mm_mul_ps (_mm_set1_ps (10.0f), a3));
+    }
+    default:
+      return a;
+  }
+}
+
+NOISE_TARGET_SSE41 static int GradientCoherentNoise3DSse41Single (
+  const double* x, const double* y, const double* z, double* values,
+  int count, int period, int seed, NoiseQuality noiseQuality)
+{
+  const float* randomVectors = GetRandomVectorsSingle ();
+  const __m128 one = _mm_set1_ps (1.0f);
+  const __m128i intOne = _mm_set1_epi32 (1);
+  const __m128i seedTerm = _mm_set1_epi32 (
+    (int)((unsigned int)SEED_NOISE_GEN * (unsigned int)seed));
+  const __m128i periodTerm = _mm_set1_epi32 (period);
+
+  int i = 0;
+  for (; i + 4 <= count; i += 4) {
+    __m128 xd0, yd0, zd0;
+    __m128i ix0, iy0, iz0;
+    LoadCubeSse41Single (x + i, xd0, ix0);
+    LoadCubeSse41Single (y + i, yd0, iy0);
+    LoadCubeSse41Single (z + i, zd0, iz0);
+    __m128 xd1 = _mm_sub_ps (xd0, one);
+    __m128 yd1 = _mm_sub_ps (yd0, one);
+    __m128 zd1 = _mm_sub_ps (zd0, one);
+    __m128i hx0 = ix0, hy0 = iy0, hz0 = iz0;
+    __m128i hx1 = _mm_add_epi32 (ix0, intOne);
+    __m128i hy1 = _mm_add_epi32 (iy0, intOne);
+    __m128i hz1 = _mm_add_epi32 (iz0, intOne);
+    WrapCornersSse41 (hx0, hx1, periodTerm);
+    WrapCornersSse41 (hy0, hy1, periodTerm);
+    WrapCornersSse41 (hz0, hz1, periodTerm);
+
+    __m128 xs = SCurveSse41Single (xd0, noiseQuality);
+    __m128 ys = SCurveSse41Single (yd0, noiseQuality);
+    __m128 zs = SCurveSse41Single (zd0, noiseQuality);
+
+    __m128 n0, n1, ix0v, ix1v, iy0v, iy1v;
+    n0   = GradientNoise3DSse41Single (xd0, yd0, zd0, hx0, hy0, hz0, seedTerm, randomVectors);
+    n1   = GradientNoise3DSse41Single (xd1, yd0, zd0, hx1, hy0, hz0, seedTerm, randomVectors);
+    ix0v = LinearInterpSse41Single (n0, n1, xs);
+    n0   = GradientNoise3DSse41Single (xd0, yd1, zd0, hx0, hy1, hz0, seedTerm, randomVectors);
+    n1   = GradientNoise3DSse41Single (xd1, yd1, zd0, hx1, hy1, hz0, seedTerm, randomVectors);
+    ix1v = LinearInterpSse41Single (n0, n1, xs);
+    iy0v = LinearInterpSse41Single (ix0v, ix1v, ys);
+    n0   = GradientNoise3DSse41Single (xd0, yd0, zd1, hx0, hy0, hz1, seedTerm, randomVectors);
+    n1   = GradientNoise3DSse41Single (xd1, yd0, zd1, hx1, hy0, hz1, seedTerm, randomVectors);
+    ix0v = LinearInterpSse41Single (n0, n1, xs);
+    n0   = GradientNoise3DSse41Single (xd0, yd1, zd1, hx0, hy1, hz1, seedTerm, randomVectors);
+    n1   = GradientNoise3DSse41Single (xd1, yd1, zd1, hx1, hy1, hz1, seedTerm, randomVectors);
+    ix1v = LinearInterpSse41Single (n0, n1, xs);
+    iy1v = LinearInterpSse41Single (ix0v, ix1v, ys);
+
+    __m128 result = LinearInterpSse41Single (iy0v, iy1v, zs);
+    _mm_storeu_pd (values + i    , _mm_cvtps_pd (result));
+    _mm_storeu_pd (values + i + 2, _mm_cvtps_pd (_mm_movehl_ps (result,
+      result)));
+  }
+
+  return i;
+}
+
+// AVX2: eight input values per __m256.
+
+NOISE_TARGET_AVX2 static inline void LoadCubeAvx2Single (const double* n,
+  __m256& distance, __m256i& corner)
+{
+  __m256d n0 = _mm256_loadu_pd (n);
+  __m256d n1 = _mm256_loadu_pd (n + 4);
+  __m256d d0 = CubeFloorAvx2 (n0);
+  __m256d d1 = CubeFloorAvx2 (n1);
+  distance = _mm256_insertf128_ps (
+    _mm256_castps128_ps256 (_mm256_cvtpd_ps (_mm256_sub_pd (n0, d0))),
+    _mm256_cvtpd_ps (_mm256_sub_pd (n1, d1)), 1);
+  corner = _mm256_inserti128_si256 (
+    _mm256_castsi128_si256 (_mm256_cvttpd_epi32 (d0)),
+    _mm256_cvttpd_epi32 (d1), 1);
+}
+
+NOISE_TARGET_AVX2 static inline __m256 GradientNoise3DAvx2Single (
+  __m256 xvPoint, __m256 yvPoint, __m256 zvPoint, __m256i ix, __m256i iy,
+  __m256i iz, __m256i seedTerm, const float* randomVectors)
+{
+  __m256i vectorIndex = _mm256_add_epi32 (
+    _mm256_add_epi32 (_mm256_mullo_epi32 (ix, _mm256_set1_epi32 (X_NOISE_GEN)),
+                      _mm256_mullo_epi32 (iy, _mm256_set1_epi32 (Y_NOISE_GEN))),
+    _mm256_add_epi32 (_mm256_mullo_epi32 (iz, _mm256_set1_epi32 (Z_NOISE_GEN)),
+                      seedTerm));
+  vectorIndex = _mm256_xor_si256 (vectorIndex,
+    _mm256_srai_epi32 (vectorIndex, SHIFT_NOISE_GEN));
+  vectorIndex = _mm256_slli_epi32 (
+    _mm256_and_si256 (vectorIndex, _mm256_set1_epi32 (0xff)), 2);
+
+  __m256 xvGradient = _mm256_i32gather_ps (randomVectors    , vectorIndex, 4);
+  __m256 yvGradient = _mm256_i32gather_ps (randomVectors + 1, vectorIndex, 4);
+  __m256 zvGradient = _mm256_i32gather_ps (randomVectors + 2, vectorIndex, 4);
+
+  __m256 dot = _mm256_add_ps (
+    _mm256_add_ps (_mm256_mul_ps (xvGradient, xvPoint),
+                   _mm256_mul_ps (yvGradient, yvPoint)),
+    _mm256_mul_ps (zvGradient, zvPoint));
+  return _mm256_mul_ps (dot, _mm256_set1_ps (2.12f));
+}
+
+NOISE_TARGET_AVX2 static inline __m256 LinearInterpAvx2Single (__m256 n0,
+  __m256 n1, __m256 a)
+{
+  return _mm256_add_ps (
+    _mm256_mul_ps (_mm256_sub_ps (_mm256_set1_ps (1.0f), a), n0),
+    _mm256_mul_ps (a, n1));
+}
+
+NOISE_TARGET_AVX2 static inline __m256 SCurveAvx2Single (__m256 a,
+  NoiseQuality noiseQuality)
+{
+  switch (noiseQuality) {
+    case QUALITY_STD:
+      return _mm256_mul_ps (_mm256_mul_ps (a, a),
+        _mm256_sub_ps (_mm256_set1_ps (3.0f),
+                       _mm256_mul_ps (_mm256_set1_ps (2.0f), a)));
+    case QUALITY_BEST: {
+      __m256 a3 = _mm256_mul_ps (_mm256_mul_ps (a, a), a);
+      __m256 a4 = _mm256_mul_ps (a3, a);
+      __m256 a5 = _mm256_mul_ps (a4, a);
+      return _mm256_add_ps (
+        _mm256_sub_ps (_mm256_mul_ps (_mm256_set1_ps (6.0f), a5),
+                       _mm256_mul_ps (_mm256_set1_ps (15.0f), a4)),
+        _mm256_mul_ps (_mm256_set1_ps (10.0f), a3));
+    }
+    default:
+      return a;
+  }
+}
+
+NOISE_TARGET_AVX2 static inline void WrapCornersAvx2Single (__m256i& lower,
+  __m256i& upper, __m256i period)
+{
+  lower = _mm256_add_epi32 (lower,
+    _mm256_and_si256 (_mm256_cmpgt_epi32 (_mm256_setzero_si256 (), lower), period));
+  upper = _mm256_andnot_si256 (_mm256_cmpeq_epi32 (upper, period), upper);
+}
+
+NOISE_TARGET_AVX2 static int GradientCoherentNoise3DAvx2Single (
+  const double* x, const double* y, const double* z, double* values,
+  int count, int period, int seed, NoiseQuality noiseQuality)
+{
+  const float* randomVectors = GetRandomVectorsSingle ();
+  const __m256 one = _mm256_set1_ps (1.0f);
+  const __m256i intOne = _mm256_set1_epi32 (1);
+  const __m256i seedTerm = _mm256_set1_epi32 (
+    (int)((unsigned int)SEED_NOISE_GEN * (unsigned int)seed));
+  const __m256i periodTerm = _mm256_set1_epi32 (period);
+
+  int i = 0;
+  for (; i + 8 <= count; i += 8) {
+    __m256 xd0, yd0, zd0;
+    __m256i ix0, iy0, iz0;
+    LoadCubeAvx2Single (x + i, xd0, ix0);
+    LoadCubeAvx2Single (y + i, yd0, iy0);
+    LoadCubeAvx2Single (z + i, zd0, iz0);
+    __m256 xd1 = _mm256_sub_ps (xd0, one);
+    __m256 yd1 = _mm256_sub_ps (yd0, one);
+    __m256 zd1 = _mm256_sub_ps (zd0, one);
+    __m256i hx0 = ix0, hy0 = iy0, hz0 = iz0;
+    __m256i hx1 = _mm256_add_epi32 (ix0, intOne);
+    __m256i hy1 = _mm256_add_epi32 (iy0, intOne);
+    __m256i hz1 = _mm256_add_epi32 (iz0, intOne);
+    WrapCornersAvx2Single (hx0, hx1, periodTerm);
+    WrapCornersAvx2Single (hy0, hy1, periodTerm);
+    WrapCornersAvx2Single (hz0, hz1, periodTerm);
+
+    __m256 xs = SCurveAvx2Single (xd0, noiseQuality);
+    __m256 ys = SCurveAvx2Single (yd0, noiseQuality);
+    __m256 zs = SCurveAvx2Single (zd0, noiseQuality);
+
+    __m256 n0, n1, ix0v, ix1v, iy0v, iy1v;
+    n0   = GradientNoise3DAvx2Single (xd0, yd0, zd0, hx0, hy0, hz0, seedTerm, randomVectors);
+    n1   = GradientNoise3DAvx2Single (xd1, yd0, zd0, hx1, hy0, hz0, seedTerm, randomVectors);
+    ix0v = LinearInterpAvx2Single (n0, n1, xs);
+    n0   = GradientNoise3DAvx2Single (xd0, yd1, zd0, hx0, hy1, hz0, seedTerm, randomVectors);
+    n1   = GradientNoise3DAvx2Single (xd1, yd1, zd0, hx1, hy1, hz0, seedTerm, randomVectors);
+    ix1v = LinearInterpAvx2Single (n0, n1, xs);
+    iy0v = LinearInterpAvx2Single (ix0v, ix1v, ys);
+    n0   = GradientNoise3DAvx2Single (xd0, yd0, zd1, hx0, hy0, hz1, seedTerm, randomVectors);
+    n1   = GradientNoise3DAvx2Single (xd1, yd0, zd1, hx1, hy0, hz1, seedTerm, randomVectors);
+    ix0v = LinearInterpAvx2Single (n0, n1, xs);
+    n0   = GradientNoise3DAvx2Single (xd0, yd1, zd1, hx0, hy1, hz1, seedTerm, randomVectors);
+    n1   = GradientNoise3DAvx2Single (xd1, yd1, zd1, hx1, hy1, hz1, seedTerm, randomVectors);
+    ix1v = LinearInterpAvx2Single (n0, n1, xs);
+    iy1v = LinearInterpAvx2Single (ix0v, ix1v, ys);
+
+    __m256 result = LinearInterpAvx2Single (iy0v, iy1v, zs);
+    _mm256_storeu_pd (values + i    ,
+      _mm256_cvtps_pd (_mm256_castps256_ps128 (result)));
+    _mm256_storeu_pd (values + i + 4,
+      _mm256_cvtps_pd (_mm256_extractf128_ps (result, 1)));
+  }
+
+  return i;
+}
+
+// AVX-512F: sixteen input values per __m512.  Only AVX-512F instructions
+// are used, so the halves are joined and split through their double and
+// 64-bit integer views.
+
+NOISE_TARGET_AVX512 static inline void LoadCubeAvx512Single (const double* n,
+  __m512& distance, __m512i& corner)
+{
+  __m512d n0 = _mm512_loadu_pd (n);
+  __m512d n1 = _mm512_loadu_pd (n + 8);
+  __m512d d0 = CubeFloorAvx512 (n0);
+  __m512d d1 = CubeFloorAvx512 (n1);
+  // Zero-masked conversions and inserts into a zeroed register, so that no
+  // register starts out undefined; see GradientNoise3DAvx2().
+  __m256 distance0 = _mm512_maskz_cvtpd_ps (0xff, _mm512_sub_pd (n0, d0));
+  __m256 distance1 = _mm512_maskz_cvtpd_ps (0xff, _mm512_sub_pd (n1, d1));
+  distance = _mm512_castpd_ps (_mm512_maskz_insertf64x4 (0xff,
+    _mm512_maskz_insertf64x4 (0xff, _mm512_setzero_pd (),
+      _mm256_castps_pd (distance0), 0),
+    _mm256_castps_pd (distance1), 1));
+  corner = _mm512_maskz_inserti64x4 (0xff,
+    _mm512_maskz_inserti64x4 (0xff, _mm512_setzero_si512 (),
+      _mm512_maskz_cvttpd_epi32 (0xff, d0), 0),
+    _mm512_maskz_cvttpd_epi32 (0xff, d1), 1);
+}
+
+NOISE_TARGET_AVX512 static inline __m512 GradientNoise3DAvx512Single (
+  __m512 xvPoint, __m512 yvPoint, __m512 zvPoint, __m512i ix, __m512i iy,
+  __m512i iz, __m512i seedTerm, const float* randomVectors)
+{
+  __m512i vectorIndex = _mm512_add_epi32 (
+    _mm512_add_epi32 (_mm512_mullo_epi32 (ix, _mm512_set1_epi32 (X_NOISE_GEN)),
+                      _mm512_mullo_epi32 (iy, _mm512_set1_epi32 (Y_NOISE_GEN))),
+    _mm512_add_epi32 (_mm512_mullo_epi32 (iz, _mm512_set1_epi32 (Z_NOISE_GEN)),
+                      seedTerm));
+  vectorIndex = _mm512_xor_si512 (vectorIndex,
+    _mm512_maskz_srai_epi32 (0xffff, vectorIndex, SHIFT_NOISE_GEN));
+  vectorIndex = _mm512_maskz_slli_epi32 (0xffff,
+    _mm512_and_si512 (vectorIndex, _mm512_set1_epi32 (0xff)), 2);
+
+  // Masked gathers with a zero source, as in GradientNoise3DAvx2().
+  __m512 xvGradient = _mm512_mask_i32gather_ps (_mm512_setzero_ps (), 0xffff,
+    vectorIndex, randomVectors    , 4);
+  __m512 yvGradient = _mm512_mask_i32gather_ps (_mm512_setzero_ps (), 0xffff,
+    vectorIndex, randomVectors + 1, 4);
+  __m512 zvGradient = _mm512_mask_i32gather_ps (_mm512_setzero_ps (), 0xffff,
+    vectorIndex, randomVectors + 2, 4);
+
+  __m512 dot = _mm512_add_ps (
+    _mm512_add_ps (_mm512_mul_ps (xvGradient, xvPoint),
+                   _mm512_mul_ps (yvGradient, yvPoint)),
+    _mm512_mul_ps (zvGradient, zvPoint));
+  return _mm512_mul_ps (dot, _mm512_set1_ps (2.12f));
+}
+
+NOISE_TARGET_AVX512 static inline __m512 LinearInterpAvx512Single (
+  __m512 n0, __m512 n1, __m512 a)
+{
+  return _mm512_add_ps (
+    _mm512_mul_ps (_mm512_sub_ps (_mm512_set1_ps (1.0f), a), n0),
+    _mm512_mul_ps (a, n1));
+}
+
+NOISE_TARGET_AVX512 static inline __m512 SCurveAvx512Single (__m512 a,
+  NoiseQuality noiseQuality)
+{
+  switch (noiseQuality) {
+    case QUALITY_STD:
+      return _mm512_mul_ps (_mm512_mul_ps (a, a),
+        _mm512_sub_ps (_mm512_set1_ps (3.0f),
+                       _mm512_mul_ps (_mm512_set1_ps (2.0f), a)));
+    case QUALITY_BEST: {
+      __m512 a3 = _mm512_mul_ps (_mm512_mul_ps (a, a), a);
+      __m512 a4 = _mm512_mul_ps (a3, a);
+      __m512 a5 = _mm512_mul_ps (a4, a);
+      return _mm512_add_ps (
+        _mm512_sub_ps (_mm512_mul_ps (_mm512_set1_ps (6.0f), a5),
+                       _mm512_mul_ps (_mm512_set1_ps (15.0f), a4)),
+        _mm512_mul_ps (_mm512_set1_ps (10.0f), a3));
+    }
+    default:
+      return a;
+  }
+}
+
+NOISE_TARGET_AVX512 static inline void WrapCornersAvx512Single (
+  __m512i& lower, __m512i& upper, __m512i period)
+{
+  lower = _mm512_mask_add_epi32 (lower,
+    _mm512_cmpgt_epi32_mask (_mm512_setzero_si512 (), lower), lower, period);
+  upper = _mm512_mask_mov_epi32 (upper,
+    _mm512_cmpeq_epi32_mask (upper, period), _mm512_setzero_si512 ());
+}
+
+NOISE_TARGET_AVX512 static int GradientCoherentNoise3DAvx512Single (
+  const double* x, const double* y, const double* z, double* values,
+  int count, int period, int seed, NoiseQuality noiseQuality)
+{
+  const float* randomVectors = GetRandomVectorsSingle ();
+  const __m512 one = _mm512_set1_ps (1.0f);
+  const __m512i intOne = _mm512_set1_epi32 (1);
+  const __m512i seedTerm = _mm512_set1_epi32 (
+    (int)((unsigned int)SEED_NOISE_GEN * (unsigned int)seed));
+  const __m512i periodTerm = _mm512_set1_epi32 (period);
+
+  int i = 0;
+  for (; i + 16 <= count; i += 16) {
+    __m512 xd0, yd0, zd0;
+    __m512i ix0, iy0, iz0;
+    LoadCubeAvx512Single (x + i, xd0, ix0);
+    LoadCubeAvx512Single (y + i, yd0, iy0);
+    LoadCubeAvx512Single (z + i, zd0, iz0);
+    __m512 xd1 = _mm512_sub_ps (xd0, one);
+    __m512 yd1 = _mm512_sub_ps (yd0, one);
+    __m512 zd1 = _mm512_sub_ps (zd0, one);
+    __m512i hx0 = ix0, hy0 = iy0, hz0 = iz0;
+    __m512i hx1 = _mm512_add_epi32 (ix0, intOne);
+    __m512i hy1 = _mm512_add_epi32 (iy0, intOne);
+    __m512i hz1 = _mm512_add_epi32 (iz0, intOne);
+    WrapCornersAvx512Single (hx0, hx1, periodTerm);
+    WrapCornersAvx512Single (hy0, hy1, periodTerm);
+    WrapCornersAvx512Single (hz0, hz1, periodTerm);
+
+    __m512 xs = SCurveAvx512Single (xd0, noiseQuality);
+    __m512 ys = SCurveAvx512Single (yd0, noiseQuality);
+    __m512 zs = SCurveAvx512Single (zd0, noiseQuality);
+
+    __m512 n0, n1, ix0v, ix1v, iy0v, iy1v;
+    n0   = GradientNoise3DAvx512Single (xd0, yd0, zd0, hx0, hy0, hz0, seedTerm, randomVectors);
+    n1   = GradientNoise3DAvx512Single (xd1, yd0, zd0, hx1, hy0, hz0, seedTerm, randomVectors);
+    ix0v = LinearInterpAvx512Single (n0, n1, xs);
+    n0   = GradientNoise3DAvx512Single (xd0, yd1, zd0, hx0, hy1, hz0, seedTerm, randomVectors);
+    n1   = GradientNoise3DAvx512Single (xd1, yd1, zd0, hx1, hy1, hz0, seedTerm, randomVectors);
+    ix1v = LinearInterpAvx512Single (n0, n1, xs);
+    iy0v = LinearInterpAvx512Single (ix0v, ix1v, ys);
+    n0   = GradientNoise3DAvx512Single (xd0, yd0, zd1, hx0, hy0, hz1, seedTerm, randomVectors);
+    n1   = GradientNoise3DAvx512Single (xd1, yd0, zd1, hx1, hy0, hz1, seedTerm, randomVectors);
+    ix0v = LinearInterpAvx512Single (n0, n1, xs);
+    n0   = GradientNoise3DAvx512Single (xd0, yd1, zd1, hx0, hy1, hz1, seedTerm, randomVectors);
+    n1   = GradientNoise3DAvx512Single (xd1, yd1, zd1, hx1, hy1, hz1, seedTerm, randomVectors);
+    ix1v = LinearInterpAvx512Single (n0, n1, xs);
+    iy1v = LinearInterpAvx512Single (ix0v, ix1v, ys);
+
+    __m512d result = _mm512_castps_pd (
+      LinearInterpAvx512Single (iy0v, iy1v, zs));
+    _mm512_storeu_pd (values + i    , _mm512_maskz_cvtps_pd (0xff,
+      _mm256_castpd_ps (_mm512_maskz_extractf64x4_pd (0xf, result, 0))));
+    _mm512_storeu_pd (values + i + 8, _mm512_maskz_cvtps_pd (0xff,
+      _mm256_castpd_ps (_mm512_maskz_extractf64x4_pd (0xf, result, 1))));
+  }
+
+  return i;
+}
+
+#endif
+
+// Single-precision body of both array versions; see
+// GradientCoherentNoise3DWrappedSingle().
+static void GradientCoherentNoise3DWrappedSingle (const double* x,
+  const double* y, const double* z, double* values, int count, int period,
+  int seed, NoiseQuality noiseQuality)
+{
+  int first = 0;
+#if NOISE_SIMD_X86
+  switch (g_simdLevel) {
+    case SIMD_AVX512:
+      first = GradientCoherentNoise3DAvx512Single (x, y, z, values, count,
+        period, seed, noiseQuality);
+      break;
+    case SIMD_AVX2:
+      first = GradientCoherentNoise3DAvx2Single (x, y, z, values, count,
+        period, seed, noiseQuality);
+      break;
+    case SIMD_SSE41:
+      first = GradientCoherentNoise3DSse41Single (x, y, z, values, count,
+        period, seed, noiseQuality);
+      break;
+    default:
+      break;
+  }
+#endif
+
+  for (int i = first; i < count; i++) {
+    values[i] = GradientCoherentNoise3DWrappedSingle (x[i], y[i], z[i],
+      period, seed, noiseQuality);
+  }
+}
+
+// Body of both array versions; see GradientCoherentNoise3DWrapped().
+static void GradientCoherentNoise3DWrapped (const double* x, const double* y,
+  const double* z, double* values, int count, int period, int seed,
+  NoiseQuality noiseQuality)
+{
+  if (t_noisePrecision == PRECISION_SINGLE) {
+    GradientCoherentNoise3DWrappedSingle (x, y, z, values, count, period,
+      seed, noiseQuality);
+    return;
+  }
+
+  // Each kernel returns how many input values it processed; the rest (less
+  // than one register) goes through the single-value version.
+  int first = 0;
+#if NOISE_SIMD_X86
+  switch (g_simdLevel) {
+    case SIMD_AVX512:
+      first = GradientCoherentNoise3DAvx512 (x, y, z, values, count, period,
+        seed, noiseQuality);
+      break;
+    case SIMD_AVX2:
+      first = GradientCoherentNoise3DAvx2 (x, y, z, values, count, period,
+        seed, noiseQuality);
+      break;
+    case SIMD_SSE41:
+      first = GradientCoherentNoise3DSse41 (x, y, z, values, count, period,
+        seed, noiseQuality);
+      break;
+    default:
+      break;
+  }
+#endif
+
+  for (int i = first; i < count; i++) {
+    values[i] = GradientCoherentNoise3DWrapped (x[i], y[i], z[i], period,
+      seed, noiseQuality);
+  }
+}
+
+void noise::GradientCoherentNoise3D (const double* x, const double* y,
+  const double* z, double* values, int count, int seed,
+  NoiseQuality noiseQuality)
+{
+  GradientCoherentNoise3DWrapped (x, y, z, values, count, 0, seed,
+    noiseQuality);
+}
+
+void noise::PeriodicGradientCoherentNoise3D (const double* x,
+  const double* y, const double* z, double* values, int count, int period,
+  int seed, NoiseQuality noiseQuality)
+{
+  GradientCoherentNoise3DWrapped (x, y, z, values, count, period, seed,
+    noiseQuality);
+}
+
+double noise::GradientNoise3D (double fx, double fy, double fz, int ix,
+  int iy, int iz, int seed)
+{
+  return GradientNoise3DWrapped (fx, fy, fz, ix, iy, iz, ix, iy, iz, seed);
 }
 
 int noise::IntValueNoise3D (int x, int y, int z, int seed)
 {
   // All constants are primes and must remain prime in order for this noise
-  // function to work correctly.
-  int n = (
-      X_NOISE_GEN    * x
-    + Y_NOISE_GEN    * y
-    + Z_NOISE_GEN    * z
-    + SEED_NOISE_GEN * seed)
+  // function to work correctly.  The products wrap around, so they are
+  // calculated on unsigned integers: a signed overflow would let the
+  // compiler drop the final mask and return negative values.
+  unsigned int n = (
+      X_NOISE_GEN    * (unsigned int)x
+    + Y_NOISE_GEN    * (unsigned int)y
+    + Z_NOISE_GEN    * (unsigned int)z
+    + SEED_NOISE_GEN * (unsigned int)seed)
     & 0x7fffffff;
   n = (n >> 13) ^ n;
-  return (n * (n * n * 60493 + 19990303) + 1376312589) & 0x7fffffff;
+  return (int)((n * (n * n * 60493 + 19990303) + 1376312589) & 0x7fffffff);
 }
 
 double noise::ValueCoherentNoise3D (double x, double y, double z, int seed,
@@ -2,20 +2,55 @@
 
 layout (location = 0) in vec3 pos;
 layout (location = 1) in vec3 normal;
+// vértices compactos (wega::PackedVertex): altura unorm 16 e normal
+// octaédrica snorm 8; X/Z saem de gl_VertexID como em height_texture.vert
+layout (location = 2) in float packed_height;
+layout (location = 3) in vec2 packed_normal;
 
 uniform mat4 view_matrix;
 uniform mat4 projection_matrix;
 uniform mat4 transformation_matrix;
 
+uniform bool packed_vertices;
+// grade do chunk e intervalo das alturas compactas
+// (ChunkUploader::SetPackedUniforms)
+uniform int grid_size;
+uniform int origin_x;
+uniform int origin_z;
+uniform int world_x;
+uniform int world_z;
+uniform float spacing;
+uniform float height_min;
+uniform float height_max;
+
 out vec3 o_normal;
 out vec3 o_pos;
 
+// inverso de EncodeOctahedral (chunk.cpp), com y como eixo do hemisfério
+vec3 DecodeOctahedral(vec2 e)
+{
+    vec3 n = vec3(e.x, 1.0 - abs(e.x) - abs(e.y), e.y);
+    if (n.y < 0.0)
+        n.xz = (1.0 - abs(n.zx)) * vec2(n.x >= 0.0 ? 1.0 : -1.0, n.z >= 0.0 ? 1.0 : -1.0);
+    return normalize(n);
+}
+
 void main(void)
 {
-    o_pos = vec3(transformation_matrix * vec4(pos, 1.0));
+    vec3 p = pos;
+    vec3 n = normal;
+
+    if (packed_vertices)
+    {
+        int x = (gl_VertexID % grid_size - origin_x + grid_size) % grid_size;
+        int z = (gl_VertexID / grid_size - origin_z + grid_size) % grid_size;
+        p = vec3(float(world_x + x) * spacing, mix(height_min, height_max, packed_height), float(world_z + z) * spacing);
+        n = DecodeOctahedral(packed_normal);
+    }
+
+    o_pos = vec3(transformation_matrix * vec4(p, 1.0));
     gl_Position = projection_matrix * view_matrix * vec4(o_pos, 1.0);
 
     /* o_normal = normal; */
-    o_normal = mat3(transpose(inverse(transformation_matrix))) * normal;
+    o_normal = mat3(transpose(inverse(transformation_matrix))) * n;
 }
-
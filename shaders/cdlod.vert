@@ -0,0 +1,30 @@
+#version 400 core
+
+layout (location = 0) in vec3 pos;
+layout (location = 1) in vec3 normal;
+// altura da superfície do nível de LOD seguinte sobre este vértice
+layout (location = 2) in float morph_height;
+
+uniform mat4 view_matrix;
+uniform mat4 projection_matrix;
+uniform mat4 transformation_matrix;
+// posição da câmera no espaço do terreno e distâncias (no mesmo espaço) em
+// que o morph para o nível seguinte começa e termina
+uniform vec3 morph_camera;
+uniform float morph_start;
+uniform float morph_end;
+
+out vec3 o_normal;
+out vec3 o_pos;
+
+void main(void)
+{
+    float distance_to_camera = distance(pos, morph_camera);
+    float k = clamp((distance_to_camera - morph_start) / (morph_end - morph_start), 0.0, 1.0);
+    vec3 morphed = vec3(pos.x, mix(pos.y, morph_height, k), pos.z);
+
+    o_pos = vec3(transformation_matrix * vec4(morphed, 1.0));
+    gl_Position = projection_matrix * view_matrix * vec4(o_pos, 1.0);
+
+    o_normal = mat3(transpose(inverse(transformation_matrix))) * normal;
+}
@@ -0,0 +1,45 @@
+#version 400 core
+
+// não há atributos: a amostra física vem de gl_VertexID (o mesmo index
+// buffer toroidal do Chunk) e a altura do heightmap em textura
+
+uniform mat4 view_matrix;
+uniform mat4 projection_matrix;
+uniform mat4 transformation_matrix;
+
+uniform sampler2D height_map;
+// posição física da amostra lógica (0, 0) e sua posição no mundo, em amostras
+uniform int origin_x;
+uniform int origin_z;
+uniform int world_x;
+uniform int world_z;
+uniform float spacing;
+
+out vec3 o_normal;
+out vec3 o_pos;
+
+int size;
+
+// altura da amostra lógica; fora do chunk vale 0, como em Chunk::GetHeight
+float Height(int x, int z)
+{
+    if (x < 0 || z < 0 || x >= size || z >= size)
+        return 0.0;
+    return texelFetch(height_map, ivec2((x + origin_x) % size, (z + origin_z) % size), 0).r;
+}
+
+void main(void)
+{
+    size = textureSize(height_map, 0).x;
+
+    int x = (gl_VertexID % size - origin_x + size) % size;
+    int z = (gl_VertexID / size - origin_z + size) % size;
+    vec3 pos = vec3(float(world_x + x) * spacing, Height(x, z), float(world_z + z) * spacing);
+    // mesmas diferenças centrais de Chunk::CalculateNormal
+    vec3 normal = normalize(vec3(Height(x - 1, z) - Height(x + 1, z), 2.0, Height(x, z - 1) - Height(x, z + 1)));
+
+    o_pos = vec3(transformation_matrix * vec4(pos, 1.0));
+    gl_Position = projection_matrix * view_matrix * vec4(o_pos, 1.0);
+
+    o_normal = mat3(transpose(inverse(transformation_matrix))) * normal;
+}
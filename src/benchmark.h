@@ -0,0 +1,215 @@
+#pragma once
+
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include <noise/noise.h>
+
+#include "chunk.h"
+#include "diamond_square.h"
+#include "noiseutils.h"
+#include "perlin_noise.h"
+#include "terrain_noise.h"
+
+// medições simples das rotinas de geração do terreno, rodadas por main
+// quando RUN_BENCHMARKS está habilitado. Cada função devolve o tempo médio
+// de uma execução, em milissegundos
+namespace wega
+{
+namespace benchmark
+{
+    template <typename F>
+    double Measure(int iterations, F f)
+    {
+        f();
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < iterations; i++)
+            f();
+        auto end = std::chrono::steady_clock::now();
+
+        return std::chrono::duration<double, std::milli>(end - start).count() / iterations;
+    }
+
+    // Chunk::GenerateMesh de um chunk sz x sz com alturas aleatórias
+    inline double GenerateMesh(unsigned int sz, unsigned int thread_count, int iterations = 20)
+    {
+        Chunk chunk{sz, 0, 0};
+        std::mt19937 rng{1};
+        std::uniform_real_distribution<double> height{-20.0, 20.0};
+        for (unsigned int z = 0; z < sz; z++)
+            for (unsigned int x = 0; x < sz; x++)
+                chunk.SetHeight(x, z, height(rng));
+
+        return Measure(iterations, [&]() { chunk.GenerateMesh(thread_count); });
+    }
+
+    // noise::GradientCoherentNoise3D em `count` pontos aleatórios com o
+    // conjunto de instruções `level`; SIMD_NONE mede a versão de um ponto por
+    // chamada
+    inline double GradientCoherentNoise(noise::SimdLevel level, int count = 1 << 18, int iterations = 20)
+    {
+        std::vector<double> x(count), y(count), z(count), values(count);
+        std::mt19937 rng{1};
+        std::uniform_real_distribution<double> coordinate{-1000.0, 1000.0};
+        for (int i = 0; i < count; i++)
+        {
+            x[i] = coordinate(rng);
+            y[i] = coordinate(rng);
+            z[i] = coordinate(rng);
+        }
+
+        const noise::SimdLevel previous = noise::GetSimdLevel();
+        noise::SetSimdLevel(level);
+        double ms = Measure(iterations, [&]()
+        {
+            if (level == noise::SIMD_NONE)
+                for (int i = 0; i < count; i++)
+                    values[i] = noise::GradientCoherentNoise3D(x[i], y[i], z[i]);
+            else
+                noise::GradientCoherentNoise3D(x.data(), y.data(), z.data(), values.data(), count);
+        });
+        noise::SetSimdLevel(previous);
+
+        return ms;
+    }
+
+    // NoiseMapBuilderPlane::Build do mapa sz x sz de main com `thread_count`
+    // threads (0 = todas), na precisão `precision`
+    inline double BuildNoiseMap(int sz, int thread_count, noise::NoisePrecision precision = noise::PRECISION_DOUBLE,
+        int iterations = 5)
+    {
+        TerrainNoise terrain_noise;
+        noise::utils::NoiseMap map;
+        noise::utils::NoiseMapBuilderPlane builder;
+        builder.SetSourceModule(terrain_noise.GetSource());
+        builder.SetDestNoiseMap(map);
+        builder.SetDestSize(sz, sz);
+        builder.SetBounds(0.0, 2.0, 0.0, 2.0);
+        builder.SetThreadCount(thread_count);
+        builder.SetPrecision(precision);
+
+        return Measure(iterations, [&]() { builder.Build(); });
+    }
+
+    // GetValues do TerrainNoise em sz x sz pontos do plano do mapa de main,
+    // com o grafo compilado (`compiled`) ou avaliado módulo a módulo
+    inline double EvaluateTerrainNoise(int sz, bool compiled, int iterations = 5)
+    {
+        TerrainNoise terrain_noise;
+        const noise::module::Module& source = compiled ? terrain_noise.GetSource() : terrain_noise.GetGraph();
+        const int count = sz * sz;
+        std::vector<double> x(count), y(count), z(count), values(count);
+        for (int i = 0; i < count; i++)
+        {
+            x[i] = 2.0 * (i % sz) / sz;
+            z[i] = 2.0 * (i / sz) / sz;
+        }
+
+        return Measure(iterations, [&]() { source.GetValues(x.data(), y.data(), z.data(), values.data(), count); });
+    }
+
+    // Turbulence sobre um Perlin em sz x sz pontos do plano do mapa de main,
+    // com o deslocamento exato (resolution 0) ou interpolado de uma grade
+    inline double EvaluateTurbulence(int sz, int resolution, int iterations = 5)
+    {
+        noise::module::Perlin perlin;
+        noise::module::Turbulence turbulence;
+        turbulence.SetSourceModule(0, perlin);
+        turbulence.SetFrequency(2.0);
+        turbulence.SetFieldResolution(resolution);
+        const int count = sz * sz;
+        std::vector<double> x(count), y(count), z(count), values(count);
+        for (int i = 0; i < count; i++)
+        {
+            x[i] = 2.0 * (i % sz) / sz;
+            z[i] = 2.0 * (i / sz) / sz;
+        }
+
+        return Measure(iterations, [&]() { turbulence.GetValues(x.data(), y.data(), z.data(), values.data(), count); });
+    }
+
+    // mapa seamless sz x sz de main: com `periodic` o grafo se repete na
+    // largura da janela e cada amostra é avaliada uma vez, sem ele o builder
+    // mistura quatro avaliações
+    inline double BuildSeamlessNoiseMap(int sz, bool periodic, int iterations = 5)
+    {
+        TerrainNoise terrain_noise;
+        noise::utils::NoiseMap map;
+        noise::utils::NoiseMapBuilderPlane builder;
+        builder.SetSourceModule(terrain_noise.GetSource());
+        builder.SetDestNoiseMap(map);
+        builder.SetDestSize(sz, sz);
+        builder.SetBounds(0.0, 2.0, 0.0, 2.0);
+        builder.EnableSeamless();
+        if (periodic)
+        {
+            terrain_noise.SetPeriod(2.0);
+            builder.EnablePeriodicSource();
+        }
+
+        return Measure(iterations, [&]() { builder.Build(); });
+    }
+
+    // diamond_square::Generate de uma grade sz x sz de float (sz = 2^n + 1)
+    // com `thread_count` threads (0 = todas)
+    inline double DiamondSquare(unsigned int sz, unsigned int thread_count, int iterations = 3)
+    {
+        std::vector<float> heights(static_cast<std::size_t>(sz) * sz);
+        diamond_square::Parameters parameters;
+        parameters.key = HashLayer(1, 1);
+        parameters.thread_count = thread_count;
+
+        return Measure(iterations, [&]() { diamond_square::Generate(heights.data(), sz, parameters); });
+    }
+
+    // octaveNoise do siv::PerlinNoise em sz x sz pontos, como em
+    // HeightGenerator::GetNoise, ponto a ponto ou com octaveNoiseGrid
+    inline double OctaveNoise(int sz, bool grid, int iterations = 5)
+    {
+        siv::PerlinNoise perlin{1};
+        std::vector<double> values(static_cast<std::size_t>(sz) * sz);
+
+        return Measure(iterations, [&]()
+        {
+            if (grid)
+                perlin.octaveNoiseGrid(0.0, 0.0, 1.0 / 8.0, 1.0 / 8.0, sz, sz, 4, values.data());
+            else
+                for (int z = 0; z < sz; z++)
+                    for (int x = 0; x < sz; x++)
+                        values[z * sz + x] = perlin.octaveNoise(x / 8.0, z / 8.0, 4);
+        });
+    }
+
+    inline void Run(void)
+    {
+        std::cout << "GenerateMesh 512x512, 1 thread: " << GenerateMesh(512, 1) << " ms\n";
+        std::cout << "GenerateMesh 512x512, todas as threads: " << GenerateMesh(512, 0) << " ms\n";
+
+        std::cout << "NoiseMapBuilderPlane 512x512, 1 thread: " << BuildNoiseMap(512, 1) << " ms\n";
+        std::cout << "NoiseMapBuilderPlane 512x512, todas as threads: " << BuildNoiseMap(512, 0) << " ms\n";
+        std::cout << "NoiseMapBuilderPlane 512x512, 1 thread, precisão simples: "
+            << BuildNoiseMap(512, 1, noise::PRECISION_SINGLE) << " ms\n";
+
+        std::cout << "DiamondSquare 8193x8193, todas as threads: " << DiamondSquare(8193, 0) << " ms\n";
+
+        std::cout << "siv::PerlinNoise 512x512, ponto a ponto: " << OctaveNoise(512, false) << " ms\n";
+        std::cout << "siv::PerlinNoise 512x512, octaveNoiseGrid: " << OctaveNoise(512, true) << " ms\n";
+
+        std::cout << "TerrainNoise 512x512, grafo: " << EvaluateTerrainNoise(512, false) << " ms\n";
+        std::cout << "TerrainNoise 512x512, programa: " << EvaluateTerrainNoise(512, true) << " ms\n";
+
+        std::cout << "Turbulence 512x512, exata: " << EvaluateTurbulence(512, 0) << " ms\n";
+        std::cout << "Turbulence 512x512, grade de resolução 4: " << EvaluateTurbulence(512, 4) << " ms\n";
+
+        std::cout << "NoiseMapBuilderPlane 512x512 seamless, mistura: " << BuildSeamlessNoiseMap(512, false) << " ms\n";
+        std::cout << "NoiseMapBuilderPlane 512x512 seamless, periódico: " << BuildSeamlessNoiseMap(512, true) << " ms\n";
+
+        static const char* const level_names[] = { "escalar", "SSE4.1", "AVX2", "AVX-512" };
+        for (int level = noise::SIMD_NONE; level <= noise::GetSupportedSimdLevel(); level++)
+            std::cout << "GradientCoherentNoise3D 2^18 pontos, " << level_names[level] << ": "
+                << GradientCoherentNoise(static_cast<noise::SimdLevel>(level)) << " ms\n";
+    }
+}
+}
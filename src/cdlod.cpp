@@ -0,0 +1,314 @@
+#include "cdlod.h"
+
+#include <algorithm>
+#include <cassert>
+#include <limits>
+
+namespace wega
+{
+Cdlod::Cdlod(Chunk* chunk)
+    : m_chunk(chunk), m_camera(0.0f)
+{
+    const unsigned int cells = chunk->GetSize() - 1;
+    assert(cells % LEAF_SIZE == 0);
+
+    m_level_count = 1;
+    while ((LEAF_SIZE << (m_level_count - 1)) < cells)
+        m_level_count++;
+    assert((LEAF_SIZE << (m_level_count - 1)) == cells);
+
+    const double leaf_extent = LEAF_SIZE * chunk->GetSpacing();
+    for (unsigned int l = 0; l < m_level_count; l++)
+        m_ranges.push_back(leaf_extent * LOD_DISTANCE_RATIO * (1 << l));
+    // a raiz é sempre desenhada quando visível
+    m_ranges.back() = std::numeric_limits<double>::max();
+
+    m_levels.resize(m_level_count);
+    for (auto& level : m_levels)
+    {
+        glGenVertexArrays(1, &level.vao);
+        glGenBuffers(1, &level.vbo);
+        glGenBuffers(1, &level.n_vbo);
+        glGenBuffers(1, &level.m_vbo);
+        glGenBuffers(1, &level.ibo);
+    }
+
+    Rebuild();
+}
+
+Cdlod::~Cdlod()
+{
+    for (auto& level : m_levels)
+    {
+        glDeleteBuffers(1, &level.vbo);
+        glDeleteBuffers(1, &level.n_vbo);
+        glDeleteBuffers(1, &level.m_vbo);
+        glDeleteBuffers(1, &level.ibo);
+        glDeleteVertexArrays(1, &level.vao);
+    }
+}
+
+int Cdlod::BuildNode(unsigned int level, unsigned int bx, unsigned int bz)
+{
+    Node node{level, bx, bz, glm::vec3{0.0f}, glm::vec3{0.0f}, {-1, -1, -1, -1}};
+    const unsigned int size = LEAF_SIZE << level;
+    const double spacing = m_chunk->GetSpacing();
+    double min_y = std::numeric_limits<double>::max();
+    double max_y = std::numeric_limits<double>::lowest();
+
+    if (level == 0)
+    {
+        for (unsigned int z = bz * size; z <= (bz + 1) * size; z++)
+            for (unsigned int x = bx * size; x <= (bx + 1) * size; x++)
+        {
+            double h = m_chunk->GetHeight(x, z);
+            min_y = std::min(min_y, h);
+            max_y = std::max(max_y, h);
+        }
+    }
+    else
+    {
+        for (int q = 0; q < 4; q++)
+        {
+            int child = BuildNode(level - 1, bx * 2 + (q & 1), bz * 2 + (q >> 1));
+            node.children[q] = child;
+            min_y = std::min(min_y, static_cast<double>(m_nodes[child].min.y));
+            max_y = std::max(max_y, static_cast<double>(m_nodes[child].max.y));
+        }
+    }
+
+    node.min = glm::vec3{(m_chunk->GetWorldX() + static_cast<int>(bx * size)) * spacing, min_y,
+                         (m_chunk->GetWorldZ() + static_cast<int>(bz * size)) * spacing};
+    node.max = glm::vec3{(m_chunk->GetWorldX() + static_cast<int>((bx + 1) * size)) * spacing, max_y,
+                         (m_chunk->GetWorldZ() + static_cast<int>((bz + 1) * size)) * spacing};
+
+    m_nodes.push_back(node);
+    return static_cast<int>(m_nodes.size()) - 1;
+}
+
+void Cdlod::GenerateLevel(unsigned int l, std::vector<GLdouble>& vertices, std::vector<GLdouble>& normals,
+    std::vector<GLfloat>& morph, std::vector<GLuint>& indices) const
+{
+    const unsigned int stride = 1 << l;
+    const unsigned int cells = (m_chunk->GetSize() - 1) >> l;
+    const unsigned int m = cells + 1;
+    const double spacing = m_chunk->GetSpacing();
+    const bool last = l + 1 == m_level_count;
+
+    const auto height = [&](unsigned int x, unsigned int z)
+    {
+        return m_chunk->GetHeight(x * stride, z * stride);
+    };
+
+    vertices.clear();
+    normals.clear();
+    morph.clear();
+    indices.clear();
+
+    for (unsigned int z = 0; z < m; z++)
+        for (unsigned int x = 0; x < m; x++)
+    {
+        vertices.push_back((m_chunk->GetWorldX() + static_cast<int>(x * stride)) * spacing);
+        vertices.push_back(height(x, z));
+        vertices.push_back((m_chunk->GetWorldZ() + static_cast<int>(z * stride)) * spacing);
+
+        const GLdouble* normal = m_chunk->GetNormal(x * stride, z * stride);
+        normals.insert(normals.end(), normal, normal + 3);
+
+        // altura da superfície do nível seguinte sobre este vértice: os
+        // ímpares caem no meio de uma aresta ou da diagonal (tr-bl) da célula
+        double target = height(x, z);
+        if (!last)
+        {
+            if (x % 2 == 1 && z % 2 == 1)
+                target = (height(x + 1, z - 1) + height(x - 1, z + 1)) / 2.0;
+            else if (x % 2 == 1)
+                target = (height(x - 1, z) + height(x + 1, z)) / 2.0;
+            else if (z % 2 == 1)
+                target = (height(x, z - 1) + height(x, z + 1)) / 2.0;
+        }
+        morph.push_back(static_cast<GLfloat>(target));
+    }
+
+    // os índices são agrupados por nó e, dentro do nó, por quadrante, para que
+    // tanto o nó inteiro quanto cada um dos seus quadrantes sejam um intervalo
+    // contíguo
+    const unsigned int blocks = cells / LEAF_SIZE;
+    const unsigned int half = LEAF_SIZE / 2;
+    for (unsigned int bz = 0; bz < blocks; bz++)
+        for (unsigned int bx = 0; bx < blocks; bx++)
+            for (unsigned int q = 0; q < 4; q++)
+                for (unsigned int cz = 0; cz < half; cz++)
+                    for (unsigned int cx = 0; cx < half; cx++)
+    {
+        unsigned int gx = bx * LEAF_SIZE + (q & 1) * half + cx;
+        unsigned int gz = bz * LEAF_SIZE + (q >> 1) * half + cz;
+        unsigned int tl = gz * m + gx;
+        unsigned int tr = tl + 1;
+        unsigned int bl = (gz + 1) * m + gx;
+        unsigned int br = bl + 1;
+        indices.push_back(tl);
+        indices.push_back(bl);
+        indices.push_back(tr);
+        indices.push_back(tr);
+        indices.push_back(bl);
+        indices.push_back(br);
+    }
+}
+
+void Cdlod::Rebuild(void)
+{
+    m_nodes.clear();
+    BuildNode(m_level_count - 1, 0, 0);
+
+    std::vector<GLdouble> vertices, normals;
+    std::vector<GLfloat> morph;
+    std::vector<GLuint> indices;
+
+    for (unsigned int l = 0; l < m_level_count; l++)
+    {
+        Level& level = m_levels[l];
+        level.cells = (m_chunk->GetSize() - 1) >> l;
+        GenerateLevel(l, vertices, normals, morph, indices);
+
+        glBindVertexArray(level.vao);
+
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, level.ibo);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(GLuint), indices.data(), GL_STATIC_DRAW);
+
+        glBindBuffer(GL_ARRAY_BUFFER, level.vbo);
+        glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(GLdouble), vertices.data(), GL_STATIC_DRAW);
+        glVertexAttribPointer(0, 3, GL_DOUBLE, GL_FALSE, 0, static_cast<void*>(0));
+        glEnableVertexAttribArray(0);
+
+        glBindBuffer(GL_ARRAY_BUFFER, level.n_vbo);
+        glBufferData(GL_ARRAY_BUFFER, normals.size() * sizeof(GLdouble), normals.data(), GL_STATIC_DRAW);
+        glVertexAttribPointer(1, 3, GL_DOUBLE, GL_TRUE, 0, static_cast<void*>(0));
+        glEnableVertexAttribArray(1);
+
+        glBindBuffer(GL_ARRAY_BUFFER, level.m_vbo);
+        glBufferData(GL_ARRAY_BUFFER, morph.size() * sizeof(GLfloat), morph.data(), GL_STATIC_DRAW);
+        glVertexAttribPointer(2, 1, GL_FLOAT, GL_FALSE, 0, static_cast<void*>(0));
+        glEnableVertexAttribArray(2);
+    }
+
+    glBindVertexArray(0);
+}
+
+bool Cdlod::InRange(const Node& node, const glm::vec3& camera, double range) const
+{
+    // distância da câmera até o ponto mais próximo da AABB
+    double dx = std::max({node.min.x - camera.x, 0.0f, camera.x - node.max.x});
+    double dy = std::max({node.min.y - camera.y, 0.0f, camera.y - node.max.y});
+    double dz = std::max({node.min.z - camera.z, 0.0f, camera.z - node.max.z});
+
+    return dx * dx + dy * dy + dz * dz <= range * range;
+}
+
+void Cdlod::Add(const Node& node, int quadrant)
+{
+    Level& level = m_levels[node.level];
+    const unsigned int blocks = level.cells / LEAF_SIZE;
+    size_t count = 6 * LEAF_SIZE * LEAF_SIZE;
+    size_t first = (node.bz * blocks + node.bx) * count;
+
+    if (quadrant >= 0)
+    {
+        count /= 4;
+        first += quadrant * count;
+    }
+
+    // junta com o intervalo anterior quando forem contíguos
+    if (!level.counts.empty())
+    {
+        size_t last_end = reinterpret_cast<size_t>(level.offsets.back()) / sizeof(GLuint) + level.counts.back();
+        if (last_end == first)
+        {
+            level.counts.back() += static_cast<GLsizei>(count);
+            return;
+        }
+    }
+
+    level.counts.push_back(static_cast<GLsizei>(count));
+    level.offsets.push_back(reinterpret_cast<const void*>(first * sizeof(GLuint)));
+}
+
+bool Cdlod::Select(int index, const glm::vec3& camera, const Frustum& frustum)
+{
+    const Node& node = m_nodes[index];
+
+    // fora do frustum: nem este nó nem os filhos são desenhados
+    if (!frustum.Intersects(node.min, node.max))
+        return true;
+    if (!InRange(node, camera, m_ranges[node.level]))
+        return false;
+
+    if (node.level == 0 || !InRange(node, camera, m_ranges[node.level - 1]))
+    {
+        Add(node, -1);
+        return true;
+    }
+
+    // os filhos fora do alcance do nível de baixo são desenhados como um
+    // quadrante deste nó
+    for (int q = 0; q < 4; q++)
+        if (!Select(node.children[q], camera, frustum))
+            Add(node, q);
+
+    return true;
+}
+
+void Cdlod::Select(const glm::vec3& camera, const glm::mat4& clip)
+{
+    for (auto& level : m_levels)
+    {
+        level.counts.clear();
+        level.offsets.clear();
+    }
+
+    m_camera = camera;
+    Frustum frustum{clip};
+    // a raiz é o último nó inserido
+    Select(static_cast<int>(m_nodes.size()) - 1, camera, frustum);
+}
+
+void Cdlod::Draw(const Shader& shader) const
+{
+    shader.SetV3("morph_camera", m_camera);
+
+    for (unsigned int l = 0; l < m_level_count; l++)
+    {
+        const Level& level = m_levels[l];
+        if (level.counts.empty())
+            continue;
+
+        // os vértices do nível l chegam à superfície do nível l + 1 no fim do
+        // seu alcance; a raiz não tem nível seguinte
+        float morph_start = std::numeric_limits<float>::max() / 2.0f;
+        float morph_end = std::numeric_limits<float>::max();
+        if (l + 1 < m_level_count)
+        {
+            double previous = l == 0 ? 0.0 : m_ranges[l - 1];
+            morph_end = static_cast<float>(m_ranges[l]);
+            morph_start = static_cast<float>(previous + (m_ranges[l] - previous) * MORPH_START_RATIO);
+        }
+
+        shader.SetFloat("morph_start", morph_start);
+        shader.SetFloat("morph_end", morph_end);
+        glBindVertexArray(level.vao);
+        glMultiDrawElements(GL_TRIANGLES, level.counts.data(), GL_UNSIGNED_INT, level.offsets.data(),
+            static_cast<GLsizei>(level.counts.size()));
+    }
+}
+
+size_t Cdlod::GetSelectedTriangleCount(void) const
+{
+    size_t count = 0;
+
+    for (const auto& level : m_levels)
+        for (GLsizei c : level.counts)
+            count += c / 3;
+
+    return count;
+}
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <vector>
+
+#include "chunk.h"
+#include "frustum.h"
+#include "shader.h"
+
+namespace wega
+{
+    // Continuous Distance-Dependent LOD (Strugar, 2009) sobre o heightmap de
+    // um Chunk. Cada nó da quadtree guarda a AABB das alturas que cobre e é
+    // desenhado com LEAF_SIZE x LEAF_SIZE células, com passo 2^nível no
+    // heightmap. A seleção descarta nós fora do frustum e escolhe o nível pela
+    // distância até a câmera; cada vértice guarda a altura da superfície do
+    // nível seguinte e o shader (cdlod.vert) interpola até ela conforme a
+    // distância, evitando popping e fendas entre nós de níveis vizinhos.
+    // Requer GetSize() - 1 = LEAF_SIZE * 2^k
+    class Cdlod
+    {
+    public:
+        static constexpr unsigned int LEAF_SIZE = 32;
+        // alcance do nível 0 em múltiplos do tamanho (no mundo) de uma folha
+        static constexpr double LOD_DISTANCE_RATIO = 4.0;
+        // fração do alcance de cada nível a partir da qual começa o morph
+        static constexpr double MORPH_START_RATIO = 0.66;
+    private:
+        struct Node
+        {
+            unsigned int level;
+            // bloco do nó dentro do nível (em nós)
+            unsigned int bx, bz;
+            glm::vec3 min, max;
+            int children[4];
+        };
+
+        struct Level
+        {
+            GLuint vao, vbo, n_vbo, m_vbo, ibo;
+            unsigned int cells;
+            std::vector<GLsizei> counts;
+            std::vector<const void*> offsets;
+        };
+
+        Chunk* m_chunk;
+        unsigned int m_level_count;
+        std::vector<Node> m_nodes;
+        std::vector<Level> m_levels;
+        std::vector<double> m_ranges;
+        glm::vec3 m_camera;
+
+        int BuildNode(unsigned int level, unsigned int bx, unsigned int bz);
+        void GenerateLevel(unsigned int l, std::vector<GLdouble>& vertices, std::vector<GLdouble>& normals,
+            std::vector<GLfloat>& morph, std::vector<GLuint>& indices) const;
+        bool Select(int index, const glm::vec3& camera, const Frustum& frustum);
+        void Add(const Node& node, int quadrant);
+        bool InRange(const Node& node, const glm::vec3& camera, double range) const;
+    public:
+        explicit Cdlod(Chunk* chunk);
+        ~Cdlod();
+
+        Cdlod(const Cdlod&) = delete;
+        Cdlod& operator=(const Cdlod&) = delete;
+
+        // refaz a quadtree e os buffers depois que o heightmap mudou
+        void Rebuild(void);
+        // `camera` no espaço do terreno e `clip` = projection * view *
+        // transformation
+        void Select(const glm::vec3& camera, const glm::mat4& clip);
+        void Draw(const Shader& shader) const;
+
+        size_t GetSelectedTriangleCount(void) const;
+    };
+}
@@ -1,21 +1,128 @@
 #include "chunk.h"
 
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <mutex>
 #include <glm/glm.hpp>
 #include <glad/glad.h>
 
+#include "cpu_features.h"
+#include "parallel_rows.h"
+
 namespace wega
 {
+namespace
+{
+// normal = normalize(h_l - h_r, 2, h_d - h_u) para n amostras de uma linha.
+// `mid` começa na amostra à esquerda da primeira; `up`/`down` são as linhas
+// z - 1 e z + 1 com o mesmo alinhamento. Todas as versões fazem as mesmas
+// operações IEEE na mesma ordem (sem FMA), então o resultado é idêntico
+using NormalKernel = void (*)(const double* up, const double* mid, const double* down, unsigned int n,
+    double* nx, double* ny, double* nz);
+
+void NormalsScalar(const double* up, const double* mid, const double* down, unsigned int i, unsigned int n,
+    double* nx, double* ny, double* nz)
+{
+    for (; i < n; i++)
+    {
+        double x = mid[i] - mid[i + 2];
+        double z = up[i + 1] - down[i + 1];
+        double inv = 1.0 / std::sqrt(x * x + z * z + 4.0);
+        nx[i] = x * inv;
+        ny[i] = 2.0 * inv;
+        nz[i] = z * inv;
+    }
+}
+
+void NormalsSse2(const double* up, const double* mid, const double* down, unsigned int n,
+    double* nx, double* ny, double* nz)
+{
+    const __m128d one = _mm_set1_pd(1.0);
+    const __m128d two = _mm_set1_pd(2.0);
+    const __m128d four = _mm_set1_pd(4.0);
+    unsigned int i = 0;
+
+    for (; i + 2 <= n; i += 2)
+    {
+        __m128d x = _mm_sub_pd(_mm_loadu_pd(mid + i), _mm_loadu_pd(mid + i + 2));
+        __m128d z = _mm_sub_pd(_mm_loadu_pd(up + i + 1), _mm_loadu_pd(down + i + 1));
+        __m128d len = _mm_add_pd(_mm_add_pd(_mm_mul_pd(x, x), _mm_mul_pd(z, z)), four);
+        __m128d inv = _mm_div_pd(one, _mm_sqrt_pd(len));
+        _mm_storeu_pd(nx + i, _mm_mul_pd(x, inv));
+        _mm_storeu_pd(ny + i, _mm_mul_pd(two, inv));
+        _mm_storeu_pd(nz + i, _mm_mul_pd(z, inv));
+    }
+
+    NormalsScalar(up, mid, down, i, n, nx, ny, nz);
+}
+
+WEGA_TARGET_AVX2 void NormalsAvx2(const double* up, const double* mid, const double* down, unsigned int n,
+    double* nx, double* ny, double* nz)
+{
+    const __m256d one = _mm256_set1_pd(1.0);
+    const __m256d two = _mm256_set1_pd(2.0);
+    const __m256d four = _mm256_set1_pd(4.0);
+    unsigned int i = 0;
+
+    for (; i + 4 <= n; i += 4)
+    {
+        __m256d x = _mm256_sub_pd(_mm256_loadu_pd(mid + i), _mm256_loadu_pd(mid + i + 2));
+        __m256d z = _mm256_sub_pd(_mm256_loadu_pd(up + i + 1), _mm256_loadu_pd(down + i + 1));
+        __m256d len = _mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(x, x), _mm256_mul_pd(z, z)), four);
+        __m256d inv = _mm256_div_pd(one, _mm256_sqrt_pd(len));
+        _mm256_storeu_pd(nx + i, _mm256_mul_pd(x, inv));
+        _mm256_storeu_pd(ny + i, _mm256_mul_pd(two, inv));
+        _mm256_storeu_pd(nz + i, _mm256_mul_pd(z, inv));
+    }
+
+    NormalsScalar(up, mid, down, i, n, nx, ny, nz);
+}
+
+NormalKernel SelectNormalKernel(void)
+{
+    return HasAvx2() ? NormalsAvx2 : NormalsSse2;
+}
+
+GLbyte ToSnorm8(double v)
+{
+    return static_cast<GLbyte>(std::lround(std::max(-1.0, std::min(1.0, v)) * 127.0));
+}
+
+// octaedro com y como eixo: projeta a normal em |x| + |y| + |z| = 1 e dobra o
+// hemisfério de baixo sobre o de cima
+void EncodeOctahedral(double x, double y, double z, GLbyte* out)
+{
+    const double l1 = std::fabs(x) + std::fabs(y) + std::fabs(z);
+    double u = x / l1;
+    double v = z / l1;
+
+    if (y < 0.0)
+    {
+        const double fu = (1.0 - std::fabs(v)) * (u >= 0.0 ? 1.0 : -1.0);
+        const double fv = (1.0 - std::fabs(u)) * (v >= 0.0 ? 1.0 : -1.0);
+        u = fu;
+        v = fv;
+    }
+
+    out[0] = ToSnorm8(u);
+    out[1] = ToSnorm8(v);
+}
+}
+
 void Chunk::GenerateIndices(void)
 {
     unsigned int p = 0;
 
-    for (unsigned int gz = 0; gz < m_sz - 1; gz++)
-        for (unsigned int gx = 0; gx < m_sz - 1; gx++)
+    // as células da última linha/coluna ligam a borda física à posição 0;
+    // elas só são desenhadas quando a origem do ring buffer não é (0, 0)
+    for (unsigned int gz = 0; gz < m_sz; gz++)
+        for (unsigned int gx = 0; gx < m_sz; gx++)
     {
         unsigned int tl = (gz * m_sz) + gx;
-        unsigned int tr = tl + 1;
-        unsigned int bl = ((gz + 1) * m_sz) + gx;
-        unsigned int br = bl + 1;
+        unsigned int tr = (gz * m_sz) + (gx + 1) % m_sz;
+        unsigned int bl = ((gz + 1) % m_sz * m_sz) + gx;
+        unsigned int br = ((gz + 1) % m_sz * m_sz) + (gx + 1) % m_sz;
         m_indices[p++] = tl;
         m_indices[p++] = bl;
         m_indices[p++] = tr;
@@ -23,37 +130,243 @@ void Chunk::GenerateIndices(void)
         m_indices[p++] = bl;
         m_indices[p++] = br;
     }
+
+    m_indices_dirty = true;
 }
 
-void Chunk::GenerateMesh(void)
+void Chunk::UpdateDrawRanges(void)
 {
-    unsigned int p = 0;
+    // a célula que liga a última amostra lógica à primeira é a emenda do toro
+    // e não pode ser desenhada. Como há uma emenda por linha, os intervalos
+    // entre duas emendas consecutivas são contíguos no index buffer
+    unsigned int start = 0, count = 0;
+
+    m_draw_counts.clear();
+    m_draw_offsets.clear();
 
-    for (unsigned int i = 0; i < m_sz; i++) 
-        for (unsigned int j = 0; j < m_sz; j++)
+    for (unsigned int gz = 0; gz < m_sz; gz++)
+        for (unsigned int gx = 0; gx < m_sz; gx++)
     {
-        GLdouble height = GetHeight(j, i);
-        m_vertices[p * 3] = (double)j/((double)m_sz - 1) * TERRAIN_SIZE;
-        m_vertices[p * 3 + 1] = height;
-        m_vertices[p * 3 + 2] = (double)i/((double)m_sz - 1) * TERRAIN_SIZE;
-
-        glm::vec3 normal = CalculateNormal(j, i);
-        m_normals[p * 3] = normal.x;
-        m_normals[p * 3 + 1] = normal.y;
-        m_normals[p * 3 + 2] = normal.z;
-        p++;
+        // célula lógica correspondente
+        unsigned int cx = (gx + m_sz - m_origin_x) % m_sz;
+        unsigned int cz = (gz + m_sz - m_origin_z) % m_sz;
+        bool in_hole = cx >= m_hole.x && cx < m_hole.x + m_hole.w && cz >= m_hole.z && cz < m_hole.z + m_hole.h;
+
+        if (cx == m_sz - 1 || cz == m_sz - 1 || in_hole)
+        {
+            if (count > 0)
+            {
+                m_draw_counts.push_back(6 * count);
+                m_draw_offsets.push_back(reinterpret_cast<const void*>(6 * start * sizeof(GLuint)));
+            }
+            count = 0;
+            continue;
+        }
+
+        if (count == 0)
+            start = gz * m_sz + gx;
+        count++;
+    }
+
+    if (count > 0)
+    {
+        m_draw_counts.push_back(6 * count);
+        m_draw_offsets.push_back(reinterpret_cast<const void*>(6 * start * sizeof(GLuint)));
     }
 }
 
-glm::vec3 Chunk::CalculateNormal(unsigned int x, unsigned int z)
+void Chunk::ReadRow(int z, unsigned int x0, unsigned int n, double* out) const
 {
-    double h_l = GetHeight(x - 1, z);
-    double h_r = GetHeight(x + 1, z);
-    double h_d = GetHeight(x, z - 1);
-    double h_u = GetHeight(x, z + 1);
-    glm::vec3 normal = glm::vec3{h_l - h_r, 2.0f, h_d - h_u};
+    if (z < 0 || z >= static_cast<int>(m_sz))
+    {
+        std::fill(out, out + n + 2, 0.0);
+        return;
+    }
 
-    return glm::normalize(normal);
+    const GLdouble* row = m_height_map + PhysicalZ(z) * m_sz;
+    const unsigned int px = PhysicalX(x0);
+    const unsigned int first = std::min(n, m_sz - px);
+
+    out[0] = x0 > 0 ? row[PhysicalX(x0 - 1)] : 0.0;
+    std::memcpy(out + 1, row + px, first * sizeof(double));
+    std::memcpy(out + 1 + first, row, (n - first) * sizeof(double));
+    out[n + 1] = x0 + n < m_sz ? row[PhysicalX(x0 + n)] : 0.0;
+}
+
+void Chunk::WriteRows(unsigned int z0, unsigned int z1, unsigned int x0, unsigned int x1,
+    GLdouble* vertices, GLdouble* normals, PackedVertex* packed)
+{
+    static const NormalKernel kernel = SelectNormalKernel();
+    const unsigned int n = x1 - x0;
+    const double spacing = GetSpacing();
+    const double height_scale = m_packed_max > m_packed_min ? 65535.0 / (m_packed_max - m_packed_min) : 0.0;
+
+    // três linhas consecutivas do heightmap (z - 1, z, z + 1) e as
+    // componentes das normais de uma linha
+    std::vector<double> rows(3 * (n + 2));
+    std::vector<double> row_normals(3 * n);
+    double* up = rows.data();
+    double* mid = up + n + 2;
+    double* down = mid + n + 2;
+    double* nx = row_normals.data();
+    double* ny = nx + n;
+    double* nz = ny + n;
+
+    ReadRow(static_cast<int>(z0) - 1, x0, n, up);
+    ReadRow(static_cast<int>(z0), x0, n, mid);
+
+    for (unsigned int z = z0; z < z1; z++)
+    {
+        ReadRow(static_cast<int>(z) + 1, x0, n, down);
+        kernel(up, mid, down, n, nx, ny, nz);
+
+        const double world_z = (double)(m_world_z + (int)z) * spacing;
+        const bool z_border = z == 0 || z == m_sz - 1;
+        GLdouble* vertex_row = vertices + 3 * PhysicalZ(z) * m_sz;
+        GLdouble* normal_row = normals + 3 * PhysicalZ(z) * m_sz;
+        unsigned int px = PhysicalX(x0);
+
+        for (unsigned int i = 0; i < n; i++)
+        {
+            const unsigned int x = x0 + i;
+            double height = mid[i + 1];
+            if (m_stitch_border)
+            {
+                if (z_border && x % 2 == 1)
+                    height = (mid[i] + mid[i + 2]) / 2.0;
+                else if ((x == 0 || x == m_sz - 1) && z % 2 == 1)
+                    height = (up[i + 1] + down[i + 1]) / 2.0;
+            }
+
+            vertex_row[px * 3] = (double)(m_world_x + (int)x) * spacing;
+            vertex_row[px * 3 + 1] = height;
+            vertex_row[px * 3 + 2] = world_z;
+
+            normal_row[px * 3] = nx[i];
+            normal_row[px * 3 + 1] = ny[i];
+            normal_row[px * 3 + 2] = nz[i];
+
+            if (packed != nullptr)
+            {
+                PackedVertex& p = packed[PhysicalZ(z) * m_sz + px];
+                p.height = static_cast<GLushort>(std::lround((height - m_packed_min) * height_scale));
+                EncodeOctahedral(nx[i], ny[i], nz[i], p.normal);
+            }
+
+            if (++px == m_sz)
+                px = 0;
+        }
+
+        double* previous_up = up;
+        up = mid;
+        mid = down;
+        down = previous_up;
+    }
+}
+
+void Chunk::GenerateMesh(unsigned int thread_count)
+{
+    m_packed_min = m_min_value;
+    m_packed_max = m_max_value;
+    GenerateMesh(m_vertices, m_normals, m_packed.empty() ? nullptr : m_packed.data(), thread_count);
+    // a região inteira substitui as anteriores
+    m_dirty_regions.assign(1, ChunkRegion{0, 0, m_sz, m_sz});
+}
+
+void Chunk::GenerateMesh(GLdouble* vertices, GLdouble* normals, unsigned int thread_count)
+{
+    GenerateMesh(vertices, normals, nullptr, thread_count);
+}
+
+void Chunk::GenerateMesh(GLdouble* vertices, GLdouble* normals, PackedVertex* packed, unsigned int thread_count)
+{
+    // cada thread escreve linhas físicas diferentes e só lê o heightmap
+    ForRows(m_sz, thread_count, [&](unsigned int z0, unsigned int z1)
+    {
+        WriteRows(z0, z1, 0, m_sz, vertices, normals, packed);
+    });
+}
+
+void Chunk::UpdateMesh(const ChunkRegion& region)
+{
+    // as alturas compactas são relativas ao intervalo do chunk; se ele mudou,
+    // nenhuma das anteriores vale mais
+    if (!m_packed.empty() && (m_packed_min != m_min_value || m_packed_max != m_max_value))
+    {
+        GenerateMesh();
+        return;
+    }
+
+    // a normal depende dos vizinhos, então a borda da região também muda
+    unsigned int x0 = region.x > 0 ? region.x - 1 : 0;
+    unsigned int z0 = region.z > 0 ? region.z - 1 : 0;
+    unsigned int x1 = std::min(region.x + region.w + 1, m_sz);
+    unsigned int z1 = std::min(region.z + region.h + 1, m_sz);
+
+    WriteRows(z0, z1, x0, x1, m_vertices, m_normals, m_packed.empty() ? nullptr : m_packed.data());
+
+    m_dirty_regions.push_back(ChunkRegion{x0, z0, x1 - x0, z1 - z0});
+}
+
+void Chunk::Scroll(int dx, int dz, const std::function<void (const ChunkRegion&)>& fill)
+{
+    const int sz = static_cast<int>(m_sz);
+    unsigned int nx = std::min(std::abs(dx), sz);
+    unsigned int nz = std::min(std::abs(dz), sz);
+
+    if (nx == 0 && nz == 0)
+        return;
+
+    m_world_x += dx;
+    m_world_z += dz;
+    m_origin_x = static_cast<unsigned int>(((static_cast<int>(m_origin_x) + dx) % sz + sz) % sz);
+    m_origin_z = static_cast<unsigned int>(((static_cast<int>(m_origin_z) + dz) % sz + sz) % sz);
+
+    // faixa de colunas expostas (todas as linhas) e faixa de linhas expostas
+    // (somente as colunas que ainda não foram cobertas pela primeira faixa)
+    std::vector<ChunkRegion> exposed;
+    unsigned int keep_x = dx > 0 ? 0 : nx;
+    if (nx > 0)
+        exposed.push_back(ChunkRegion{dx > 0 ? m_sz - nx : 0, 0, nx, m_sz});
+    if (nz > 0 && nx < m_sz)
+        exposed.push_back(ChunkRegion{keep_x, dz > 0 ? m_sz - nz : 0, m_sz - nx, nz});
+
+    for (const auto& region : exposed)
+        fill(region);
+
+    for (const auto& region : exposed)
+        UpdateMesh(region);
+
+    // a borda oposta perdeu um vizinho, então sua normal também muda
+    if (nx > 0 && nx < m_sz)
+        UpdateMesh(ChunkRegion{dx > 0 ? 0 : m_sz - 1, 0, 1, m_sz});
+    if (nz > 0 && nz < m_sz)
+        UpdateMesh(ChunkRegion{0, dz > 0 ? 0 : m_sz - 1, m_sz, 1});
+
+    UpdateDrawRanges();
+}
+
+void Chunk::EnablePackedVertices(bool enable)
+{
+    if (!enable)
+    {
+        m_packed.clear();
+        m_packed.shrink_to_fit();
+        return;
+    }
+
+    // preenchidos no próximo GenerateMesh (ou UpdateMesh, que reempacota tudo
+    // enquanto o intervalo não for o do chunk)
+    m_packed.resize(m_sz_squared);
+}
+
+void Chunk::SetHole(const ChunkRegion& hole)
+{
+    if (hole.x == m_hole.x && hole.z == m_hole.z && hole.w == m_hole.w && hole.h == m_hole.h)
+        return;
+
+    m_hole = hole;
+    UpdateDrawRanges();
 }
 
 GLdouble Chunk::GetSteepness(unsigned int x, unsigned int z)
@@ -73,20 +386,48 @@ GLdouble Chunk::GetSteepness(unsigned int x, unsigned int z)
     return glm::length(glm::vec2{dx, dz});
 }
 
-inline GLdouble Chunk::GetHeight(unsigned int x, unsigned int z)
-{
-    if (x < 0 || x >= m_sz || z < 0 || z >= m_sz)
-        return 0;
-    return *(m_height_map + x * m_sz + z);
-}
-
 void Chunk::SetHeight(unsigned int x, unsigned int z, double val)
 {
 	if (val > m_max_value)
 		m_max_value = val;
-	else if (val < m_min_value)
+	if (val < m_min_value)
 		m_min_value = val;
-	
-    *(m_height_map + x * m_sz + z) = val;
+
+    *(m_height_map + PhysicalZ(z) * m_sz + PhysicalX(x)) = val;
+}
+
+void Chunk::UpdateHeights(const std::function<void (unsigned int, double*)>& update, unsigned int thread_count)
+{
+    // cada thread copia a linha lógica para um buffer contíguo (a linha
+    // física está rodada por m_origin_x), a passa para `update` e a copia de
+    // volta; o intervalo de alturas de cada thread fica em variáveis locais
+    // e só é juntado uma vez no fim, para as threads não disputarem a mesma
+    // linha de cache a cada amostra
+    std::mutex range_mutex;
+    ForRows(m_sz, thread_count, [&](unsigned int z0, unsigned int z1)
+    {
+        std::vector<double> row(m_sz);
+        const unsigned int first = m_sz - m_origin_x;
+        double min_value = std::numeric_limits<double>::max();
+        double max_value = std::numeric_limits<double>::lowest();
+        for (unsigned int z = z0; z < z1; z++)
+        {
+            GLdouble* physical = m_height_map + PhysicalZ(z) * m_sz;
+            std::memcpy(row.data(), physical + m_origin_x, first * sizeof(double));
+            std::memcpy(row.data() + first, physical, m_origin_x * sizeof(double));
+            update(z, row.data());
+            for (unsigned int x = 0; x < m_sz; x++)
+            {
+                min_value = std::min(min_value, row[x]);
+                max_value = std::max(max_value, row[x]);
+            }
+            std::memcpy(physical + m_origin_x, row.data(), first * sizeof(double));
+            std::memcpy(physical, row.data() + first, m_origin_x * sizeof(double));
+        }
+
+        std::lock_guard<std::mutex> lock(range_mutex);
+        m_min_value = std::min(m_min_value, min_value);
+        m_max_value = std::max(m_max_value, max_value);
+    });
 }
 }
@@ -1,17 +1,34 @@
 #pragma once
 
 #include <cstring>
+#include <functional>
 #include <limits>
+#include <vector>
 #include <glm/glm.hpp>
 #include <glad/glad.h>
 
 namespace wega
 {
+// região retangular em coordenadas lógicas do chunk (em amostras)
+struct ChunkRegion
+{
+    unsigned int x, z, w, h;
+};
+
+// vértice compacto (4 bytes): X/Z saem do índice do vértice, a altura é um
+// unorm de 16 bits entre o mínimo e o máximo do chunk e a normal é codificada
+// em octaedro com 2 x 8 bits (snorm), com y como eixo do hemisfério
+struct PackedVertex
+{
+    GLushort height;
+    GLbyte normal[2];
+};
+
 class Chunk
 {
     static constexpr double TERRAIN_SIZE = 800.0;
     unsigned int m_sz, m_sz_squared;
-    unsigned int m_grid_x, m_grid_y;
+    int m_grid_x, m_grid_y;
 	double m_min_value, m_max_value;
     GLdouble* m_vertices;
     GLdouble* m_normals;
@@ -19,30 +36,71 @@ class Chunk
     GLuint* m_indices;
     int m_indices_size, m_vertices_size, m_normals_size, m_height_map_size;
 
-    glm::vec3 CalculateNormal(unsigned int x, unsigned int z);
+    // o heightmap (e os buffers de vértices/normais) é guardado por linha
+    // (z * m_sz + x) e é um ring buffer toroidal: a amostra lógica (0, 0)
+    // fica na posição física (m_origin_x, m_origin_z) e m_world_x/m_world_z
+    // guardam a posição da amostra lógica (0, 0) no mundo, em amostras
+    unsigned int m_origin_x, m_origin_z;
+    int m_world_x, m_world_z;
+    // intervalos do index buffer que não cruzam a emenda do toro
+    std::vector<GLsizei> m_draw_counts;
+    std::vector<const void*> m_draw_offsets;
+    // regiões lógicas cujos vértices/normais mudaram desde o último envio
+    // para a GPU e se o index buffer foi (re)gerado
+    std::vector<ChunkRegion> m_dirty_regions;
+    bool m_indices_dirty;
+    // células lógicas que não são desenhadas (ocupadas por outro nível do
+    // clipmap) e interpolação dos vértices ímpares da borda
+    ChunkRegion m_hole;
+    bool m_stitch_border;
+    // vértices compactos (vazio se desabilitado) e o intervalo de alturas
+    // usado para quantizá-los
+    std::vector<PackedVertex> m_packed;
+    double m_packed_min, m_packed_max;
+
     void GenerateIndices(void);
+    void UpdateDrawRanges(void);
+    // copia as alturas lógicas x0 - 1 .. x0 + n da linha z para `out` (n + 2
+    // valores), com 0 fora do chunk como em GetHeight
+    void ReadRow(int z, unsigned int x0, unsigned int n, double* out) const;
+    // reescreve vértices e normais das linhas lógicas [z0, z1) entre as
+    // colunas [x0, x1) em `vertices`/`normals` (layout de m_vertices) e, se
+    // `packed` não for nulo, também os vértices compactos
+    void WriteRows(unsigned int z0, unsigned int z1, unsigned int x0, unsigned int x1,
+        GLdouble* vertices, GLdouble* normals, PackedVertex* packed);
+    void GenerateMesh(GLdouble* vertices, GLdouble* normals, PackedVertex* packed, unsigned int thread_count);
+
+    unsigned int PhysicalX(unsigned int x) const { return (x + m_origin_x) % m_sz; }
+    unsigned int PhysicalZ(unsigned int z) const { return (z + m_origin_z) % m_sz; }
 public:
-    Chunk(unsigned int sz, unsigned int x, unsigned int y)
-        : m_sz(sz), m_grid_x(x), m_grid_y(y)
+    // (x, y) é a posição do chunk na grade do mundo; chunks vizinhos
+    // compartilham a linha/coluna de amostras da borda
+    Chunk(unsigned int sz, int x, int y)
+        : m_sz(sz), m_grid_x(x), m_grid_y(y), m_origin_x(0), m_origin_z(0),
+          m_world_x(x * static_cast<int>(sz - 1)), m_world_z(y * static_cast<int>(sz - 1)),
+          m_indices_dirty(false), m_hole{0, 0, 0, 0}, m_stitch_border(false),
+          m_packed_min(0.0), m_packed_max(0.0)
     {
 		m_sz_squared = sz * sz;
 
         m_vertices_size = m_sz_squared * 3;
         m_normals_size = m_sz_squared * 3;
         m_height_map_size = m_sz_squared;
-        m_indices_size = 6 * (m_sz - 1) * (m_sz - 1);
+        // uma célula por vértice físico, incluindo as que fecham o toro
+        m_indices_size = 6 * m_sz_squared;
 
         m_vertices = new GLdouble[m_vertices_size];
         m_normals = new GLdouble[m_normals_size];
         m_height_map = new GLdouble[m_height_map_size];
         m_indices = new GLuint[m_indices_size];
 		m_min_value = std::numeric_limits<double>::max();
-		m_max_value = std::numeric_limits<double>::min();
+		m_max_value = std::numeric_limits<double>::lowest();
 
         // preenche o heightmap com zeros
         std::memset(m_height_map, 0, sizeof(GLdouble) * m_height_map_size);
         GenerateMesh();
         GenerateIndices();
+        UpdateDrawRanges();
     }
 
     ~Chunk()
@@ -53,20 +111,104 @@ public:
         delete[] m_height_map;
     }
 
-    void GenerateMesh(void);
+    // `thread_count` = 0 usa todos os núcleos disponíveis. Marca o chunk
+    // inteiro como alterado
+    void GenerateMesh(unsigned int thread_count = 0);
+    // gera a malha diretamente em `vertices` e `normals` (GetVerticesSize()
+    // e GetNormalsSize() elementos, por exemplo um buffer mapeado na GPU)
+    // sem passar por m_vertices/m_normals
+    void GenerateMesh(GLdouble* vertices, GLdouble* normals, unsigned int thread_count = 0);
+    // reescreve vértices e normais apenas da região lógica informada
+    void UpdateMesh(const ChunkRegion& region);
+    // desloca a janela do chunk em amostras inteiras; as amostras que saem de
+    // um lado são reaproveitadas para as que entram do outro. `fill` recebe
+    // cada região lógica recém exposta e deve preencher suas alturas
+    void Scroll(int dx, int dz, const std::function<void (const ChunkRegion&)>& fill);
     GLdouble GetSteepness(unsigned int x, unsigned int z);
-    inline GLdouble GetHeight(unsigned int x, unsigned int z);
+    GLdouble GetHeight(unsigned int x, unsigned int z) const
+    {
+        if (x >= m_sz || z >= m_sz)
+            return 0;
+        return *(m_height_map + PhysicalZ(z) * m_sz + PhysicalX(x));
+    }
     void SetHeight(unsigned int x, unsigned int z, double val);
+    // reescreve as alturas linha a linha: `update` recebe a linha lógica z e
+    // as m_sz alturas dela em ordem lógica, e as altera no lugar. As linhas
+    // são divididas entre `thread_count` threads (0 = todos os núcleos),
+    // então `update` precisa poder ser chamado de várias threads ao mesmo
+    // tempo. Como SetHeight, não marca nada como alterado
+    void UpdateHeights(const std::function<void (unsigned int, double*)>& update, unsigned int thread_count = 0);
+    // normal (x, y, z) da amostra lógica, como gravada por GenerateMesh
+    const GLdouble* GetNormal(unsigned int x, unsigned int z) const
+    {
+        return m_normals + 3 * (PhysicalZ(z) * m_sz + PhysicalX(x));
+    }
+    // as células lógicas da região deixam de ser desenhadas
+    void SetHole(const ChunkRegion& hole);
+    // quando a borda encosta em uma grade com o dobro do espaçamento, os
+    // vértices ímpares da borda recebem a média dos vizinhos para que as
+    // arestas coincidam (sem T-junctions). O heightmap não é alterado
+    void EnableBorderStitching(bool enable = true) { m_stitch_border = enable; }
+    // mantém também os vértices no formato PackedVertex, gerados junto com as
+    // normais a partir do próximo GenerateMesh. Quando GetMinValue ou
+    // GetMaxValue mudam, UpdateMesh reempacota o chunk inteiro
+    void EnablePackedVertices(bool enable = true);
+    const PackedVertex* GetPackedVertices(void) const { return m_packed.data(); }
+    bool HasPackedVertices(void) const { return !m_packed.empty(); }
+    // intervalo que a altura 0..65535 dos vértices compactos representa
+    double GetPackedMin(void) const { return m_packed_min; }
+    double GetPackedMax(void) const { return m_packed_max; }
+
+    // chama f(primeiro_vértice, quantidade) para cada intervalo contíguo dos
+    // buffers de vértices/normais ocupado pela região lógica
+    template <typename F>
+    void ForEachSpan(const ChunkRegion& region, F f) const
+    {
+        for (unsigned int z = region.z; z < region.z + region.h; z++)
+        {
+            unsigned int row = PhysicalZ(z) * m_sz;
+            unsigned int px = PhysicalX(region.x);
+            unsigned int first = region.w < m_sz - px ? region.w : m_sz - px;
+            f(row + px, first);
+            if (first < region.w)
+                f(row, region.w - first);
+        }
+    }
+
+    const std::vector<ChunkRegion>& GetDirtyRegions(void) const { return m_dirty_regions; }
+    void ClearDirtyRegions(void) { m_dirty_regions.clear(); }
+    bool AreIndicesDirty(void) const { return m_indices_dirty; }
+    void ClearIndicesDirty(void) { m_indices_dirty = false; }
 
     GLdouble* GetVertices(void) const { return m_vertices; }
     GLdouble* GetNormals(void) const { return m_normals; }
     GLdouble* GetHeightMap(void) const { return m_height_map; }
     GLuint* GetIndices(void) const { return m_indices; }
+    const GLsizei* GetDrawCounts(void) const { return m_draw_counts.data(); }
+    const void* const* GetDrawOffsets(void) const { return m_draw_offsets.data(); }
+    GLsizei GetDrawCount(void) const { return static_cast<GLsizei>(m_draw_counts.size()); }
     int GetIndicesSize(void) const { return m_indices_size; }
     int GetVerticesSize(void) const { return m_vertices_size; }
     int GetNormalsSize(void) const { return m_normals_size; }
     int GetHeightMapSize(void) const { return m_height_map_size; }
     unsigned int GetSize(void) const { return m_sz; }
+    int GetGridX(void) const { return m_grid_x; }
+    int GetGridY(void) const { return m_grid_y; }
+    int GetWorldX(void) const { return m_world_x; }
+    int GetWorldZ(void) const { return m_world_z; }
+    // posição física da amostra lógica (0, 0)
+    unsigned int GetOriginX(void) const { return m_origin_x; }
+    unsigned int GetOriginZ(void) const { return m_origin_z; }
+    // distância entre duas amostras em coordenadas do mundo
+    double GetSpacing(void) const { return TERRAIN_SIZE / ((double)m_sz - 1); }
+    static constexpr double GetExtent(void) { return TERRAIN_SIZE; }
+    // translação que mantém a janela atual na mesma posição da tela
+    glm::vec3 GetScrollOffset(void) const
+    {
+        const int base_x = m_grid_x * static_cast<int>(m_sz - 1);
+        const int base_z = m_grid_y * static_cast<int>(m_sz - 1);
+        return glm::vec3{-(m_world_x - base_x) * GetSpacing(), 0.0f, -(m_world_z - base_z) * GetSpacing()};
+    }
 	double GetMinValue(void) const { return m_min_value; }
 	double GetMaxValue(void) const { return m_max_value; }
 };
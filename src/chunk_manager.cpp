@@ -0,0 +1,257 @@
+#include "chunk_manager.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+namespace wega
+{
+ChunkManager::ChunkManager(const noise::module::Module& source, unsigned int chunk_size, int radius,
+    double sample_delta, double amplitude, unsigned int worker_count, unsigned int upload_budget)
+    : m_source(source), m_chunk_size(chunk_size), m_radius(radius), m_sample_delta(sample_delta),
+      m_amplitude(amplitude), m_upload_budget(upload_budget),
+      m_ready((2 * radius + 3) * (2 * radius + 3))
+{
+    if (worker_count == 0)
+    {
+        // deixa um núcleo livre para a thread de renderização
+        unsigned int hw = std::thread::hardware_concurrency();
+        worker_count = hw > 1 ? hw - 1 : 1;
+    }
+
+    for (unsigned int i = 0; i < worker_count; i++)
+        m_workers.emplace_back(&ChunkManager::WorkerLoop, this);
+}
+
+ChunkManager::~ChunkManager()
+{
+    {
+        std::lock_guard<std::mutex> lock{m_jobs_mutex};
+        m_stop = true;
+        m_jobs.clear();
+    }
+    m_jobs_cv.notify_all();
+
+    for (auto& worker : m_workers)
+        worker.join();
+
+    Result result;
+    while (m_ready.Pop(result))
+        delete result.chunk;
+
+    for (auto& entry : m_chunks)
+        Release(entry.second);
+
+    if (m_ibo != 0)
+        glDeleteBuffers(1, &m_ibo);
+}
+
+void ChunkManager::WorkerLoop(void)
+{
+    // builder e noise map são por thread; somente o grafo de módulos é
+    // compartilhado
+    noise::utils::NoiseMapBuilderPlane builder;
+    noise::utils::NoiseMap map;
+    builder.SetSourceModule(m_source);
+    builder.SetDestNoiseMap(map);
+    builder.SetDestSize(m_chunk_size, m_chunk_size);
+
+    for (;;)
+    {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock{m_jobs_mutex};
+            m_jobs_cv.wait(lock, [this] { return m_stop || !m_jobs.empty(); });
+            if (m_stop)
+                return;
+            job = m_jobs.front();
+            m_jobs.pop_front();
+        }
+
+        Result result{job.x, job.y, Generate(job, builder, map)};
+
+        // a fila só enche se a thread de renderização estiver atrasada nos
+        // uploads; nesse caso o worker espera em vez de descartar o chunk
+        while (!m_ready.Push(result))
+        {
+            if (m_stop)
+            {
+                delete result.chunk;
+                return;
+            }
+            std::this_thread::yield();
+        }
+    }
+}
+
+Chunk* ChunkManager::Generate(const Job& job, noise::utils::NoiseMapBuilderPlane& builder, noise::utils::NoiseMap& map) const
+{
+    auto* chunk = new Chunk(m_chunk_size, job.x, job.y);
+
+    const double x0 = chunk->GetWorldX() * m_sample_delta;
+    const double z0 = chunk->GetWorldZ() * m_sample_delta;
+    builder.SetBounds(x0, x0 + m_chunk_size * m_sample_delta, z0, z0 + m_chunk_size * m_sample_delta);
+    builder.Build();
+
+    for (unsigned int z = 0; z < m_chunk_size; z++)
+        for (unsigned int x = 0; x < m_chunk_size; x++)
+            chunk->SetHeight(x, z, map.GetValue(x, z) * m_amplitude);
+
+    // o worker já roda em paralelo com os outros
+    chunk->GenerateMesh(1);
+    return chunk;
+}
+
+bool ChunkManager::InRange(const GridPos& p, int radius) const
+{
+    return std::abs(p.first - m_center.first) <= radius && std::abs(p.second - m_center.second) <= radius;
+}
+
+void ChunkManager::Schedule(void)
+{
+    std::vector<GridPos> missing;
+
+    for (int y = m_center.second - m_radius; y <= m_center.second + m_radius; y++)
+        for (int x = m_center.first - m_radius; x <= m_center.first + m_radius; x++)
+    {
+        GridPos p{x, y};
+        if (m_chunks.count(p) == 0 && m_pending.count(p) == 0)
+            missing.push_back(p);
+    }
+
+    if (missing.empty())
+        return;
+
+    // os mais próximos da câmera primeiro
+    std::sort(missing.begin(), missing.end(), [this](const GridPos& a, const GridPos& b)
+    {
+        int da = std::max(std::abs(a.first - m_center.first), std::abs(a.second - m_center.second));
+        int db = std::max(std::abs(b.first - m_center.first), std::abs(b.second - m_center.second));
+        return da < db;
+    });
+
+    {
+        std::lock_guard<std::mutex> lock{m_jobs_mutex};
+        for (const auto& p : missing)
+        {
+            m_jobs.push_back(Job{p.first, p.second});
+            m_pending.insert(p);
+        }
+    }
+    m_jobs_cv.notify_all();
+}
+
+void ChunkManager::Upload(const Result& result)
+{
+    GpuChunk gpu_chunk{result.chunk, 0, 0, 0};
+    Chunk* chunk = result.chunk;
+
+    glGenVertexArrays(1, &gpu_chunk.vao);
+    glBindVertexArray(gpu_chunk.vao);
+
+    // os índices só dependem do tamanho do chunk, então todos compartilham o
+    // mesmo index buffer
+    if (m_ibo == 0)
+    {
+        glGenBuffers(1, &m_ibo);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_ibo);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, chunk->GetIndicesSize() * sizeof(GLuint), chunk->GetIndices(), GL_STATIC_DRAW);
+        m_uploaded_bytes += chunk->GetIndicesSize() * sizeof(GLuint);
+    }
+    else
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_ibo);
+
+    glGenBuffers(1, &gpu_chunk.vbo);
+    glBindBuffer(GL_ARRAY_BUFFER, gpu_chunk.vbo);
+    glBufferData(GL_ARRAY_BUFFER, chunk->GetVerticesSize() * sizeof(GLdouble), chunk->GetVertices(), GL_STATIC_DRAW);
+    glVertexAttribPointer(0, 3, GL_DOUBLE, GL_FALSE, 0, static_cast<void*>(0));
+    glEnableVertexAttribArray(0);
+
+    glGenBuffers(1, &gpu_chunk.n_vbo);
+    glBindBuffer(GL_ARRAY_BUFFER, gpu_chunk.n_vbo);
+    glBufferData(GL_ARRAY_BUFFER, chunk->GetNormalsSize() * sizeof(GLdouble), chunk->GetNormals(), GL_STATIC_DRAW);
+    glVertexAttribPointer(1, 3, GL_DOUBLE, GL_TRUE, 0, static_cast<void*>(0));
+    glEnableVertexAttribArray(1);
+
+    glBindVertexArray(0);
+
+    m_uploaded_bytes += (chunk->GetVerticesSize() + chunk->GetNormalsSize()) * sizeof(GLdouble);
+    m_chunks[GridPos{result.x, result.y}] = gpu_chunk;
+}
+
+void ChunkManager::Release(GpuChunk& gpu_chunk)
+{
+    glDeleteBuffers(1, &gpu_chunk.vbo);
+    glDeleteBuffers(1, &gpu_chunk.n_vbo);
+    glDeleteVertexArrays(1, &gpu_chunk.vao);
+    delete gpu_chunk.chunk;
+    gpu_chunk.chunk = nullptr;
+}
+
+void ChunkManager::Update(const glm::vec3& position)
+{
+    const double extent = Chunk::GetExtent();
+    GridPos center{static_cast<int>(std::floor(position.x / extent)), static_cast<int>(std::floor(position.z / extent))};
+
+    if (!m_has_center || center != m_center)
+    {
+        m_center = center;
+        m_has_center = true;
+
+        // um chunk de folga evita gerar/descartar repetidamente quando a
+        // câmera anda sobre a borda
+        for (auto it = m_chunks.begin(); it != m_chunks.end();)
+        {
+            if (InRange(it->first, m_radius + 1))
+            {
+                ++it;
+                continue;
+            }
+            Release(it->second);
+            it = m_chunks.erase(it);
+        }
+
+        std::lock_guard<std::mutex> lock{m_jobs_mutex};
+        for (auto it = m_jobs.begin(); it != m_jobs.end();)
+        {
+            GridPos p{it->x, it->y};
+            if (InRange(p, m_radius))
+            {
+                ++it;
+                continue;
+            }
+            m_pending.erase(p);
+            it = m_jobs.erase(it);
+        }
+    }
+
+    Result result;
+    unsigned int uploaded = 0;
+    while (uploaded < m_upload_budget && m_ready.Pop(result))
+    {
+        GridPos p{result.x, result.y};
+        m_pending.erase(p);
+
+        if (!InRange(p, m_radius + 1) || m_chunks.count(p) != 0)
+        {
+            delete result.chunk;
+            continue;
+        }
+
+        Upload(result);
+        uploaded++;
+    }
+
+    Schedule();
+}
+
+void ChunkManager::Draw(void) const
+{
+    for (const auto& entry : m_chunks)
+    {
+        const Chunk* chunk = entry.second.chunk;
+        glBindVertexArray(entry.second.vao);
+        glMultiDrawElements(GL_TRIANGLES, chunk->GetDrawCounts(), GL_UNSIGNED_INT, chunk->GetDrawOffsets(), chunk->GetDrawCount());
+    }
+}
+}
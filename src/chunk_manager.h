@@ -0,0 +1,97 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "chunk.h"
+#include "lock_free_queue.h"
+#include "noiseutils.h"
+
+namespace wega
+{
+    // mantém os chunks dentro de um raio ao redor da câmera. Chunks que
+    // faltam são gerados por um pool de threads; os prontos voltam para a
+    // thread de renderização por uma fila sem locks e são enviados para a GPU
+    // em Update(), no máximo `upload_budget` por quadro
+    class ChunkManager
+    {
+        using GridPos = std::pair<int, int>;
+
+        struct GpuChunk
+        {
+            Chunk* chunk;
+            GLuint vao, vbo, n_vbo, ibo;
+        };
+
+        struct Job
+        {
+            int x, y;
+        };
+
+        struct Result
+        {
+            int x, y;
+            Chunk* chunk;
+        };
+
+        const noise::module::Module& m_source;
+        unsigned int m_chunk_size;
+        int m_radius;
+        double m_sample_delta;
+        double m_amplitude;
+        unsigned int m_upload_budget;
+
+        std::map<GridPos, GpuChunk> m_chunks;
+        GLuint m_ibo = 0;
+        size_t m_uploaded_bytes = 0;
+        // chunks pedidos aos workers e que ainda não voltaram
+        std::set<GridPos> m_pending;
+        GridPos m_center;
+        bool m_has_center = false;
+
+        std::vector<std::thread> m_workers;
+        std::deque<Job> m_jobs;
+        std::mutex m_jobs_mutex;
+        std::condition_variable m_jobs_cv;
+        std::atomic<bool> m_stop{false};
+        LockFreeQueue<Result> m_ready;
+
+        void WorkerLoop(void);
+        Chunk* Generate(const Job& job, noise::utils::NoiseMapBuilderPlane& builder, noise::utils::NoiseMap& map) const;
+        void Schedule(void);
+        void Upload(const Result& result);
+        void Release(GpuChunk& gpu_chunk);
+        bool InRange(const GridPos& p, int radius) const;
+    public:
+        // `sample_delta` é a distância entre duas amostras nas coordenadas do
+        // ruído; `source` precisa poder ser avaliado de várias threads
+        ChunkManager(const noise::module::Module& source, unsigned int chunk_size, int radius,
+            double sample_delta, double amplitude, unsigned int worker_count = 0,
+            unsigned int upload_budget = 2);
+        ~ChunkManager();
+
+        ChunkManager(const ChunkManager&) = delete;
+        ChunkManager& operator=(const ChunkManager&) = delete;
+
+        // chamado uma vez por quadro na thread de renderização com a posição
+        // da câmera no espaço do terreno (antes da transformation_matrix)
+        void Update(const glm::vec3& position);
+        void Draw(void) const;
+
+        size_t GetLoadedCount(void) const { return m_chunks.size(); }
+        size_t GetPendingCount(void) const { return m_pending.size(); }
+        // bytes enviados desde a última chamada de ResetUploadedBytes
+        size_t GetUploadedBytes(void) const { return m_uploaded_bytes; }
+        void ResetUploadedBytes(void) { m_uploaded_bytes = 0; }
+    };
+}
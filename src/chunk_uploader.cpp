@@ -0,0 +1,155 @@
+#include "chunk_uploader.h"
+
+#include <algorithm>
+#include <cstddef>
+
+namespace wega
+{
+ChunkUploader::ChunkUploader(bool packed)
+    : m_packed(packed)
+{
+    glCreateBuffers(1, &m_vbo);
+    glCreateBuffers(1, &m_n_vbo);
+    glCreateBuffers(1, &m_ibo);
+}
+
+ChunkUploader::~ChunkUploader()
+{
+    glDeleteBuffers(1, &m_vbo);
+    glDeleteBuffers(1, &m_n_vbo);
+    glDeleteBuffers(1, &m_ibo);
+}
+
+void ChunkUploader::Bind(bool attributes) const
+{
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_ibo);
+
+    if (!attributes)
+        return;
+
+    if (m_packed)
+    {
+        glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
+        glVertexAttribPointer(2, 1, GL_UNSIGNED_SHORT, GL_TRUE, sizeof(PackedVertex),
+            reinterpret_cast<void*>(offsetof(PackedVertex, height)));
+        glEnableVertexAttribArray(2);
+        glVertexAttribPointer(3, 2, GL_BYTE, GL_TRUE, sizeof(PackedVertex),
+            reinterpret_cast<void*>(offsetof(PackedVertex, normal)));
+        glEnableVertexAttribArray(3);
+        return;
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
+    glVertexAttribPointer(0, 3, GL_DOUBLE, GL_FALSE, 0, static_cast<void*>(0));
+    glEnableVertexAttribArray(0);
+
+    glBindBuffer(GL_ARRAY_BUFFER, m_n_vbo);
+    // normaliza as normais
+    glVertexAttribPointer(1, 3, GL_DOUBLE, GL_TRUE, 0, static_cast<void*>(0));
+    glEnableVertexAttribArray(1);
+}
+
+void ChunkUploader::SetPackedUniforms(const Shader& shader, const Chunk& chunk)
+{
+    shader.SetInt("grid_size", static_cast<int>(chunk.GetSize()));
+    shader.SetInt("origin_x", static_cast<int>(chunk.GetOriginX()));
+    shader.SetInt("origin_z", static_cast<int>(chunk.GetOriginZ()));
+    shader.SetInt("world_x", chunk.GetWorldX());
+    shader.SetInt("world_z", chunk.GetWorldZ());
+    shader.SetFloat("spacing", static_cast<float>(chunk.GetSpacing()));
+    shader.SetFloat("height_min", static_cast<float>(chunk.GetPackedMin()));
+    shader.SetFloat("height_max", static_cast<float>(chunk.GetPackedMax()));
+}
+
+void ChunkUploader::Store(GLuint buffer, GLsizeiptr& allocated, GLsizeiptr size, const void* data)
+{
+    if (size == allocated)
+        glNamedBufferSubData(buffer, 0, size, data);
+    else
+    {
+        glNamedBufferData(buffer, size, data, GL_DYNAMIC_DRAW);
+        allocated = size;
+    }
+
+    m_uploaded_bytes += size;
+}
+
+void ChunkUploader::UploadIndices(Chunk& chunk)
+{
+    if (!chunk.AreIndicesDirty())
+        return;
+
+    Store(m_ibo, m_indices_size, chunk.GetIndicesSize() * sizeof(GLuint), chunk.GetIndices());
+    chunk.ClearIndicesDirty();
+}
+
+void ChunkUploader::UploadIndices(const GLuint* indices, size_t count)
+{
+    Store(m_ibo, m_indices_size, count * sizeof(GLuint), indices);
+}
+
+void ChunkUploader::UploadMesh(Chunk& chunk)
+{
+    const auto& regions = chunk.GetDirtyRegions();
+    const GLsizeiptr vertices_size = m_packed
+        ? chunk.GetSize() * chunk.GetSize() * sizeof(PackedVertex)
+        : chunk.GetVerticesSize() * sizeof(GLdouble);
+    const GLsizeiptr normals_size = m_packed ? 0 : chunk.GetNormalsSize() * sizeof(GLdouble);
+
+    if (regions.empty())
+        return;
+
+    // buffer ainda sem espaço (ou de outro tamanho): envia tudo
+    if (m_vertices_size != vertices_size || m_normals_size != normals_size)
+    {
+        if (m_packed)
+            Store(m_vbo, m_vertices_size, vertices_size, chunk.GetPackedVertices());
+        else
+        {
+            Store(m_vbo, m_vertices_size, vertices_size, chunk.GetVertices());
+            Store(m_n_vbo, m_normals_size, normals_size, chunk.GetNormals());
+        }
+        chunk.ClearDirtyRegions();
+        return;
+    }
+
+    // faixas (primeiro vértice, quantidade) ordenadas e sem sobreposição
+    m_spans.clear();
+    for (const auto& region : regions)
+        chunk.ForEachSpan(region, [this](unsigned int first, unsigned int count)
+        {
+            m_spans.emplace_back(first, count);
+        });
+    std::sort(m_spans.begin(), m_spans.end());
+
+    size_t merged = 0;
+    for (size_t i = 1; i < m_spans.size(); i++)
+    {
+        auto& last = m_spans[merged];
+        if (m_spans[i].first <= last.first + last.second)
+            last.second = std::max(last.first + last.second, m_spans[i].first + m_spans[i].second) - last.first;
+        else
+            m_spans[++merged] = m_spans[i];
+    }
+    m_spans.resize(merged + 1);
+
+    for (const auto& span : m_spans)
+    {
+        if (m_packed)
+        {
+            const GLsizeiptr size = span.second * sizeof(PackedVertex);
+            glNamedBufferSubData(m_vbo, span.first * sizeof(PackedVertex), size, chunk.GetPackedVertices() + span.first);
+            m_uploaded_bytes += size;
+            continue;
+        }
+
+        const GLintptr offset = span.first * 3 * sizeof(GLdouble);
+        const GLsizeiptr size = span.second * 3 * sizeof(GLdouble);
+        glNamedBufferSubData(m_vbo, offset, size, chunk.GetVertices() + span.first * 3);
+        glNamedBufferSubData(m_n_vbo, offset, size, chunk.GetNormals() + span.first * 3);
+        m_uploaded_bytes += 2 * size;
+    }
+
+    chunk.ClearDirtyRegions();
+}
+}
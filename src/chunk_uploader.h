@@ -0,0 +1,62 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include <utility>
+#include <vector>
+
+#include "chunk.h"
+#include "shader.h"
+
+namespace wega
+{
+    // buffers de vértices, normais e índices de um Chunk na GPU. Envia só o
+    // que o chunk marcou como alterado (os índices quando foram gerados, as
+    // faixas de vértices/normais de GetDirtyRegions) e só realoca um buffer
+    // quando o tamanho muda. Usa DSA (glNamedBuffer*), então não depende do
+    // VAO ou dos buffers selecionados. No modo `packed` envia só os
+    // PackedVertex do chunk (4 bytes por vértice em vez de 48)
+    class ChunkUploader
+    {
+        bool m_packed;
+        GLuint m_vbo, m_n_vbo, m_ibo;
+        // bytes alocados em cada buffer
+        GLsizeiptr m_vertices_size = 0, m_normals_size = 0, m_indices_size = 0;
+        size_t m_uploaded_bytes = 0;
+        std::vector<std::pair<unsigned int, unsigned int>> m_spans;
+
+        void Store(GLuint buffer, GLsizeiptr& allocated, GLsizeiptr size, const void* data);
+    public:
+        explicit ChunkUploader(bool packed = false);
+        ~ChunkUploader();
+
+        ChunkUploader(const ChunkUploader&) = delete;
+        ChunkUploader& operator=(const ChunkUploader&) = delete;
+
+        // associa o index buffer e, se `attributes`, os vértices (atributo 0)
+        // e as normais (atributo 1) ao VAO selecionado. No modo `packed`, a
+        // altura vai no atributo 2 e a normal octaédrica no 3
+        void Bind(bool attributes = true) const;
+        // envia para ambient.vert o que ele precisa para decodificar os
+        // vértices compactos do chunk (posição da grade e intervalo de alturas)
+        static void SetPackedUniforms(const Shader& shader, const Chunk& chunk);
+
+        // envia os índices se o chunk os marcou como alterados
+        void UploadIndices(Chunk& chunk);
+        // substitui o conteúdo do index buffer (por exemplo, por uma malha
+        // adaptativa)
+        void UploadIndices(const GLuint* indices, size_t count);
+        // envia as regiões alteradas de vértices e normais, juntando as faixas
+        // contíguas ou sobrepostas, e limpa a lista do chunk
+        void UploadMesh(Chunk& chunk);
+        void Upload(Chunk& chunk)
+        {
+            UploadIndices(chunk);
+            UploadMesh(chunk);
+        }
+
+        // bytes enviados desde a última chamada de ResetUploadedBytes
+        size_t GetUploadedBytes(void) const { return m_uploaded_bytes; }
+        void ResetUploadedBytes(void) { m_uploaded_bytes = 0; }
+    };
+}
@@ -0,0 +1,135 @@
+#include "clipmap.h"
+
+#include <cmath>
+#include <glm/gtc/matrix_transform.hpp>
+
+namespace wega
+{
+Clipmap::Clipmap(const noise::module::Module& source, unsigned int n, unsigned int level_count,
+    double sample_delta, double lower_x, double lower_z, double amplitude)
+    : m_source(source), m_n(n), m_lower_x(lower_x), m_lower_z(lower_z), m_amplitude(amplitude)
+{
+    m_builder.SetSourceModule(m_source);
+    m_builder.SetDestNoiseMap(m_map);
+
+    for (unsigned int i = 0; i < level_count; i++)
+    {
+        Level level{new Chunk(n, 0, 0), nullptr, 0, sample_delta * (1 << i), static_cast<float>(1 << i)};
+        // só o nível mais grosso não encosta em uma grade com o dobro do
+        // espaçamento
+        level.chunk->EnableBorderStitching(i + 1 < level_count);
+        Fill(level, ChunkRegion{0, 0, n, n});
+        level.chunk->GenerateMesh();
+
+        level.uploader = new ChunkUploader();
+        level.uploader->Upload(*level.chunk);
+
+        glGenVertexArrays(1, &level.vao);
+        glBindVertexArray(level.vao);
+        level.uploader->Bind();
+        glBindVertexArray(0);
+        m_levels.push_back(level);
+    }
+}
+
+Clipmap::~Clipmap()
+{
+    for (auto& level : m_levels)
+    {
+        delete level.uploader;
+        glDeleteVertexArrays(1, &level.vao);
+        delete level.chunk;
+    }
+}
+
+void Clipmap::Fill(Level& level, const ChunkRegion& r)
+{
+    Chunk* chunk = level.chunk;
+    double x0 = m_lower_x + (chunk->GetWorldX() + static_cast<int>(r.x)) * level.delta;
+    double z0 = m_lower_z + (chunk->GetWorldZ() + static_cast<int>(r.z)) * level.delta;
+    m_builder.SetBounds(x0, x0 + r.w * level.delta, z0, z0 + r.h * level.delta);
+    m_builder.SetDestSize(r.w, r.h);
+    m_builder.Build();
+
+    for (unsigned int z = 0; z < r.h; z++)
+        for (unsigned int x = 0; x < r.w; x++)
+            chunk->SetHeight(r.x + x, r.z + z, m_map.GetValue(x, z) * m_amplitude);
+}
+
+void Clipmap::Update(const glm::vec3& position)
+{
+    const int half = static_cast<int>(m_n - 1) / 2;
+    const int ring = static_cast<int>(m_n - 1) / 4;
+
+    for (auto& level : m_levels)
+    {
+        Chunk* chunk = level.chunk;
+        const double spacing = chunk->GetSpacing() * level.scale;
+
+        // a origem de cada nível é sempre par, então as amostras pares do
+        // nível coincidem com as do nível seguinte
+        int ox = 2 * static_cast<int>(std::floor(position.x / spacing / 2.0)) - half;
+        int oz = 2 * static_cast<int>(std::floor(position.z / spacing / 2.0)) - half;
+
+        chunk->Scroll(ox - chunk->GetWorldX(), oz - chunk->GetWorldZ(), [&](const ChunkRegion& r)
+        {
+            Fill(level, r);
+        });
+    }
+
+    // o nível mais fino ocupa (n - 1) / 2 células do nível seguinte, deslocado
+    // de (n - 1) / 4 ou (n - 1) / 4 + 1 células dependendo do arredondamento
+    for (size_t i = 1; i < m_levels.size(); i++)
+    {
+        const Chunk* fine = m_levels[i - 1].chunk;
+        Chunk* coarse = m_levels[i].chunk;
+        int hx = fine->GetWorldX() / 2 - coarse->GetWorldX();
+        int hz = fine->GetWorldZ() / 2 - coarse->GetWorldZ();
+        coarse->SetHole(ChunkRegion{static_cast<unsigned int>(hx), static_cast<unsigned int>(hz),
+            static_cast<unsigned int>(2 * ring), static_cast<unsigned int>(2 * ring)});
+    }
+
+    for (auto& level : m_levels)
+        level.uploader->UploadMesh(*level.chunk);
+}
+
+void Clipmap::Draw(const Shader& shader, const glm::mat4& transformation) const
+{
+    for (const auto& level : m_levels)
+    {
+        const Chunk* chunk = level.chunk;
+        shader.SetM4F("transformation_matrix", glm::scale(transformation, glm::vec3{level.scale, 1.0f, level.scale}));
+        glBindVertexArray(level.vao);
+        glMultiDrawElements(GL_TRIANGLES, chunk->GetDrawCounts(), GL_UNSIGNED_INT, chunk->GetDrawOffsets(), chunk->GetDrawCount());
+    }
+
+    shader.SetM4F("transformation_matrix", transformation);
+}
+
+size_t Clipmap::GetTriangleCount(void) const
+{
+    size_t count = 0;
+
+    for (const auto& level : m_levels)
+        for (GLsizei i = 0; i < level.chunk->GetDrawCount(); i++)
+            count += level.chunk->GetDrawCounts()[i] / 3;
+
+    return count;
+}
+
+size_t Clipmap::GetUploadedBytes(void) const
+{
+    size_t bytes = 0;
+
+    for (const auto& level : m_levels)
+        bytes += level.uploader->GetUploadedBytes();
+
+    return bytes;
+}
+
+void Clipmap::ResetUploadedBytes(void)
+{
+    for (auto& level : m_levels)
+        level.uploader->ResetUploadedBytes();
+}
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <vector>
+
+#include "chunk.h"
+#include "chunk_uploader.h"
+#include "noiseutils.h"
+#include "shader.h"
+
+namespace wega
+{
+    // geometry clipmap: níveis aninhados de grades com n x n amostras (n =
+    // 2^k + 1) centrados na câmera, cada um com o dobro do espaçamento do
+    // anterior. Cada nível é um Chunk toroidal que só avalia as faixas
+    // expostas quando a câmera anda. Um nível não desenha as células cobertas
+    // pelo nível mais fino, e a borda do nível mais fino interpola os vértices
+    // ímpares para coincidir com as arestas do nível mais grosso. O número de
+    // triângulos depende só de n e da quantidade de níveis
+    class Clipmap
+    {
+        struct Level
+        {
+            Chunk* chunk;
+            ChunkUploader* uploader;
+            GLuint vao;
+            // distância entre amostras nas coordenadas do ruído
+            double delta;
+            // fator de escala horizontal em relação ao nível 0
+            float scale;
+        };
+
+        const noise::module::Module& m_source;
+        unsigned int m_n;
+        double m_lower_x, m_lower_z;
+        double m_amplitude;
+        std::vector<Level> m_levels;
+        noise::utils::NoiseMapBuilderPlane m_builder;
+        noise::utils::NoiseMap m_map;
+
+        void Fill(Level& level, const ChunkRegion& r);
+    public:
+        // `sample_delta` é a distância entre amostras do nível 0 nas
+        // coordenadas do ruído; (lower_x, lower_z) é a coordenada de ruído da
+        // amostra (0, 0) do mundo
+        Clipmap(const noise::module::Module& source, unsigned int n, unsigned int level_count,
+            double sample_delta, double lower_x, double lower_z, double amplitude);
+        ~Clipmap();
+
+        Clipmap(const Clipmap&) = delete;
+        Clipmap& operator=(const Clipmap&) = delete;
+
+        // recentraliza os níveis na posição da câmera (no espaço do terreno,
+        // antes da transformation_matrix) e envia as faixas alteradas
+        void Update(const glm::vec3& position);
+        // desenha todos os níveis, ajustando a transformation_matrix de cada um
+        void Draw(const Shader& shader, const glm::mat4& transformation) const;
+
+        unsigned int GetLevelCount(void) const { return static_cast<unsigned int>(m_levels.size()); }
+        // extensão do nível mais grosso, em unidades do mundo
+        double GetExtent(void) const { return Chunk::GetExtent() * m_levels.back().scale; }
+        size_t GetTriangleCount(void) const;
+        // bytes enviados por todos os níveis desde a última chamada de
+        // ResetUploadedBytes
+        size_t GetUploadedBytes(void) const;
+        void ResetUploadedBytes(void);
+    };
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#include <immintrin.h>
+// o MSVC aceita intrinsics de qualquer ISA sem flags de compilação
+#define WEGA_TARGET_AVX2
+#else
+#include <cpuid.h>
+#include <immintrin.h>
+#define WEGA_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+namespace wega
+{
+    // AVX2 disponível na CPU e habilitado pelo sistema operacional (registradores
+    // ymm salvos na troca de contexto). SSE2 faz parte do x86-64 e não precisa
+    // ser verificado
+    inline bool HasAvx2(void)
+    {
+#if defined(_MSC_VER)
+        int info[4];
+        __cpuid(info, 0);
+        if (info[0] < 7)
+            return false;
+        __cpuid(info, 1);
+        const bool os_avx = (info[2] & (1 << 27)) && (info[2] & (1 << 28)) && (_xgetbv(0) & 6) == 6;
+        __cpuidex(info, 7, 0);
+        return os_avx && (info[1] & (1 << 5));
+#else
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2");
+#endif
+    }
+}
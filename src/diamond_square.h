@@ -0,0 +1,121 @@
+#pragma once
+
+#include <cstdint>
+
+#include "parallel_rows.h"
+#include "random_hash.h"
+
+// diamond-square em grades de (2^n + 1) x (2^n + 1) pontos, guardadas por
+// linha (z * size + x). Cada nível roda o passo diamond e depois o passo
+// square, e cada passo divide suas linhas entre threads: um ponto só lê
+// pontos de níveis (ou do passo) anteriores e o deslocamento dele é o hash
+// da sua posição no mundo, então o resultado não depende do número de
+// threads
+namespace wega
+{
+namespace diamond_square
+{
+    struct Parameters
+    {
+        // chave do hash (HashLayer) e posição do ponto (0, 0) no mundo
+        std::uint64_t key = 0;
+        int world_x = 0, world_z = 0;
+        // sorteia os quatro cantos em [corner_min, corner_max]; sem isso os
+        // cantos já gravados na grade são usados
+        bool seed_corners = true;
+        double corner_min = 0.0, corner_max = 1.0;
+        // intervalo do deslocamento somado à média no primeiro nível,
+        // multiplicado por offset_scale a cada nível
+        double offset_min = -0.5, offset_max = 0.5;
+        double offset_scale = 0.5;
+        // 0 = todos os núcleos
+        unsigned int thread_count = 0;
+    };
+
+    // menor 2^n + 1 que comporta `size` pontos
+    inline unsigned int GetGridSize(unsigned int size)
+    {
+        unsigned int cells = 1;
+        while (cells + 1 < size)
+            cells *= 2;
+        return cells + 1;
+    }
+
+    // preenche `heights`, uma grade size x size com size = 2^n + 1. Os
+    // pontos da borda usam só os dois vizinhos da própria borda, então
+    // grades vizinhas com a mesma chave e o mesmo tamanho geram a mesma
+    // borda
+    template <typename T>
+    void Generate(T* heights, unsigned int size, const Parameters& parameters)
+    {
+        const auto offset = [&](unsigned int x, unsigned int z, double lower, double upper)
+        {
+            const double u = HashToUnit(HashPoint(parameters.key, parameters.world_x + static_cast<int>(x),
+                parameters.world_z + static_cast<int>(z)));
+            return lower + u * (upper - lower);
+        };
+        const auto at = [&](unsigned int x, unsigned int z) -> T& { return heights[static_cast<std::size_t>(z) * size + x]; };
+
+        const unsigned int last = size - 1;
+        if (parameters.seed_corners)
+            for (unsigned int z : { 0u, last })
+                for (unsigned int x : { 0u, last })
+                    at(x, z) = static_cast<T>(offset(x, z, parameters.corner_min, parameters.corner_max));
+
+        double lower = parameters.offset_min, upper = parameters.offset_max;
+        for (unsigned int step = last; step > 1; step /= 2)
+        {
+            const unsigned int half = step / 2;
+            const unsigned int squares = last / step;
+
+            // diamond: centro de cada quadrado = média dos cantos
+            ForRows(squares, parameters.thread_count, [&](unsigned int r0, unsigned int r1)
+            {
+                for (unsigned int j = r0; j < r1; j++)
+                {
+                    const unsigned int z = j * step;
+                    for (unsigned int x = 0; x < last; x += step)
+                        at(x + half, z + half) = static_cast<T>(
+                            (static_cast<double>(at(x, z)) + at(x + step, z) + at(x, z + step) + at(x + step, z + step)) / 4.0 +
+                            offset(x + half, z + half, lower, upper));
+                }
+            });
+
+            // square: pontos do meio das arestas = média dos vizinhos a
+            // `half` de distância. As linhas pares têm os pontos das
+            // arestas horizontais, as ímpares os das verticais
+            ForRows(2 * squares + 1, parameters.thread_count, [&](unsigned int r0, unsigned int r1)
+            {
+                const auto set = [&](unsigned int x, unsigned int z, double sum)
+                {
+                    at(x, z) = static_cast<T>(sum / 4.0 + offset(x, z, lower, upper));
+                };
+
+                for (unsigned int k = r0; k < r1; k++)
+                {
+                    const unsigned int z = k * half;
+                    if (z == 0 || z == last)
+                    {
+                        for (unsigned int x = half; x < last; x += step)
+                            set(x, z, 2.0 * (static_cast<double>(at(x - half, z)) + at(x + half, z)));
+                        continue;
+                    }
+
+                    unsigned int x = half;
+                    if (k % 2 == 1)
+                    {
+                        set(0, z, 2.0 * (static_cast<double>(at(0, z - half)) + at(0, z + half)));
+                        set(last, z, 2.0 * (static_cast<double>(at(last, z - half)) + at(last, z + half)));
+                        x = step;
+                    }
+                    for (; x < last; x += step)
+                        set(x, z, static_cast<double>(at(x - half, z)) + at(x + half, z) + at(x, z - half) + at(x, z + half));
+                }
+            });
+
+            lower *= parameters.offset_scale;
+            upper *= parameters.offset_scale;
+        }
+    }
+}
+}
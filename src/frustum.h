@@ -0,0 +1,44 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+namespace wega
+{
+    // planos do frustum extraídos de uma matriz de clip (Gribb/Hartmann). Com
+    // projection * view * transformation os planos ficam no espaço do terreno
+    class Frustum
+    {
+        glm::vec4 m_planes[6];
+    public:
+        explicit Frustum(const glm::mat4& m)
+        {
+            // a glm guarda as matrizes por coluna
+            glm::vec4 row[4];
+            for (int i = 0; i < 4; i++)
+                row[i] = glm::vec4{m[0][i], m[1][i], m[2][i], m[3][i]};
+
+            m_planes[0] = row[3] + row[0];
+            m_planes[1] = row[3] - row[0];
+            m_planes[2] = row[3] + row[1];
+            m_planes[3] = row[3] - row[1];
+            m_planes[4] = row[3] + row[2];
+            m_planes[5] = row[3] - row[2];
+        }
+
+        // false somente se a AABB estiver inteiramente fora de algum plano
+        bool Intersects(const glm::vec3& min, const glm::vec3& max) const
+        {
+            for (const auto& plane : m_planes)
+            {
+                // vértice da AABB mais à frente na direção da normal do plano
+                glm::vec3 p{plane.x >= 0.0f ? max.x : min.x,
+                            plane.y >= 0.0f ? max.y : min.y,
+                            plane.z >= 0.0f ? max.z : min.z};
+                if (plane.x * p.x + plane.y * p.y + plane.z * p.z + plane.w < 0.0f)
+                    return false;
+            }
+
+            return true;
+        }
+    };
+}
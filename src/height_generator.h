@@ -3,12 +3,16 @@
 #include <glm/glm.hpp>
 #include <glm/geometric.hpp>
 
+#include <algorithm>
+#include <cstdint>
 #include <cstdlib>
 #include <iostream>
 #include <ctime>
 #include <functional>
-#include <random>
 #include <cmath>
+#include <limits>
+#include <utility>
+#include <vector>
 
 #include <noise/noise.h>
 #include <noise/module/perlin.h>
@@ -16,6 +20,8 @@
 #include "noiseutils.h"
 #include "perlin_noise.h"
 #include "chunk.h"
+#include "diamond_square.h"
+#include "random_hash.h"
 #include "screen.h"
 
 namespace wega
@@ -31,54 +37,318 @@ namespace wega
         Chunk* m_chunk;
         siv::PerlinNoise* m_perlin_noise;
         unsigned int m_terrain_size;
-        std::mt19937 m_generator;
+        // camadas aleatórias já aplicadas; entra na chave de Rand para que
+        // duas camadas não tirem os mesmos valores
+        unsigned int m_layer = 0;
         double m_min = 999999.9, m_max = -999999.9;
         double m_threshold = -1.0;
+        // rolagem incremental: somente as faixas expostas passam pelo builder
+        const module::Module* m_scroll_source = nullptr;
+        double m_scroll_lower_x = 0.0, m_scroll_lower_z = 0.0, m_scroll_delta = 0.0;
+        utils::NoiseMapBuilderPlane m_strip_builder;
+        utils::NoiseMap m_strip_map;
 
         double GetNoise(int x, int z)
         {
             return m_perlin_noise->octaveNoise(x / FREQUENCY, z / FREQUENCY, OCTAVES);
         }
 
-        void ApplyLayer(std::function<double (int, int, int)>& f)
+        // inteiro em [min, max] tirado do hash da semente, da camada e da
+        // chave (x, z, index), sem estado: o valor não depende da ordem das
+        // chamadas, então uma camada pode ser avaliada em qualquer ordem ou
+        // por várias threads. As camadas usam como chave a posição do ponto
+        // no mundo, de modo que um chunk se repete sem gerar os vizinhos
+        static double HashRand(int seed, unsigned int layer, int min, int max, int x, int z, unsigned int index)
         {
-            for (unsigned int i = 0; i < m_terrain_size; i++)
-                for (unsigned int j = 0; j < m_terrain_size; j++)
-                {
-                    double current_value = m_chunk->GetHeight(j, i);
-                    double new_value = f(current_value, j, i);
-                    SetHeight(j, i, new_value);
-                    /* *(m_terrain_data + i * m_terrain_size + j) = new_value; */
-                }
+            const std::uint64_t h = MixBits(HashPoint(HashLayer(seed, layer), x, z) ^ index);
+
+            // os 32 bits altos escalados para o intervalo
+            const std::uint64_t range = static_cast<std::uint64_t>(static_cast<std::int64_t>(max) - min + 1);
+            return min + static_cast<std::int64_t>(((h >> 32) * range) >> 32);
         }
 
-        double Rand(int min, int max)
+        // HashRand na semente e na camada atuais
+        double Rand(int min, int max, int x, int z, unsigned int index = 0) const
         {
-            std::uniform_int_distribution<> dis{min, max};
-            return dis(m_generator);
+            return HashRand(m_seed, m_layer, min, max, x, z, index);
         }
 
-        void SetHeight(unsigned int x, unsigned int z, double val)
+        // um passo de ApplyLayers: a altura nova é limitada a [0, AMPLITUDE]
+        // e entra no intervalo [lo, hi], mas um ponto abaixo do limiar fica
+        // como está. Só o resultado de cada camada entra no intervalo; os
+        // valores intermediários dela (como os de cada pico de VoronoiLayer)
+        // não
+        template <typename Layer>
+        static double ApplyStep(const Layer& layer, double c, int x, int z, double threshold, double& lo, double& hi)
         {
-            if (val < 0) val = 0;
-            else if (val > AMPLITUDE) val = AMPLITUDE;
+            double val = layer(c, x, z);
+            val = val < 0.0 ? 0.0 : (val > AMPLITUDE ? AMPLITUDE : val);
+            lo = val < lo ? val : lo;
+            hi = val > hi ? val : hi;
+            return c < threshold ? c : val;
+        }
 
-            if (val > m_max) m_max = val;
-            else if (val < m_min) m_min = val;
+        // soma das amplitudes das oitavas de fbm
+        static double GetFbmWeight(unsigned int octaves, double persistance)
+        {
+            double amplitude = 1.0;
+            double weight = 0.0;
+            for (unsigned int i = 0; i < octaves; i++)
+            {
+                weight += amplitude;
+                amplitude *= persistance;
+            }
+            return weight;
+        }
 
-            if (m_chunk->GetHeight(x, z) < m_threshold)
-                return;
+        // a camada pronta para a linha z: as que têm BindRow preparam a
+        // linha inteira de uma vez, as demais são avaliadas ponto a ponto
+        template <typename Layer>
+        static auto BindRow(const Layer& layer, int z, unsigned int size, int) -> decltype(layer.BindRow(z, size))
+        {
+            return layer.BindRow(z, size);
+        }
+
+        template <typename Layer>
+        static const Layer& BindRow(const Layer& layer, int, unsigned int, long)
+        {
+            return layer;
+        }
+
+        template <typename... Layers>
+        static void ApplyRow(double* row, int z, unsigned int size, double threshold, double& lo, double& hi,
+            const Layers&... layers)
+        {
+            for (unsigned int x = 0; x < size; x++)
+            {
+                double c = row[x];
+                ((c = ApplyStep(layers, c, static_cast<int>(x), z, threshold, lo, hi)), ...);
+                row[x] = c;
+            }
+        }
+
+        // gera a grade de diamond_square::Generate que cobre o heightmap e a
+        // aplica como uma camada. Com `corners` os quatro cantos da grade são
+        // lidos dos cantos desse chunk em vez de sorteados
+        void ApplyGrid(const diamond_square::Parameters& parameters, const Chunk* corners = nullptr)
+        {
+            const unsigned int size = std::min(m_terrain_size, m_chunk->GetSize());
+            const unsigned int grid = diamond_square::GetGridSize(size);
+            std::vector<double> heights(static_cast<std::size_t>(grid) * grid, 0.0);
+
+            if (corners != nullptr)
+            {
+                // a grade pode passar do chunk (512 pontos -> grade de 513):
+                // os índices são limitados ao último ponto do heightmap, então
+                // os cantos de fora repetem os cantos reais do chunk
+                const unsigned int last = grid - 1;
+                const unsigned int edge = std::min(size, corners->GetSize()) - 1;
+                for (unsigned int z : { 0u, last })
+                    for (unsigned int x : { 0u, last })
+                        heights[static_cast<std::size_t>(z) * grid + x] =
+                            corners->GetHeight(std::min(x, edge), std::min(z, edge));
+            }
 
-            m_chunk->SetHeight(x, z, val);
+            diamond_square::Generate(heights.data(), grid, parameters);
+            ApplyLayers([&](double, int x, int z) { return heights[static_cast<std::size_t>(z) * grid + x]; });
         }
 
     public:
+        // camadas de ApplyLayers: cada uma devolve a nova altura do ponto
+        // (x, z) do chunk a partir da altura atual `c`. Não têm estado
+        // mutável, então podem ser avaliadas por várias threads
+
+        // fbm da Perlin somado à altura (`additive`) ou no lugar dela
+        struct PerlinLayer
+        {
+            const HeightGenerator* generator;
+            unsigned int octaves;
+            double persistance, scale;
+            int x_offset, z_offset;
+            bool additive;
+
+            double operator()(double c, int x, int z) const
+            {
+                double t = generator->fbm(x + x_offset, z + z_offset, octaves, persistance) * AMPLITUDE * scale;
+                return additive ? c + t : t;
+            }
+
+            // a linha z com o fbm calculado de uma vez (HeightGenerator::fbmRow)
+            struct Row
+            {
+                bool additive;
+                std::vector<double> t;
+
+                double operator()(double c, int x, int) const
+                {
+                    return additive ? c + t[x] : t[x];
+                }
+            };
+
+            Row BindRow(int z, unsigned int size) const
+            {
+                Row row{additive, std::vector<double>(size)};
+                generator->fbmRow(x_offset, z + z_offset, size, octaves, persistance, row.t.data());
+                for (double& t : row.t)
+                    t = t * AMPLITUDE * scale;
+                return row;
+            }
+        };
+
+        // altura aleatória em [0, AMPLITUDE]
+        struct RandomLayer
+        {
+            int seed;
+            unsigned int layer;
+            int world_x, world_z;
+
+            double operator()(double, int x, int z) const
+            {
+                return HashRand(seed, layer, 0, static_cast<int>(AMPLITUDE), world_x + x, world_z + z, 0);
+            }
+        };
+
+        // picos em cone; cada pico levanta a altura até a sua encosta, na
+        // ordem em que foram sorteados.
+        //
+        // A encosta h(d) = height - d * falloff - d^dropoff só levanta pontos
+        // onde é positiva, então cada pico tem um raio de influência. Os
+        // picos são distribuídos numa grade de baldes de BUCKET_SIZE x
+        // BUCKET_SIZE pontos pelos baldes que o raio alcança, e cada ponto só
+        // visita os picos do seu balde; o resultado é o mesmo de visitar
+        // todos, já que fora do raio max(c, h) não muda uma altura em
+        // [0, AMPLITUDE] e a ordem dos picos é mantida
+        class VoronoiLayer
+        {
+        public:
+            struct Peak
+            {
+                int x, z;
+                double height;
+                // quadrado do raio de influência (infinito se a encosta não
+                // desce)
+                double radius_squared;
+            };
+
+            static constexpr int BUCKET_SIZE = 32;
+
+            // `size`: os pontos avaliados ficam em [0, size) nos dois eixos
+            VoronoiLayer(std::vector<Peak> peaks, double dropoff, double falloff, unsigned int size)
+                : m_peaks{std::move(peaks)}, m_dropoff{dropoff}, m_falloff{falloff},
+                  m_columns{static_cast<int>(size) / BUCKET_SIZE + 1}
+            {
+                for (Peak& peak : m_peaks)
+                {
+                    const double radius = GetRadius(peak.height);
+                    peak.radius_squared = radius * radius;
+                }
+
+                // lista dos picos de cada balde, em ordem, guardada em
+                // sequência: os do balde b vão de m_bucket_start[b] a
+                // m_bucket_start[b + 1]
+                const int bucket_count = m_columns * m_columns;
+                std::vector<std::vector<unsigned int>> buckets(bucket_count);
+                for (unsigned int i = 0; i < m_peaks.size(); i++)
+                {
+                    const Peak& peak = m_peaks[i];
+                    const double radius = std::sqrt(peak.radius_squared);
+                    const auto first = [&](int p) { return static_cast<int>(std::max(0.0, std::floor((p - radius) / BUCKET_SIZE))); };
+                    const auto last = [&](int p)
+                    {
+                        return static_cast<int>(std::min(m_columns - 1.0, std::floor((p + radius) / BUCKET_SIZE)));
+                    };
+                    for (int bz = first(peak.z); bz <= last(peak.z); bz++)
+                        for (int bx = first(peak.x); bx <= last(peak.x); bx++)
+                            buckets[bz * m_columns + bx].push_back(i);
+                }
+
+                m_bucket_start.reserve(bucket_count + 1);
+                m_bucket_start.push_back(0);
+                for (const auto& bucket : buckets)
+                {
+                    m_bucket_peaks.insert(m_bucket_peaks.end(), bucket.begin(), bucket.end());
+                    m_bucket_start.push_back(static_cast<unsigned int>(m_bucket_peaks.size()));
+                }
+            }
+
+            double operator()(double c, int x, int z) const
+            {
+                const int bx = x / BUCKET_SIZE, bz = z / BUCKET_SIZE;
+                if (x < 0 || z < 0 || bx >= m_columns || bz >= m_columns)
+                {
+                    for (const Peak& peak : m_peaks)
+                        c = Raise(peak, c, x, z);
+                    return c;
+                }
+
+                const int b = bz * m_columns + bx;
+                for (unsigned int i = m_bucket_start[b]; i < m_bucket_start[b + 1]; i++)
+                    c = Raise(m_peaks[m_bucket_peaks[i]], c, x, z);
+                return c;
+            }
+
+        private:
+            std::vector<Peak> m_peaks;
+            double m_dropoff, m_falloff;
+            int m_columns;
+            std::vector<unsigned int> m_bucket_start, m_bucket_peaks;
+
+            double GetSlope(double height, double distance) const
+            {
+                return height - distance * m_falloff - std::pow(distance, m_dropoff);
+            }
+
+            // distância a partir da qual a encosta fica em zero ou abaixo,
+            // por bisseção (a encosta é decrescente com falloff >= 0 e
+            // dropoff > 0), com uma amostra de folga
+            double GetRadius(double height) const
+            {
+                if (!(m_falloff >= 0.0 && m_dropoff > 0.0))
+                    return std::numeric_limits<double>::infinity();
+
+                double lower = 0.0, upper = 1.0;
+                while (GetSlope(height, upper) > 0.0)
+                {
+                    lower = upper;
+                    upper *= 2.0;
+                    if (upper > 1.0e9)
+                        return std::numeric_limits<double>::infinity();
+                }
+                for (int i = 0; i < 64 && upper - lower > 1.0e-6; i++)
+                {
+                    const double middle = 0.5 * (lower + upper);
+                    (GetSlope(height, middle) > 0.0 ? lower : upper) = middle;
+                }
+                return upper + 1.0;
+            }
+
+            double Raise(const Peak& peak, double c, int x, int z) const
+            {
+                if (x == peak.x && z == peak.z)
+                    c = peak.height;
+                else
+                {
+                    // h <= height - d * falloff, então std::pow só é
+                    // calculado quando o pico pode levantar a altura
+                    const double dx = x - peak.x, dz = z - peak.z;
+                    const double distance_squared = dx * dx + dz * dz;
+                    if (distance_squared <= peak.radius_squared && c < peak.height)
+                    {
+                        const double distance = std::sqrt(distance_squared);
+                        if (c < peak.height - distance * m_falloff)
+                        {
+                            const double h = GetSlope(peak.height, distance);
+                            c = c < h ? h : c;
+                        }
+                    }
+                }
+                return c < 0.0 ? 0.0 : (c > AMPLITUDE ? AMPLITUDE : c);
+            }
+        };
+
         HeightGenerator(Chunk* chunk, unsigned int terrain_size)
             : m_chunk{chunk}, m_terrain_size{terrain_size}
         {
-            std::random_device rd;
-            m_generator = std::mt19937{rd()};
-
             std::srand(std::time(nullptr));
             m_seed = std::rand();
             m_perlin_noise = new siv::PerlinNoise{static_cast<uint32_t>(m_seed)};
@@ -89,6 +359,17 @@ namespace wega
             delete m_perlin_noise;
         }
 
+        // fixa a semente dos valores aleatórios e da Perlin, para repetir o
+        // terreno entre execuções; a contagem de camadas recomeça
+        void SetSeed(int seed)
+        {
+            m_seed = seed;
+            m_layer = 0;
+            m_perlin_noise->reseed(static_cast<uint32_t>(seed));
+        }
+
+        int GetSeed(void) const { return m_seed; }
+
         void SetThreshold(double val) { m_threshold = val; }
         void DisableThreshold(void) { m_threshold = -1.0; }
         double GetMinHeight(void) const { return m_min; }
@@ -107,88 +388,114 @@ namespace wega
             return GetNoise(x, z) * AMPLITUDE;
         }
 
-        void AddVoronoiLayer(unsigned int peak_count, double dropoff, double falloff)
+        PerlinLayer MakePerlinLayer(unsigned int octaves, double persistance, double scale = 1.0) const
+        {
+            return PerlinLayer{this, octaves, persistance, scale, 0, 0, true};
+        }
+
+        PerlinLayer MakePerlinLayer(unsigned int octaves, double persistance, int x_offset, int z_offset,
+            bool additive = true) const
+        {
+            return PerlinLayer{this, octaves, persistance, 1.0, x_offset, z_offset, additive};
+        }
+
+        RandomLayer MakeRandomLayer(void)
+        {
+            m_layer++;
+            return RandomLayer{m_seed, m_layer, m_chunk->GetWorldX(), m_chunk->GetWorldZ()};
+        }
+
+        // os picos são sorteados pela posição do chunk
+        VoronoiLayer MakeVoronoiLayer(unsigned int peak_count, double dropoff, double falloff)
         {
             static double s_voronoi_max_height = AMPLITUDE;
             static double s_voronoi_min_height = AMPLITUDE / 2.0;
-            /* static double s_voronoi_dropoff = 0.1f; */
-            /* static double s_voronoi_falloff = 5.0f; */
-            static glm::vec2 s_zero = glm::vec2{0.0f};
 
+            m_layer++;
+            const int world_x = m_chunk->GetWorldX(), world_z = m_chunk->GetWorldZ();
+            std::vector<VoronoiLayer::Peak> peaks;
             for (unsigned int i = 0; i < peak_count; i++)
             {
-                int rx = Rand(0, m_terrain_size);
-                int ry = Rand(0, m_terrain_size);
-                double peak_height = Rand(s_voronoi_min_height, s_voronoi_max_height);
-                double max_distance = glm::distance(s_zero, glm::vec2{m_terrain_size, m_terrain_size});
-                glm::vec2 peak_location = glm::vec2{rx, ry};
+                int rx = Rand(0, m_terrain_size, world_x, world_z, 3 * i);
+                int ry = Rand(0, m_terrain_size, world_x, world_z, 3 * i + 1);
+                double peak_height = Rand(s_voronoi_min_height, s_voronoi_max_height, world_x, world_z, 3 * i + 2);
+                peaks.push_back({rx, ry, peak_height, 0.0});
+            }
+            return VoronoiLayer{std::move(peaks), dropoff, falloff, std::min(m_terrain_size, m_chunk->GetSize())};
+        }
 
-                std::function<double (int, int, int)> f = [&](int c, int x, int z)
-                {
-                    if (x == rx && z == ry)
-                        return peak_height;
+        // aplica as camadas na ordem dos argumentos, como se cada uma fosse
+        // uma passada própria, mas em uma única passada pelo heightmap: cada
+        // altura é lida e gravada uma vez e as camadas são combinadas em
+        // tempo de compilação. As linhas são divididas entre todos os
+        // núcleos (Chunk::UpdateHeights)
+        template <typename... Layers>
+        void ApplyLayers(const Layers&... layers)
+        {
+            const unsigned int size = std::min(m_terrain_size, m_chunk->GetSize());
+            const double threshold = m_threshold;
+            // intervalo de alturas de cada linha, juntado em m_min/m_max no fim
+            std::vector<double> row_min(size, m_min), row_max(size, m_max);
+
+            m_chunk->UpdateHeights([&](unsigned int z, double* row)
+            {
+                if (z >= size)
+                    return;
 
-                    double distance_to_peak = glm::distance(peak_location, glm::vec2{x, z})/* / max_distance*/;
-                    double h = peak_height - distance_to_peak * falloff - std::pow(distance_to_peak, dropoff);
-                    
-                    return c < h ? h : c;
-                };
+                double lo = row_min[z], hi = row_max[z];
+                ApplyRow(row, static_cast<int>(z), size, threshold, lo, hi, BindRow(layers, static_cast<int>(z), size, 0)...);
+                row_min[z] = lo;
+                row_max[z] = hi;
+            });
 
-                ApplyLayer(f);
+            for (unsigned int z = 0; z < size; z++)
+            {
+                m_min = std::min(m_min, row_min[z]);
+                m_max = std::max(m_max, row_max[z]);
             }
         }
 
-    	void SetRandomValues()
+        void AddVoronoiLayer(unsigned int peak_count, double dropoff, double falloff)
         {
-			std::function<double(int, int, int)> f = [&](int c, int x, int z)
-			{
-				return Rand((int)0, (int)AMPLITUDE);
-			};
+            ApplyLayers(MakeVoronoiLayer(peak_count, dropoff, falloff));
+        }
 
-			ApplyLayer(f);
+    	void SetRandomValues()
+        {
+			ApplyLayers(MakeRandomLayer());
         }
 
         void AddPerlinNoiseLayer(unsigned int octaves, double persistance, double scale = 1.0f)
         {
-            std::function<double (int, int, int)> f = [&](int c, int x, int z)
-            {
-                return c + fbm(x, z, octaves, persistance) * AMPLITUDE * scale;
-            };
-
-            ApplyLayer(f);
+            ApplyLayers(MakePerlinLayer(octaves, persistance, scale));
         }
 
         void AddPerlinNoiseLayer(unsigned int octaves, double persistance, int x_offset, int z_offset, bool additive = true)
         {
-            std::function<double (int, int, int)> f = [&](int c, int x, int z)
-            {
-                double t = fbm(x + x_offset, z + z_offset, octaves, persistance) * AMPLITUDE;
-                if (additive)
-                    return c + t;
-                return t;
-            };
-
-            ApplyLayer(f);
+            ApplyLayers(MakePerlinLayer(octaves, persistance, x_offset, z_offset, additive));
         }
 
-    	void DiamondSquare()
+        // diamond-square completo (diamond_square::Generate) com os cantos
+        // sorteados em [0, AMPLITUDE]. O deslocamento começa em
+        // [-AMPLITUDE / 2, AMPLITUDE / 2] e é multiplicado por 2^-roughness a
+        // cada nível. Tamanhos fora de 2^n + 1 são gerados na grade maior
+        // seguinte e recortados
+    	void DiamondSquare(double roughness = 1.0)
         {
-			const auto size = m_chunk->GetSize();
-
-        	// initialization
-			SetHeight(0, 0, Rand(0, AMPLITUDE));
-			SetHeight(size - 1, 0, Rand(0, AMPLITUDE));
-			SetHeight(0, size - 1, Rand(0, AMPLITUDE));
-			SetHeight(size - 1, size - 1, Rand(0, AMPLITUDE));
-
-        	// square step
-			SetHeight(
-				static_cast<int>((size - 1) / 2.0),
-				static_cast<int>((size - 1) / 2.0),
-				(m_chunk->GetHeight(0, 0) +
-					m_chunk->GetHeight(size - 1, 0) +
-					m_chunk->GetHeight(0, size - 1) +
-					m_chunk->GetHeight(size - 1, size - 1)) / 4.0 + Rand(0, AMPLITUDE));
+            m_layer++;
+            diamond_square::Parameters parameters;
+            parameters.key = HashLayer(m_seed, m_layer);
+            // posição no mundo: chunks vizinhos de tamanho 2^n + 1 tiram a
+            // mesma borda
+            parameters.world_x = m_chunk->GetWorldX();
+            parameters.world_z = m_chunk->GetWorldZ();
+            parameters.corner_min = 0.0;
+            parameters.corner_max = AMPLITUDE;
+            parameters.offset_min = -AMPLITUDE / 2.0;
+            parameters.offset_max = AMPLITUDE / 2.0;
+            parameters.offset_scale = std::pow(2.0, -roughness);
+
+            ApplyGrid(parameters);
         }
     	
     	void ApplyHeightMap(utils::NoiseMap& hm)
@@ -213,111 +520,89 @@ namespace wega
         	}
         }
 
-        void AddMidPointDisplacement(Chunk* chunk, double roughness, double dampener)
+        // `lower_x`/`lower_z` são as coordenadas de ruído da amostra de mundo
+        // (0, 0) e `sample_delta` a distância entre duas amostras, as mesmas
+        // usadas no Build() completo (sem EnableSeamless, que depende da
+        // janela inteira)
+        void SetScrollSource(const module::Module& source, double lower_x, double lower_z, double sample_delta)
         {
-            unsigned int width = chunk->GetSize() - 1;
-            // quão grande é o quadrado atual
-            unsigned int square_size = width;
-            /* double height = AMPLITUDE; */
-            double height_dampener = std::pow(dampener, -1 * roughness);
-
-            double max_height = AMPLITUDE;
-            double min_height = 0;
+            m_scroll_source = &source;
+            m_scroll_lower_x = lower_x;
+            m_scroll_lower_z = lower_z;
+            m_scroll_delta = sample_delta;
+            m_strip_builder.SetSourceModule(source);
+            m_strip_builder.SetDestNoiseMap(m_strip_map);
+        }
 
-            unsigned int corner_x, corner_y, mid_x, mid_y, pmid_xl, pmid_xr,
-                         pmid_yu, pmid_yd;
+        // desloca o terreno em amostras inteiras; o custo é proporcional ao
+        // tamanho da faixa exposta e não ao do mapa inteiro
+        void Scroll(int dx, int dz)
+        {
+            if (m_scroll_source == nullptr)
+                return;
 
-            while (square_size > 0)
+            m_chunk->Scroll(dx, dz, [&](const ChunkRegion& r)
             {
-                // diamond step
-                for (unsigned int y = 0; y < width; y += square_size)
-                    for (unsigned int x = 0; x < width; x += square_size)
-                {
-                    corner_x = x + square_size;
-                    corner_y = y + square_size;
-                    mid_x = static_cast<unsigned int>(x + square_size / 2.0);
-                    mid_y = static_cast<unsigned int>(y + square_size / 2.0);
-
-                    // tamanho setado pela média dos cantos
-                    SetHeight(mid_x, mid_y, (
-                                chunk->GetHeight(x, y) + 
-                                chunk->GetHeight(corner_x, y) + 
-                                chunk->GetHeight(x, corner_y) + 
-                                chunk->GetHeight(corner_x, corner_y)) / 4.0 +
-                                Rand(min_height, max_height));
-                }
-            	
-                // square step
-                for (unsigned int y = 0; y < width; y += square_size)
-                    for (unsigned int x = 0; x < width; x += square_size)
-                {
-                    corner_x = x + square_size;
-                    corner_y = y + square_size;
-                    mid_x = static_cast<unsigned int>(x + square_size / 2.0);
-                    mid_y = static_cast<unsigned int>(y + square_size / 2.0);
-                    
-                    pmid_xr = static_cast<unsigned int>(mid_x + square_size);
-                    pmid_yu = static_cast<unsigned int>(mid_y + square_size);
-                    pmid_xl = static_cast<unsigned int>(mid_x - square_size);
-                    pmid_yd = static_cast<unsigned int>(mid_y - square_size);
-
-                    /*if (pmid_xl <= 0 || pmid_yd <= 0 || pmid_xr >= width - 1 || pmid_yu >= width - 1)
-                        continue;*/
-
-                    SetHeight(mid_x, y, 
-                            (chunk->GetHeight(mid_x, mid_y) +
-                             chunk->GetHeight(x, y) +
-                             chunk->GetHeight(mid_x, pmid_yd) +
-                             chunk->GetHeight(corner_x, y)) / 4.0 +
-                            Rand(min_height, max_height));
-
-                    SetHeight(mid_x, corner_y,
-                            (chunk->GetHeight(x, corner_y) +
-                             chunk->GetHeight(mid_x, mid_y) +
-                             chunk->GetHeight(corner_x, corner_y) +
-                             chunk->GetHeight(mid_x, pmid_yu)) / 4.0 +
-                            Rand(min_height, max_height));
-
-                    SetHeight(x, mid_y,
-                            (chunk->GetHeight(x, y) +
-                                chunk->GetHeight(pmid_xl, mid_y) +
-                                chunk->GetHeight(x, corner_y) +
-                                chunk->GetHeight(mid_x, mid_y)) / 4.0 +
-                            Rand(min_height, max_height));
-
-                    SetHeight(corner_x, mid_y,
-                            (chunk->GetHeight(mid_x, y) +
-                                chunk->GetHeight(mid_x, mid_y) +
-                                chunk->GetHeight(corner_x, corner_y) +
-                                chunk->GetHeight(pmid_xr, mid_y)) / 4.0 +
-                            Rand(min_height, max_height));
-                }
+                double x0 = m_scroll_lower_x + (m_chunk->GetWorldX() + static_cast<int>(r.x)) * m_scroll_delta;
+                double z0 = m_scroll_lower_z + (m_chunk->GetWorldZ() + static_cast<int>(r.z)) * m_scroll_delta;
+                m_strip_builder.SetBounds(x0, x0 + r.w * m_scroll_delta, z0, z0 + r.h * m_scroll_delta);
+                m_strip_builder.SetDestSize(r.w, r.h);
+                m_strip_builder.Build();
+
+                for (unsigned int z = 0; z < r.h; z++)
+                    for (unsigned int x = 0; x < r.w; x++)
+                        m_chunk->SetHeight(r.x + x, r.z + z, m_strip_map.GetValue(x, z) * AMPLITUDE);
+            });
+        }
 
-                // 1 / 4 dos quadrados cada iteração do loop
-                square_size = static_cast<unsigned int>(square_size / 2.0);
-                max_height *= height_dampener;
-                min_height *= height_dampener;
-            }
+        // diamond-square partindo dos cantos atuais de `chunk`, com
+        // deslocamentos em [0, AMPLITUDE] multiplicados por
+        // dampener^-roughness a cada nível
+        void AddMidPointDisplacement(Chunk* chunk, double roughness, double dampener)
+        {
+            m_layer++;
+            diamond_square::Parameters parameters;
+            parameters.key = HashLayer(m_seed, m_layer);
+            parameters.world_x = chunk->GetWorldX();
+            parameters.world_z = chunk->GetWorldZ();
+            parameters.seed_corners = false;
+            parameters.offset_min = 0.0;
+            parameters.offset_max = AMPLITUDE;
+            parameters.offset_scale = std::pow(dampener, -roughness);
+
+            ApplyGrid(parameters, chunk);
         }
 
-        // fractal brownian motion
+        // fractal brownian motion: média de noise0_1 nas oitavas, com a
+        // escala dividida por 2 e a amplitude multiplicada por `persistance`
+        // a cada oitava. noise0_1 = noise * 0.5 + 0.5, então a média sai da
+        // soma ponderada de noise, que fbmRow calcula para a linha inteira
 		[[nodiscard]] double fbm(const int x, const int z, const unsigned int octaves, const double persistance) const
         {
             double total = 0.0f;
             double frequency = 1.0f;
             double amplitude = 1.0f;
-            double max_value = 0.0f;
 
             for (unsigned int i = 0; i < octaves; i++)
             {
-                total += m_perlin_noise->noise0_1(x / frequency, z / frequency) * amplitude;
-                max_value += amplitude;
+                total += m_perlin_noise->noise(x / frequency, z / frequency) * amplitude;
 
                 amplitude *= persistance;
                 frequency *= 2;
             }
 
-            return total / max_value;
+            return 0.5 * total / GetFbmWeight(octaves, persistance) + 0.5;
+        }
+
+        // fbm de (x + i, z) para i em [0, count), em out; os valores são os
+        // mesmos de fbm
+        void fbmRow(const int x, const int z, const unsigned int count, const unsigned int octaves,
+            const double persistance, double* out) const
+        {
+            m_perlin_noise->octaveNoiseRow(x, 1.0, z, count, static_cast<std::int32_t>(octaves), out, 0.5, persistance);
+            const double weight = GetFbmWeight(octaves, persistance);
+            for (unsigned int i = 0; i < count; i++)
+                out[i] = 0.5 * out[i] / weight + 0.5;
         }
     };
 }
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "chunk.h"
+#include "shader.h"
+
+namespace wega
+{
+    // heightmap de um Chunk em uma textura R32F com o mesmo layout físico do
+    // ring buffer: o texel (x, z) guarda a altura da amostra física (x, z).
+    // X/Z dos vértices saem de gl_VertexID e as normais são calculadas em
+    // height_texture.vert, então uma reconstrução envia 4 bytes por amostra
+    // em vez dos 48 de vértice + normal em GLdouble
+    class HeightTexture
+    {
+        GLuint m_texture_id;
+        unsigned int m_sz;
+        std::vector<GLfloat> m_staging;
+        size_t m_uploaded_bytes = 0;
+
+        // envia o retângulo lógico (x, z, w, h), que não pode cruzar a emenda
+        // do toro
+        void UploadRect(const Chunk& chunk, unsigned int x, unsigned int z, unsigned int w, unsigned int h)
+        {
+            m_staging.resize(static_cast<size_t>(w) * h);
+            for (unsigned int j = 0; j < h; j++)
+                for (unsigned int i = 0; i < w; i++)
+                    m_staging[j * w + i] = static_cast<GLfloat>(chunk.GetHeight(x + i, z + j));
+
+            const unsigned int px = (x + chunk.GetOriginX()) % m_sz;
+            const unsigned int pz = (z + chunk.GetOriginZ()) % m_sz;
+            glTexSubImage2D(GL_TEXTURE_2D, 0, px, pz, w, h, GL_RED, GL_FLOAT, m_staging.data());
+            m_uploaded_bytes += m_staging.size() * sizeof(GLfloat);
+        }
+    public:
+        explicit HeightTexture(unsigned int sz)
+            : m_sz(sz)
+        {
+            glGenTextures(1, &m_texture_id);
+            glBindTexture(GL_TEXTURE_2D, m_texture_id);
+            // lida só com texelFetch, sem filtragem
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_R32F, sz, sz, 0, GL_RED, GL_FLOAT, nullptr);
+            glBindTexture(GL_TEXTURE_2D, 0);
+        }
+
+        ~HeightTexture()
+        {
+            glDeleteTextures(1, &m_texture_id);
+        }
+
+        HeightTexture(const HeightTexture&) = delete;
+        HeightTexture& operator=(const HeightTexture&) = delete;
+
+        // envia o heightmap inteiro
+        void Upload(const Chunk& chunk)
+        {
+            Upload(chunk, ChunkRegion{0, 0, m_sz, m_sz});
+        }
+
+        // envia apenas a região lógica, dividida nos até quatro retângulos
+        // físicos em que a emenda do toro a separa
+        void Upload(const Chunk& chunk, const ChunkRegion& region)
+        {
+            glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+            glBindTexture(GL_TEXTURE_2D, m_texture_id);
+
+            const unsigned int split_x = m_sz - chunk.GetOriginX();
+            const unsigned int split_z = m_sz - chunk.GetOriginZ();
+            const unsigned int xs[3] = {region.x, std::max(region.x, std::min(split_x, region.x + region.w)), region.x + region.w};
+            const unsigned int zs[3] = {region.z, std::max(region.z, std::min(split_z, region.z + region.h)), region.z + region.h};
+
+            for (int j = 0; j < 2; j++)
+                for (int i = 0; i < 2; i++)
+                    if (xs[i + 1] > xs[i] && zs[j + 1] > zs[j])
+                        UploadRect(chunk, xs[i], zs[j], xs[i + 1] - xs[i], zs[j + 1] - zs[j]);
+
+            glBindTexture(GL_TEXTURE_2D, 0);
+        }
+
+        // liga a textura na unidade `unit` e envia a posição do chunk para
+        // height_texture.vert
+        void Bind(const Shader& shader, const Chunk& chunk, int unit = 0) const
+        {
+            glActiveTexture(GL_TEXTURE0 + unit);
+            glBindTexture(GL_TEXTURE_2D, m_texture_id);
+            shader.SetInt("height_map", unit);
+            shader.SetInt("origin_x", static_cast<int>(chunk.GetOriginX()));
+            shader.SetInt("origin_z", static_cast<int>(chunk.GetOriginZ()));
+            shader.SetInt("world_x", chunk.GetWorldX());
+            shader.SetInt("world_z", chunk.GetWorldZ());
+            shader.SetFloat("spacing", static_cast<float>(chunk.GetSpacing()));
+        }
+
+        GLuint GetTextureID(void) const { return m_texture_id; }
+        // bytes enviados desde a última chamada de ResetUploadedBytes
+        size_t GetUploadedBytes(void) const { return m_uploaded_bytes; }
+        void ResetUploadedBytes(void) { m_uploaded_bytes = 0; }
+    };
+}
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace wega
+{
+    // fila limitada sem locks com múltiplos produtores e consumidores
+    // (algoritmo de D. Vyukov): cada posição do buffer tem um número de
+    // sequência que diz se ela está livre para escrita ou pronta para leitura.
+    // A capacidade é arredondada para uma potência de 2
+    template <typename T>
+    class LockFreeQueue
+    {
+        struct Cell
+        {
+            std::atomic<size_t> sequence;
+            T data;
+        };
+
+        std::unique_ptr<Cell[]> m_buffer;
+        size_t m_mask;
+        alignas(64) std::atomic<size_t> m_enqueue_pos;
+        alignas(64) std::atomic<size_t> m_dequeue_pos;
+    public:
+        explicit LockFreeQueue(size_t capacity)
+        {
+            size_t sz = 2;
+            while (sz < capacity)
+                sz <<= 1;
+
+            m_buffer = std::make_unique<Cell[]>(sz);
+            m_mask = sz - 1;
+            for (size_t i = 0; i < sz; i++)
+                m_buffer[i].sequence.store(i, std::memory_order_relaxed);
+            m_enqueue_pos.store(0, std::memory_order_relaxed);
+            m_dequeue_pos.store(0, std::memory_order_relaxed);
+        }
+
+        LockFreeQueue(const LockFreeQueue&) = delete;
+        LockFreeQueue& operator=(const LockFreeQueue&) = delete;
+
+        // retorna false se a fila estiver cheia
+        bool Push(const T& value)
+        {
+            size_t pos = m_enqueue_pos.load(std::memory_order_relaxed);
+            Cell* cell;
+
+            for (;;)
+            {
+                cell = &m_buffer[pos & m_mask];
+                size_t seq = cell->sequence.load(std::memory_order_acquire);
+                intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+
+                if (diff == 0)
+                {
+                    if (m_enqueue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                        break;
+                }
+                else if (diff < 0)
+                    return false;
+                else
+                    pos = m_enqueue_pos.load(std::memory_order_relaxed);
+            }
+
+            cell->data = value;
+            cell->sequence.store(pos + 1, std::memory_order_release);
+            return true;
+        }
+
+        // retorna false se a fila estiver vazia
+        bool Pop(T& value)
+        {
+            size_t pos = m_dequeue_pos.load(std::memory_order_relaxed);
+            Cell* cell;
+
+            for (;;)
+            {
+                cell = &m_buffer[pos & m_mask];
+                size_t seq = cell->sequence.load(std::memory_order_acquire);
+                intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos + 1);
+
+                if (diff == 0)
+                {
+                    if (m_dequeue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                        break;
+                }
+                else if (diff < 0)
+                    return false;
+                else
+                    pos = m_dequeue_pos.load(std::memory_order_relaxed);
+            }
+
+            value = cell->data;
+            cell->sequence.store(pos + m_mask + 1, std::memory_order_release);
+            return true;
+        }
+    };
+}
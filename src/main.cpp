@@ -4,16 +4,29 @@
 #include <GLFW/glfw3.h>
 #include <glm/glm.hpp>
 
+#include <algorithm>
 #include <iostream>
+#include <cmath>
 #include <cstdlib>
 #include <string>
+#include <vector>
 
+#include "benchmark.h"
 #include "camera.h"
 #include "my_math.h"
+#include "precision_check.h"
 #include "shader.h"
 #include "chunk.h"
+#include "chunk_manager.h"
+#include "chunk_uploader.h"
+#include "cdlod.h"
+#include "clipmap.h"
 #include "height_generator.h"
+#include "height_texture.h"
+#include "rtin.h"
 #include "screen.h"
+#include "stream_buffer.h"
+#include "terrain_noise.h"
 
 #define HEIGHT 1050
 #define WIDTH  1920
@@ -38,17 +51,84 @@ void FramebufferSizeCallback(GLFWwindow* w, int width, int height)
 static const int TERRAIN_VERTEX_COUNT = 512;
 static const double TERRAIN_MOVEMENT_STEP = 0.1;
 
+// FULL_REBUILD: reconstrói o chunk inteiro a cada passo das setas
+// SCROLLING: rola o heightmap como um ring buffer; o passo é arredondado para
+// um número inteiro de amostras
+// STREAMING: mantém os chunks ao redor da câmera, gerados em background
+// CLIPMAP: anéis de resolução decrescente centrados na câmera
+// CDLOD: quadtree com LOD contínuo por distância e frustum culling por nó
+enum class TerrainMode { FULL_REBUILD, SCROLLING, STREAMING, CLIPMAP, CDLOD };
+static const TerrainMode TERRAIN_MODE = TerrainMode::FULL_REBUILD;
+static const bool TERRAIN_SCROLLING = TERRAIN_MODE == TerrainMode::SCROLLING;
+// tamanho dos chunks do modo STREAMING e quantos chunks em cada direção ao
+// redor da câmera são mantidos
+static const int STREAMING_CHUNK_VERTEX_COUNT = 129;
+static const int STREAMING_RADIUS = 2;
+// amostras por lado de cada nível do clipmap (2^k + 1) e número de níveis; a
+// extensão dobra a cada nível, então o FAR_PLANE pode crescer junto
+static const int CLIPMAP_VERTEX_COUNT = 129;
+static const int CLIPMAP_LEVELS = 6;
+static const float CLIPMAP_FAR_PLANE = 20000.0f;
+// a quadtree do CDLOD precisa de 2^k + 1 amostras por lado
+static const int CDLOD_VERTEX_COUNT = 513;
+// no modo FULL_REBUILD, desenha uma malha adaptativa (rtin.h) que só refina
+// onde o erro de altura projetado na tela passa de ADAPTIVE_PIXEL_ERROR
+// pixels; também precisa de 2^k + 1 amostras por lado. Os índices são
+// escolhidos de novo quando o limite muda mais que ADAPTIVE_ERROR_STEP vezes
+static const bool TERRAIN_ADAPTIVE_MESH = false;
+static const double ADAPTIVE_PIXEL_ERROR = 1.0;
+static const double ADAPTIVE_ERROR_STEP = 1.25;
+static const int ADAPTIVE_VERTEX_COUNT = 513;
+static const bool USE_ADAPTIVE_MESH = TERRAIN_ADAPTIVE_MESH && TERRAIN_MODE == TerrainMode::FULL_REBUILD;
+static const int CHUNK_VERTEX_COUNT = TERRAIN_MODE == TerrainMode::CDLOD ? CDLOD_VERTEX_COUNT
+	: USE_ADAPTIVE_MESH ? ADAPTIVE_VERTEX_COUNT : TERRAIN_VERTEX_COUNT;
+// nos modos FULL_REBUILD e SCROLLING, envia só o heightmap (textura R32F) e
+// desloca uma grade implícita no vertex shader em vez de enviar vértices e
+// normais
+static const bool TERRAIN_HEIGHT_TEXTURE = false;
+static const bool USE_HEIGHT_TEXTURE = TERRAIN_HEIGHT_TEXTURE &&
+	(TERRAIN_MODE == TerrainMode::FULL_REBUILD || TERRAIN_MODE == TerrainMode::SCROLLING);
+// no modo FULL_REBUILD, gera a malha direto em um buffer persistentemente
+// mapeado com três slots (stream_buffer.h) em vez de copiar com glBufferData
+static const bool TERRAIN_PERSISTENT_UPLOAD = false;
+static const bool USE_PERSISTENT_UPLOAD = TERRAIN_PERSISTENT_UPLOAD && !USE_HEIGHT_TEXTURE &&
+	TERRAIN_MODE == TerrainMode::FULL_REBUILD;
+// nos modos FULL_REBUILD e SCROLLING, envia vértices compactos (4 bytes:
+// altura de 16 bits e normal octaédrica) em vez de posição e normal em double
+// (48 bytes); X/Z são reconstruídos no ambient.vert
+static const bool TERRAIN_PACKED_VERTICES = false;
+static const bool USE_PACKED_VERTICES = TERRAIN_PACKED_VERTICES && !USE_HEIGHT_TEXTURE && !USE_PERSISTENT_UPLOAD &&
+	(TERRAIN_MODE == TerrainMode::FULL_REBUILD || TERRAIN_MODE == TerrainMode::SCROLLING);
+
 static const float FOV = 70.f;
 static const float NEAR_PLANE = 0.1f;
 static const float FAR_PLANE = 2000.0f;
 
+// mede as rotinas de geração (benchmark.h) antes de abrir a janela
+static const bool RUN_BENCHMARKS = false;
+// compara os mapas em precisão simples e dupla (precision_check.h) antes de
+// abrir a janela
+static const bool RUN_PRECISION_CHECK = false;
+// imprime quantos bytes foram enviados para a GPU nos quadros com upload
+static const bool LOG_UPLOADED_BYTES = false;
+// imprime o tempo médio de quadro a cada FRAME_TIME_SAMPLES quadros, para
+// comparar os formatos de vértice
+static const bool LOG_FRAME_TIME = false;
+static const int FRAME_TIME_SAMPLES = 100;
+
 static bool s_wireframe_mode = false;
 
 static GLuint s_vao;
-static GLuint s_vbo;
-static GLuint s_n_vbo;
-static GLuint s_ibo;
+static wega::ChunkUploader* s_uploader = nullptr;
 static wega::Chunk* s_chunk;
+static wega::HeightTexture* s_height_texture = nullptr;
+static wega::StreamBuffer* s_stream_buffer = nullptr;
+static wega::Rtin* s_rtin = nullptr;
+static std::vector<GLuint> s_adaptive_indices;
+// erro máximo (em unidades do heightmap) dos s_adaptive_indices atuais
+static double s_adaptive_max_error = 0.0;
+// bytes escritos nos slots do s_stream_buffer no quadro atual
+static size_t s_stream_uploaded_bytes = 0;
 
 static glm::vec3 s_position;
 static float s_rx, s_ry, s_rz;
@@ -127,36 +207,94 @@ void ProcessMouseInput(GLFWwindow* w, int button, int action, int mods)
 	}
 }
 
-void SendChunkDataToGPU()
+// erro máximo da malha adaptativa para a câmera em `local_camera` (espaço do
+// terreno): ADAPTIVE_PIXEL_ERROR pixels na distância até o ponto mais
+// próximo do s_chunk. A malha inteira usa um limite só, então vale o do
+// ponto mais próximo. A escala do terreno é uniforme, então a distância e o
+// erro podem ficar os dois no espaço do terreno
+double GetAdaptiveMaxError(const glm::vec3& local_camera)
+{
+	const double spacing = s_chunk->GetSpacing();
+	const double last = static_cast<double>(s_chunk->GetSize() - 1);
+	const auto outside = [](double v, double lower, double upper) { return std::max({ lower - v, 0.0, v - upper }); };
+	const double dx = outside(local_camera.x, s_chunk->GetWorldX() * spacing, (s_chunk->GetWorldX() + last) * spacing);
+	const double dy = outside(local_camera.y, s_chunk->GetMinValue(), s_chunk->GetMaxValue());
+	const double dz = outside(local_camera.z, s_chunk->GetWorldZ() * spacing, (s_chunk->GetWorldZ() + last) * spacing);
+	return wega::Rtin::ScreenSpaceError(ADAPTIVE_PIXEL_ERROR, std::sqrt(dx * dx + dy * dy + dz * dz), FOV, HEIGHT);
+}
+
+// escolhe e envia os índices da malha adaptativa para s_adaptive_max_error
+void SendAdaptiveIndicesToGPU()
+{
+	s_rtin->GetIndices(s_adaptive_max_error, s_adaptive_indices);
+	s_uploader->UploadIndices(s_adaptive_indices.data(), s_adaptive_indices.size());
+}
+
+// envia o index buffer: a grade do chunk só quando o chunk a marca como
+// alterada e a malha adaptativa, recalculada, a cada reconstrução
+void SendIndicesToGPU()
 {
-	static bool s_buffer_initialized = false;
-	GL_CHECK(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, s_ibo));
-	GL_CHECK(glBufferData(GL_ELEMENT_ARRAY_BUFFER, s_chunk->GetIndicesSize() * sizeof(GLuint), s_chunk->GetIndices(), GL_STATIC_DRAW));
-
-	// seleciona o Buffer
-	GL_CHECK(glBindBuffer(GL_ARRAY_BUFFER, s_vbo));
-	// copia os vértices da memória RAM para a memória da GPU
-	if (!s_buffer_initialized)
+	if (s_rtin != nullptr)
 	{
-		GL_CHECK(glBufferData(GL_ARRAY_BUFFER, s_chunk->GetVerticesSize() * sizeof(GLdouble), s_chunk->GetVertices(), GL_STATIC_DRAW));
-		s_buffer_initialized = true;
+		s_rtin->Update();
+		SendAdaptiveIndicesToGPU();
 	}
 	else
-		GL_CHECK(glBufferSubData(GL_ARRAY_BUFFER, 0, s_chunk->GetVerticesSize() * sizeof(GLdouble), s_chunk->GetVertices()));
-	
-	GL_CHECK(glVertexAttribPointer(0, 3, GL_DOUBLE, GL_FALSE, 0, static_cast<void*>(0)));
-	GL_CHECK(glEnableVertexAttribArray(0));
+		s_uploader->UploadIndices(*s_chunk);
+}
+
+// envia para a GPU só o que mudou no s_chunk desde o último envio
+void SendChunkToGPU()
+{
+	SendIndicesToGPU();
+
+	if (s_height_texture != nullptr)
+	{
+		// a grade é implícita: só as alturas das regiões alteradas vão para a
+		// GPU
+		for (const auto& region : s_chunk->GetDirtyRegions())
+			s_height_texture->Upload(*s_chunk, region);
+		s_chunk->ClearDirtyRegions();
+		return;
+	}
+
+	s_uploader->UploadMesh(*s_chunk);
+}
+
+// gera a malha do s_chunk e a envia para a GPU. Com o s_stream_buffer a malha
+// é escrita direto no próximo slot mapeado, sem cópia intermediária
+void RebuildChunkMesh()
+{
+	if (s_stream_buffer == nullptr)
+	{
+		s_chunk->GenerateMesh();
+		SendChunkToGPU();
+		return;
+	}
 
-	GL_CHECK(glBindBuffer(GL_ARRAY_BUFFER, s_n_vbo));
-	GL_CHECK(glBufferData(GL_ARRAY_BUFFER, s_chunk->GetNormalsSize() * sizeof(GLdouble), s_chunk->GetNormals(), GL_STATIC_DRAW));
+	SendIndicesToGPU();
 
-	// normaliza as normais
-	GL_CHECK(glVertexAttribPointer(1, 3, GL_DOUBLE, GL_TRUE, 0, (void*)0));
+	// vértices e, em seguida, normais no mesmo slot
+	auto* vertices = static_cast<GLdouble*>(s_stream_buffer->Acquire());
+	s_chunk->GenerateMesh(vertices, vertices + s_chunk->GetVerticesSize());
+	s_stream_uploaded_bytes += (s_chunk->GetVerticesSize() + s_chunk->GetNormalsSize()) * sizeof(GLdouble);
+
+	const GLintptr offset = s_stream_buffer->GetOffset();
+	GL_CHECK(glBindVertexArray(s_vao));
+	GL_CHECK(glBindBuffer(GL_ARRAY_BUFFER, s_stream_buffer->GetBuffer()));
+	GL_CHECK(glVertexAttribPointer(0, 3, GL_DOUBLE, GL_FALSE, 0, reinterpret_cast<void*>(offset)));
+	GL_CHECK(glEnableVertexAttribArray(0));
+	GL_CHECK(glVertexAttribPointer(1, 3, GL_DOUBLE, GL_TRUE, 0, reinterpret_cast<void*>(offset + s_chunk->GetVerticesSize() * sizeof(GLdouble))));
 	GL_CHECK(glEnableVertexAttribArray(1));
 }
 
 int main(void)
 {
+	if (RUN_BENCHMARKS)
+		wega::benchmark::Run();
+	if (RUN_PRECISION_CHECK)
+		wega::precision_check::Run();
+
 	if (glfwInit() != GL_TRUE)
 	{
 		glfwTerminate();
@@ -203,10 +341,10 @@ int main(void)
 
 	// escopo local para gerenciamento de memória
 	{
-		s_chunk = new wega::Chunk(TERRAIN_VERTEX_COUNT, 0, 0);
+		s_chunk = new wega::Chunk(CHUNK_VERTEX_COUNT, 0, 0);
 
 		// inicializa o vetor de alturas com 0s
-		wega::HeightGenerator height_generator{ s_chunk, TERRAIN_VERTEX_COUNT };
+		wega::HeightGenerator height_generator{ s_chunk, CHUNK_VERTEX_COUNT };
 		 //height_generator.SetRandomValues();
 		
 		//height_generator.AddMidPointDisplacement(s_chunk, 6.0, 1.2);
@@ -230,30 +368,10 @@ int main(void)
 		// seleciona o Vertex Array
 		GL_CHECK(glBindVertexArray(s_vao));
 
-		// gera um Index Buffer Object
-		GL_CHECK(glGenBuffers(1, &s_ibo));
-		//GL_CHECK(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, s_ibo));
-		//GL_CHECK(glBufferData(GL_ELEMENT_ARRAY_BUFFER, s_chunk->GetIndicesSize() * sizeof(GLuint), s_chunk->GetIndices(), GL_STATIC_DRAW));
-
-		// gera um Vertex Buffer Object utilizado para armazenar os vértices
-		// na memória da GPU
-		GL_CHECK(glGenBuffers(1, &s_vbo));
-		// seleciona o Buffer
-		//GL_CHECK(glBindBuffer(GL_ARRAY_BUFFER, s_vbo));
-		// copia os vértices da memória RAM para a memória da GPU
-		//GL_CHECK(glBufferData(GL_ARRAY_BUFFER, s_chunk->GetVerticesSize() * sizeof(GLdouble), s_chunk->GetVertices(), GL_STATIC_DRAW));
-
-		// cria o layout do VAO (para poder ser utilizado no shader)
-		//GL_CHECK(glVertexAttribPointer(0, 3, GL_DOUBLE, GL_FALSE, 0, (void*)0));
-		//GL_CHECK(glEnableVertexAttribArray(0));
-
-		GL_CHECK(glGenBuffers(1, &s_n_vbo));
-		/*GL_CHECK(glBindBuffer(GL_ARRAY_BUFFER, s_n_vbo));
-		GL_CHECK(glBufferData(GL_ARRAY_BUFFER, s_chunk->GetNormalsSize() * sizeof(GLdouble), s_chunk->GetNormals(), GL_STATIC_DRAW));*/
-
-		//// normaliza as normais
-		//GL_CHECK(glVertexAttribPointer(1, 3, GL_DOUBLE, GL_TRUE, 0, (void*)0));
-		//GL_CHECK(glEnableVertexAttribArray(1));
+		// buffers de vértices, normais e índices do s_chunk. Com a textura de
+		// alturas ou o upload persistente, os atributos vêm de outro lugar
+		s_uploader = new wega::ChunkUploader{ USE_PACKED_VERTICES };
+		s_uploader->Bind(!USE_HEIGHT_TEXTURE && !USE_PERSISTENT_UPLOAD);
 
 		// 
 		glEnable(GL_DEPTH_TEST);
@@ -267,7 +385,8 @@ int main(void)
 		// Camera
 		auto* camera = new wega::Camera{ window };
 		glm::mat4 view_matrix = CreateViewMatrix(camera);
-		glm::mat4 projection_matrix = wega::GenerateProjectionMatrix(WIDTH, HEIGHT, FOV, NEAR_PLANE, FAR_PLANE);
+		const float far_plane = TERRAIN_MODE == TerrainMode::CLIPMAP ? CLIPMAP_FAR_PLANE : FAR_PLANE;
+		glm::mat4 projection_matrix = wega::GenerateProjectionMatrix(WIDTH, HEIGHT, FOV, NEAR_PLANE, far_plane);
 		glm::mat4 transformation_matrix = wega::CreateTransformationMatrix(
 			s_position,
 			s_rx,
@@ -276,7 +395,9 @@ int main(void)
 			s_scale
 		);
 
-		auto* shader = new wega::Shader{ "../shaders/ambient.vert", "../shaders/ambient.frag" };
+		const char* vertex_shader = TERRAIN_MODE == TerrainMode::CDLOD ? "../shaders/cdlod.vert"
+			: USE_HEIGHT_TEXTURE ? "../shaders/height_texture.vert" : "../shaders/ambient.vert";
+		auto* shader = new wega::Shader{ vertex_shader, "../shaders/ambient.frag" };
 		shader->Bind();
 		shader->SetM4F("projection_matrix", projection_matrix);
 
@@ -289,61 +410,25 @@ int main(void)
 		shader->SetV3("terrain_color", terrain_color);
 		shader->SetV3("light_color", light_color);
 		shader->SetV3("light_pos", light_position);
+		shader->SetBool("packed_vertices", USE_PACKED_VERTICES);
 
 #pragma region
 		
-		module::RidgedMulti ridged;
-		ridged.SetOctaveCount(8);
-		ridged.SetFrequency(2);
-		ridged.SetLacunarity(1.2);
-		
-		module::Billow base;
-		base.SetFrequency(2.0);
-		base.SetOctaveCount(8);
-		base.SetLacunarity(2.5);
-
-		module::ScaleBias flattener;
-		flattener.SetSourceModule(0, base);
-		flattener.SetScale(0.02);
-		flattener.SetBias(-0.75);
-
-		module::Perlin perlin;
-		module::Add adder;
-		module::Voronoi voronoi;
-		module::Select selector;
-		module::Turbulence turbulence;
+		wega::TerrainNoise terrain_noise;
 		utils::NoiseMap height_map;
 		utils::NoiseMapBuilderPlane height_map_builder;
 
-		perlin.SetSeed(123456789);
-		perlin.SetOctaveCount(8);
-		perlin.SetFrequency(2.0);
-		perlin.SetPersistence(1 / 4);
-		perlin.SetLacunarity(1.5);
-
-		voronoi.SetFrequency(1);
-		voronoi.SetDisplacement(10);
-
-		selector.SetSourceModule(0, flattener);
-		selector.SetSourceModule(1, ridged);
-		selector.SetControlModule(perlin);
-		selector.SetBounds(0.8, 1000.0);
-		selector.SetEdgeFalloff(0.9);
-
-		turbulence.SetSourceModule(0, selector);
-		turbulence.SetFrequency(2.0);
-		turbulence.SetPower(1/4);
-
-		adder.SetSourceModule(1, perlin);
-		adder.SetSourceModule(0, voronoi);
-
 		//height_map_builder.SetSourceModule(ridged);
-		height_map_builder.SetSourceModule(turbulence);
+		height_map_builder.SetSourceModule(terrain_noise.GetSource());
 		height_map_builder.SetDestNoiseMap(height_map);
 		
-		const auto sz = TERRAIN_VERTEX_COUNT;
+		const auto sz = CHUNK_VERTEX_COUNT;
 		height_map_builder.SetDestSize(sz, sz);
-		height_map_builder.EnableSeamless(true);
+		// o modo seamless mistura valores da janela inteira, então não pode
+		// ser avaliado por faixas
+		height_map_builder.EnableSeamless(!TERRAIN_SCROLLING);
+		// as linhas do mapa são divididas entre todas as threads do hardware
+		height_map_builder.SetThreadCount(0);
 
 #pragma endregion HEIGHT_GEN
 
@@ -352,17 +437,68 @@ int main(void)
 		auto z_lower_bound_increment = 0.0;
 		auto z_upper_bound_increment = 2.0;
 
-		height_map_builder.SetBounds(0.0, 2.0, 0.0, 2.0);
-		height_map_builder.Build();
+		const double sample_delta = 2.0 / sz;
+		const int scroll_step = static_cast<int>(std::lround(TERRAIN_MOVEMENT_STEP / sample_delta));
+		wega::ChunkManager* chunk_manager = nullptr;
+		wega::Clipmap* clipmap = nullptr;
+		wega::Cdlod* cdlod = nullptr;
 
-		height_generator.ApplyHeightMap(height_map);
-		s_chunk->GenerateMesh();
-		SendChunkDataToGPU();
+		if (TERRAIN_MODE == TerrainMode::CLIPMAP)
+		{
+			// mesmo espaçamento de ruído por unidade do mundo do chunk único
+			const double clipmap_delta = sample_delta * (sz - 1) / (CLIPMAP_VERTEX_COUNT - 1);
+			clipmap = new wega::Clipmap{ terrain_noise.GetSource(), CLIPMAP_VERTEX_COUNT, CLIPMAP_LEVELS,
+				clipmap_delta, 0.0, 0.0, wega::HeightGenerator::AMPLITUDE };
+		}
+		else if (TERRAIN_MODE == TerrainMode::STREAMING)
+		{
+			// mantém o mesmo espaçamento de ruído por unidade do mundo do chunk único
+			const double streaming_delta = sample_delta * (sz - 1) / (STREAMING_CHUNK_VERTEX_COUNT - 1);
+			chunk_manager = new wega::ChunkManager{ terrain_noise.GetSource(), STREAMING_CHUNK_VERTEX_COUNT,
+				STREAMING_RADIUS, streaming_delta, wega::HeightGenerator::AMPLITUDE };
+		}
+		else
+		{
+			if (height_map_builder.IsSeamlessEnabled())
+			{
+				// com o grafo periódico na largura da janela o mapa já fecha
+				// nas bordas em qualquer posição, e cada amostra é avaliada
+				// uma vez só em vez das quatro da mistura do modo seamless
+				terrain_noise.SetPeriod(2.0);
+				height_map_builder.EnablePeriodicSource();
+			}
+			height_map_builder.SetBounds(0.0, 2.0, 0.0, 2.0);
+			height_map_builder.Build();
+
+			height_generator.ApplyHeightMap(height_map);
+			if (USE_HEIGHT_TEXTURE)
+				s_height_texture = new wega::HeightTexture{ s_chunk->GetSize() };
+			if (USE_ADAPTIVE_MESH)
+				s_rtin = new wega::Rtin{ s_chunk };
+			if (USE_PACKED_VERTICES)
+				s_chunk->EnablePackedVertices();
+			if (USE_PERSISTENT_UPLOAD)
+				s_stream_buffer = new wega::StreamBuffer{ (s_chunk->GetVerticesSize() + s_chunk->GetNormalsSize()) * static_cast<GLsizeiptr>(sizeof(GLdouble)) };
+			RebuildChunkMesh();
+			height_generator.SetScrollSource(terrain_noise.GetSource(), 0.0, 0.0, sample_delta);
+
+			if (TERRAIN_MODE == TerrainMode::CDLOD)
+				cdlod = new wega::Cdlod{ s_chunk };
+		}
 		
+		double frame_time_start = glfwGetTime();
+		int frame_count = 0;
+
 		// loop de renderização
 		while (!glfwWindowShouldClose(window))
 		{
-			if (s_movement_forward != 0 || s_movement_left != 0)
+			if (TERRAIN_SCROLLING && (s_movement_forward != 0 || s_movement_left != 0))
+			{
+				height_generator.Scroll(scroll_step * s_movement_forward, scroll_step * s_movement_left);
+				SendChunkToGPU();
+				s_movement_left = s_movement_forward = 0;
+			}
+			else if ((TERRAIN_MODE == TerrainMode::FULL_REBUILD || TERRAIN_MODE == TerrainMode::CDLOD) && (s_movement_forward != 0 || s_movement_left != 0))
 			{
 				x_lower_bound_increment += TERRAIN_MOVEMENT_STEP * s_movement_forward;
 				x_upper_bound_increment += TERRAIN_MOVEMENT_STEP * s_movement_forward;
@@ -371,8 +507,9 @@ int main(void)
 				height_map_builder.SetBounds(x_lower_bound_increment, x_upper_bound_increment, z_lower_bound_increment, z_upper_bound_increment);
 				height_map_builder.Build();
 				height_generator.ApplyHeightMap(height_map);
-				s_chunk->GenerateMesh();
-				SendChunkDataToGPU();
+				RebuildChunkMesh();
+				if (cdlod != nullptr)
+					cdlod->Rebuild();
 				s_movement_left = s_movement_forward = 0;
 			}
 			
@@ -407,7 +544,7 @@ int main(void)
 			
 			view_matrix = CreateViewMatrix(camera);
 			/* Rotate(0.0f, 0.2f, 0.0f); */
-			transformation_matrix = wega::CreateTransformationMatrix(s_position, s_rx, s_ry, s_rz, s_scale);
+			transformation_matrix = wega::CreateTransformationMatrix(s_position + s_chunk->GetScrollOffset(), s_rx, s_ry, s_rz, s_scale);
 			shader->SetM4F("view_matrix", view_matrix);
 			shader->SetM4F("transformation_matrix", transformation_matrix);
 			shader->SetV3("view_pos", camera->GetPosition());
@@ -415,18 +552,91 @@ int main(void)
 			// 1o: gerenciar todos os inputs
 			// 2o: renderizar
 			/* GL_CHECK(glBufferSubData(GL_ARRAY_BUFFER, 0, chunk->GetVerticesSize() * sizeof(GLdouble), chunk->GetVertices())); */
-			GL_CHECK(glDrawElements(GL_TRIANGLES, s_chunk->GetIndicesSize(), GL_UNSIGNED_INT, 0));
+			// posição da câmera no espaço do terreno
+			glm::vec4 local_camera = glm::inverse(transformation_matrix) * glm::vec4{ camera->GetPosition(), 1.0f };
+			if (chunk_manager != nullptr)
+			{
+				chunk_manager->Update(glm::vec3{ local_camera.x, local_camera.y, local_camera.z });
+				chunk_manager->Draw();
+			}
+			else if (clipmap != nullptr)
+			{
+				clipmap->Update(glm::vec3{ local_camera.x, local_camera.y, local_camera.z });
+				clipmap->Draw(*shader, transformation_matrix);
+			}
+			else if (cdlod != nullptr)
+			{
+				cdlod->Select(glm::vec3{ local_camera.x, local_camera.y, local_camera.z }, projection_matrix * view_matrix * transformation_matrix);
+				cdlod->Draw(*shader);
+			}
+			else
+			{
+				GL_CHECK(glBindVertexArray(s_vao));
+				if (s_height_texture != nullptr)
+					s_height_texture->Bind(*shader, *s_chunk);
+				if (USE_PACKED_VERTICES)
+					wega::ChunkUploader::SetPackedUniforms(*shader, *s_chunk);
+				if (s_rtin != nullptr)
+				{
+					// a câmera se move sem reconstruir o chunk: só troca os
+					// índices quando o limite muda o bastante
+					const double max_error = GetAdaptiveMaxError(glm::vec3{ local_camera.x, local_camera.y, local_camera.z });
+					if (max_error > s_adaptive_max_error * ADAPTIVE_ERROR_STEP || max_error < s_adaptive_max_error / ADAPTIVE_ERROR_STEP)
+					{
+						s_adaptive_max_error = max_error;
+						SendAdaptiveIndicesToGPU();
+					}
+					GL_CHECK(glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(s_adaptive_indices.size()), GL_UNSIGNED_INT, static_cast<void*>(0)));
+				}
+				else
+					GL_CHECK(glMultiDrawElements(GL_TRIANGLES, s_chunk->GetDrawCounts(), GL_UNSIGNED_INT, s_chunk->GetDrawOffsets(), s_chunk->GetDrawCount()));
+			}
+
+			if (LOG_UPLOADED_BYTES)
+			{
+				size_t uploaded_bytes = s_uploader->GetUploadedBytes() + s_stream_uploaded_bytes;
+				if (s_height_texture != nullptr)
+					uploaded_bytes += s_height_texture->GetUploadedBytes();
+				if (clipmap != nullptr)
+					uploaded_bytes += clipmap->GetUploadedBytes();
+				if (chunk_manager != nullptr)
+					uploaded_bytes += chunk_manager->GetUploadedBytes();
+
+				if (uploaded_bytes > 0)
+					std::cout << "upload: " << uploaded_bytes << " bytes\n";
+			}
+			s_uploader->ResetUploadedBytes();
+			s_stream_uploaded_bytes = 0;
+			if (s_height_texture != nullptr)
+				s_height_texture->ResetUploadedBytes();
+			if (clipmap != nullptr)
+				clipmap->ResetUploadedBytes();
+			if (chunk_manager != nullptr)
+				chunk_manager->ResetUploadedBytes();
 			
 			// 3o: trocar os buffers (troca o buffer que está sendo desenhado
 			// pelo que está sendo mostrado na janela)
 			glfwSwapBuffers(window);
+
+			if (LOG_FRAME_TIME && ++frame_count == FRAME_TIME_SAMPLES)
+			{
+				double now = glfwGetTime();
+				std::cout << "quadro: " << (now - frame_time_start) * 1000.0 / frame_count << " ms\n";
+				frame_time_start = now;
+				frame_count = 0;
+			}
 		}
 
+		delete chunk_manager;
+		delete clipmap;
+		delete cdlod;
+		delete s_height_texture;
+		delete s_stream_buffer;
+		delete s_rtin;
 		delete s_chunk;
 		delete camera;
 		delete shader;
-		GL_CHECK(glDeleteBuffers(1, &s_ibo));
-		GL_CHECK(glDeleteBuffers(1, &s_vbo));
+		delete s_uploader;
 		GL_CHECK(glDeleteVertexArrays(1, &s_vao));
 	}
 
@@ -20,9 +20,14 @@
 // off every 'zig'.)
 //
 
+#include <atomic>
 #include <fstream>
+#include <memory>
+#include <thread>
+#include <vector>
 
 #include <noise/interp.h>
+#include <noise/latlon.h>
 #include <noise/mathconsts.h>
 
 #include "noiseutils.h"
@@ -118,9 +123,10 @@ using namespace noise::utils;
 //////////////////////////////////////////////////////////////////////////////
 // GradientColor class
 
-GradientColor::GradientColor ()
+GradientColor::GradientColor ():
+  m_gradientPointCount (0),
+  m_pGradientPoints (NULL)
 {
-  m_pGradientPoints = NULL;
 }
 
 GradientColor::~GradientColor ()
@@ -163,7 +169,7 @@ int GradientColor::FindInsertionPos (double gradientPos)
   return insertionPos;
 }
 
-const Color& GradientColor::GetColor (double gradientPos) const
+Color GradientColor::GetColor (double gradientPos) const
 {
   assert (m_gradientPointCount >= 2);
 
@@ -187,8 +193,7 @@ const Color& GradientColor::GetColor (double gradientPos) const
   // the corresponding gradient color of the nearest gradient point and exit
   // now.
   if (index0 == index1) {
-    m_workingColor = m_pGradientPoints[index1].color;
-    return m_workingColor;
+    return m_pGradientPoints[index1].color;
   }
   
   // Compute the alpha value used for linear interpolation.
@@ -199,8 +204,9 @@ const Color& GradientColor::GetColor (double gradientPos) const
   // Now perform the linear interpolation given the alpha value.
   const Color& color0 = m_pGradientPoints[index0].color;
   const Color& color1 = m_pGradientPoints[index1].color;
-  LinearInterpColor (color0, color1, (float)alpha, m_workingColor);
-  return m_workingColor;
+  Color color;
+  LinearInterpColor (color0, color1, (float)alpha, color);
+  return color;
 }
 
 void GradientColor::InsertAtPos (int insertionPos, double gradientPos,
@@ -757,10 +763,92 @@ NoiseMapBuilder::NoiseMapBuilder ():
   m_destHeight (0),
   m_destWidth  (0),
   m_pDestNoiseMap (NULL),
-  m_pSourceModule (NULL)
+  m_pSourceModule (NULL),
+  m_precision (PRECISION_DOUBLE),
+  m_threadCount (1)
 {
 }
 
+void NoiseMapBuilder::FillRows (const NoiseMapRowFiller& fillRow)
+{
+  int threadCount = m_threadCount;
+  if (threadCount <= 0) {
+    threadCount = (int)std::thread::hardware_concurrency ();
+  }
+  if (threadCount > m_destHeight) {
+    threadCount = m_destHeight;
+  }
+
+  // The noise precision is a setting of each thread; the calling thread
+  // gets its own back at the end.
+  NoisePrecision previousPrecision = GetNoisePrecision ();
+  SetNoisePrecision (m_precision);
+
+  if (threadCount <= 1) {
+    std::vector<double> buffer;
+    for (int y = 0; y < m_destHeight; y++) {
+      fillRow (y, m_pDestNoiseMap->GetSlabPtr (y), buffer);
+      if (m_pCallback != NULL) {
+        m_pCallback (y);
+      }
+    }
+    SetNoisePrecision (previousPrecision);
+    return;
+  }
+
+  // The rows are handed out one at a time, so a thread that gets cheap rows
+  // takes more of them.  The calling thread fills rows too, and between
+  // them it reports the finished rows to the callback, in order.
+  std::atomic<int> nextRow (0);
+  std::unique_ptr<std::atomic<bool>[]> isRowDone (
+    new std::atomic<bool>[m_destHeight]);
+  for (int y = 0; y < m_destHeight; y++) {
+    isRowDone[y].store (false, std::memory_order_relaxed);
+  }
+
+  const auto fill = [&] (std::vector<double>& buffer) {
+    int y = nextRow++;
+    if (y >= m_destHeight) {
+      return false;
+    }
+    fillRow (y, m_pDestNoiseMap->GetSlabPtr (y), buffer);
+    isRowDone[y].store (true, std::memory_order_release);
+    return true;
+  };
+
+  std::vector<std::thread> workers;
+  for (int i = 1; i < threadCount; i++) {
+    workers.emplace_back ([&] () {
+      SetNoisePrecision (m_precision);
+      std::vector<double> buffer;
+      while (fill (buffer)) {
+      }
+    });
+  }
+
+  std::vector<double> buffer;
+  int reportedRows = 0;
+  while (fill (buffer)) {
+    while (reportedRows < m_destHeight
+      && isRowDone[reportedRows].load (std::memory_order_acquire)) {
+      if (m_pCallback != NULL) {
+        m_pCallback (reportedRows);
+      }
+      reportedRows++;
+    }
+  }
+
+  for (auto& worker: workers) {
+    worker.join ();
+  }
+  for (; reportedRows < m_destHeight; reportedRows++) {
+    if (m_pCallback != NULL) {
+      m_pCallback (reportedRows);
+    }
+  }
+  SetNoisePrecision (previousPrecision);
+}
+
 void NoiseMapBuilder::SetCallback (NoiseMapCallback pCallback)
 {
   m_pCallback = pCallback;
@@ -792,10 +880,6 @@ void NoiseMapBuilderCylinder::Build ()
   // values from the source model.
   m_pDestNoiseMap->SetSize (m_destWidth, m_destHeight);
 
-  // Create the cylinder model.
-  model::Cylinder cylinderModel;
-  cylinderModel.SetModule (*m_pSourceModule);
-
   double angleExtent  = m_upperAngleBound  - m_lowerAngleBound ;
   double heightExtent = m_upperHeightBound - m_lowerHeightBound;
   double xDelta = angleExtent  / (double)m_destWidth ;
@@ -803,20 +887,37 @@ void NoiseMapBuilderCylinder::Build ()
   double curAngle  = m_lowerAngleBound ;
   double curHeight = m_lowerHeightBound;
 
-  // Fill every point in the noise map with the output values from the model.
+  // Each row is evaluated with a single GetValues() call on the same
+  // coordinates that model::Cylinder would pass to the source module.  The
+  // angle only changes along the row, so its cosine and sine are computed
+  // once, and the heights are accumulated up front so that the rows can be
+  // filled in any order.
+  std::vector<double> xRow (m_destWidth), zRow (m_destWidth);
+  for (int x = 0; x < m_destWidth; x++) {
+    xRow[x] = cos (curAngle * DEG_TO_RAD);
+    zRow[x] = sin (curAngle * DEG_TO_RAD);
+    curAngle += xDelta;
+  }
+  std::vector<double> heights (m_destHeight);
   for (int y = 0; y < m_destHeight; y++) {
-    float* pDest = m_pDestNoiseMap->GetSlabPtr (y);
-    curAngle = m_lowerAngleBound;
+    heights[y] = curHeight;
+    curHeight += yDelta;
+  }
+
+  // Fill every point in the noise map with the output values from the model.
+  FillRows ([&] (int y, float* pDest, std::vector<double>& buffer) {
+    buffer.resize (2 * m_destWidth);
+    double* yRow = &buffer[0];
+    double* values = yRow + m_destWidth;
     for (int x = 0; x < m_destWidth; x++) {
-      float curValue = (float)cylinderModel.GetValue (curAngle, curHeight);
-      *pDest++ = curValue;
-      curAngle += xDelta;
+      yRow[x] = heights[y];
     }
-    curHeight += yDelta;
-    if (m_pCallback != NULL) {
-      m_pCallback (y);
+    m_pSourceModule->GetValues (&xRow[0], yRow, &zRow[0], values,
+      m_destWidth);
+    for (int x = 0; x < m_destWidth; x++) {
+      *pDest++ = (float)values[x];
     }
-  }
+  });
 }
 
 /////////////////////////////////////////////////////////////////////////////
@@ -824,6 +925,7 @@ void NoiseMapBuilderCylinder::Build ()
 
 NoiseMapBuilderPlane::NoiseMapBuilderPlane ():
   m_isSeamlessEnabled (false),
+  m_isPeriodicSourceEnabled (false),
   m_lowerXBound  (0.0),
   m_lowerZBound  (0.0),
   m_upperXBound  (0.0),
@@ -846,10 +948,6 @@ void NoiseMapBuilderPlane::Build ()
   // values from the source model.
   m_pDestNoiseMap->SetSize (m_destWidth, m_destHeight);
 
-  // Create the plane model.
-  model::Plane planeModel;
-  planeModel.SetModule (*m_pSourceModule);
-
   double xExtent = m_upperXBound - m_lowerXBound;
   double zExtent = m_upperZBound - m_lowerZBound;
   double xDelta  = xExtent / (double)m_destWidth ;
@@ -857,34 +955,65 @@ void NoiseMapBuilderPlane::Build ()
   double xCur    = m_lowerXBound;
   double zCur    = m_lowerZBound;
 
-  // Fill every point in the noise map with the output values from the model.
+  // Each row is evaluated with one GetValues() call per corner on the same
+  // coordinates that model::Plane would pass to the source module.  Without
+  // seamless tiling, or with a periodic source module whose corners all
+  // return the same value, only the first corner is evaluated.  The
+  // coordinates are accumulated up front so that the rows can be filled in
+  // any order.
+  std::vector<double> xRow (m_destWidth), xRowEast (m_destWidth);
+  std::vector<double> yRow (m_destWidth, 0.0);
+  for (int x = 0; x < m_destWidth; x++) {
+    xRow[x] = xCur;
+    xRowEast[x] = xCur + xExtent;
+    xCur += xDelta;
+  }
+  std::vector<double> zCoords (m_destHeight);
   for (int z = 0; z < m_destHeight; z++) {
-    float* pDest = m_pDestNoiseMap->GetSlabPtr (z);
-    xCur = m_lowerXBound;
+    zCoords[z] = zCur;
+    zCur += zDelta;
+  }
+
+  // Fill every point in the noise map with the output values from the model.
+  FillRows ([&] (int z, float* pDest, std::vector<double>& buffer) {
+    buffer.resize (5 * m_destWidth);
+    double* zRow = &buffer[0];
+    double* swValues = zRow + m_destWidth;
+    double* seValues = swValues + m_destWidth;
+    double* nwValues = seValues + m_destWidth;
+    double* neValues = nwValues + m_destWidth;
+
     for (int x = 0; x < m_destWidth; x++) {
-      float finalValue;
-      if (!m_isSeamlessEnabled) {
-        finalValue = planeModel.GetValue (xCur, zCur);
-      } else {
-        double swValue, seValue, nwValue, neValue;
-        swValue = planeModel.GetValue (xCur          , zCur          );
-        seValue = planeModel.GetValue (xCur + xExtent, zCur          );
-        nwValue = planeModel.GetValue (xCur          , zCur + zExtent);
-        neValue = planeModel.GetValue (xCur + xExtent, zCur + zExtent);
-        double xBlend = 1.0 - ((xCur - m_lowerXBound) / xExtent);
-        double zBlend = 1.0 - ((zCur - m_lowerZBound) / zExtent);
-        double z0 = LinearInterp (swValue, seValue, xBlend);
-        double z1 = LinearInterp (nwValue, neValue, xBlend);
-        finalValue = (float)LinearInterp (z0, z1, zBlend);
+      zRow[x] = zCoords[z];
+    }
+    m_pSourceModule->GetValues (&xRow[0], &yRow[0], zRow, swValues,
+      m_destWidth);
+
+    if (!m_isSeamlessEnabled || m_isPeriodicSourceEnabled) {
+      for (int x = 0; x < m_destWidth; x++) {
+        *pDest++ = (float)swValues[x];
       }
-      *pDest++ = finalValue;
-      xCur += xDelta;
+      return;
     }
-    zCur += zDelta;
-    if (m_pCallback != NULL) {
-      m_pCallback (z);
+
+    m_pSourceModule->GetValues (&xRowEast[0], &yRow[0], zRow, seValues,
+      m_destWidth);
+    for (int x = 0; x < m_destWidth; x++) {
+      zRow[x] = zCoords[z] + zExtent;
     }
-  }
+    m_pSourceModule->GetValues (&xRow[0], &yRow[0], zRow, nwValues,
+      m_destWidth);
+    m_pSourceModule->GetValues (&xRowEast[0], &yRow[0], zRow, neValues,
+      m_destWidth);
+
+    double zBlend = 1.0 - ((zCoords[z] - m_lowerZBound) / zExtent);
+    for (int x = 0; x < m_destWidth; x++) {
+      double xBlend = 1.0 - ((xRow[x] - m_lowerXBound) / xExtent);
+      double z0 = LinearInterp (swValues[x], seValues[x], xBlend);
+      double z1 = LinearInterp (nwValues[x], neValues[x], xBlend);
+      *pDest++ = (float)LinearInterp (z0, z1, zBlend);
+    }
+  });
 }
 
 /////////////////////////////////////////////////////////////////////////////
@@ -913,10 +1042,6 @@ void NoiseMapBuilderSphere::Build ()
   // values from the source model.
   m_pDestNoiseMap->SetSize (m_destWidth, m_destHeight);
 
-  // Create the plane model.
-  model::Sphere sphereModel;
-  sphereModel.SetModule (*m_pSourceModule);
-
   double lonExtent = m_eastLonBound  - m_westLonBound ;
   double latExtent = m_northLatBound - m_southLatBound;
   double xDelta = lonExtent / (double)m_destWidth ;
@@ -924,20 +1049,36 @@ void NoiseMapBuilderSphere::Build ()
   double curLon = m_westLonBound ;
   double curLat = m_southLatBound;
 
-  // Fill every point in the noise map with the output values from the model.
+  // Each row is evaluated with a single GetValues() call on the same
+  // coordinates that model::Sphere would pass to the source module.  The
+  // coordinates are accumulated up front so that the rows can be filled in
+  // any order.
+  std::vector<double> lons (m_destWidth);
+  for (int x = 0; x < m_destWidth; x++) {
+    lons[x] = curLon;
+    curLon += xDelta;
+  }
+  std::vector<double> lats (m_destHeight);
   for (int y = 0; y < m_destHeight; y++) {
-    float* pDest = m_pDestNoiseMap->GetSlabPtr (y);
-    curLon = m_westLonBound;
+    lats[y] = curLat;
+    curLat += yDelta;
+  }
+
+  // Fill every point in the noise map with the output values from the model.
+  FillRows ([&] (int y, float* pDest, std::vector<double>& buffer) {
+    buffer.resize (4 * m_destWidth);
+    double* xRow = &buffer[0];
+    double* yRow = xRow + m_destWidth;
+    double* zRow = yRow + m_destWidth;
+    double* values = zRow + m_destWidth;
     for (int x = 0; x < m_destWidth; x++) {
-      float curValue = (float)sphereModel.GetValue (curLat, curLon);
-      *pDest++ = curValue;
-      curLon += xDelta;
+      LatLonToXYZ (lats[y], lons[x], xRow[x], yRow[x], zRow[x]);
     }
-    curLat += yDelta;
-    if (m_pCallback != NULL) {
-      m_pCallback (y);
+    m_pSourceModule->GetValues (xRow, yRow, zRow, values, m_destWidth);
+    for (int x = 0; x < m_destWidth; x++) {
+      *pDest++ = (float)values[x];
     }
-  }
+  });
 }
 
 //////////////////////////////////////////////////////////////////////////////
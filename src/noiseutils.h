@@ -25,7 +25,9 @@
 
 #include <stdlib.h>
 #include <string.h>
+#include <functional>
 #include <string>
+#include <vector>
 
 #include <noise/noise.h>
 
@@ -97,6 +99,14 @@ namespace noise
     /// method.
     typedef void(*NoiseMapCallback) (int row);
 
+    /// A function that fills one row of a noise map, used by the
+    /// NoiseMapBuilder::FillRows() method.
+    ///
+    /// It receives the row index, a pointer to the first value of that row
+    /// and a scratch buffer owned by the calling thread, which it may resize.
+    typedef std::function<void (int row, float* pDest,
+      std::vector<double>& buffer)> NoiseMapRowFiller;
+
     /// Number of meters per point in a Terragen terrain (TER) file.
     const double DEFAULT_METERS_PER_POINT = 30.0;
 
@@ -231,7 +241,10 @@ namespace noise
         /// @param gradientPos The specified position.
         ///
         /// @returns The color at that position.
-        const Color& GetColor (double gradientPos) const;
+        ///
+        /// The color is returned by value and this object is not modified, so
+        /// several threads can share a gradient.
+        Color GetColor (double gradientPos) const;
 
         /// Returns a pointer to the array of gradient points in this object.
         ///
@@ -298,10 +311,6 @@ namespace noise
 
         /// Array that stores the gradient points.
         GradientPoint* m_pGradientPoints;
-
-        /// A color object that is used by a gradient object to store a
-        /// temporary value.
-        mutable Color m_workingColor;
     };
 
     /// Implements a noise map, a 2-dimensional array of floating-point
@@ -1397,6 +1406,10 @@ namespace noise
         /// contains a count of the rows that have been completed.  It returns
         /// void.  Pass a function with this signature to the SetCallback()
         /// method.
+        ///
+        /// The callback is always called from the thread that called Build(),
+        /// once per row and in row order, even when the rows are filled by
+        /// several threads.
         void SetCallback (NoiseMapCallback pCallback);
 
         /// Sets the destination noise map.
@@ -1442,8 +1455,69 @@ namespace noise
           m_destHeight = destHeight;
         }
 
+        /// Returns the precision of the gradient-coherent noise generated by
+        /// the Build() method.
+        ///
+        /// @returns The noise precision.
+        NoisePrecision GetPrecision () const
+        {
+          return m_precision;
+        }
+
+        /// Returns the number of threads that the Build() method uses.
+        ///
+        /// @returns The number of threads; zero means one per hardware
+        /// thread.
+        int GetThreadCount () const
+        {
+          return m_threadCount;
+        }
+
+        /// Sets the precision of the gradient-coherent noise generated by the
+        /// Build() method.
+        ///
+        /// @param precision The noise precision.
+        ///
+        /// Build() applies it with noise::SetNoisePrecision() on every
+        /// thread that evaluates the source module, and gives the calling
+        /// thread its own precision back afterwards.  With
+        /// noise::PRECISION_SINGLE the generators calculate their noise in
+        /// float, with twice as many values per SIMD register; the noise map
+        /// stores float values anyway, and they differ from the
+        /// double-precision ones by about the rounding of that float.
+        ///
+        /// The default is noise::PRECISION_DOUBLE.
+        void SetPrecision (NoisePrecision precision)
+        {
+          m_precision = precision;
+        }
+
+        /// Sets the number of threads that the Build() method uses.
+        ///
+        /// @param threadCount The number of threads, including the calling
+        /// thread.  Zero uses one thread per hardware thread.
+        ///
+        /// The rows of the noise map are distributed between the threads,
+        /// so the source module is evaluated concurrently.  The noise modules
+        /// in libnoise support this (noise::module::Cache keeps its cached
+        /// value per thread); custom noise modules must not modify shared
+        /// state in GetValue().
+        ///
+        /// The default is one thread.
+        void SetThreadCount (int threadCount)
+        {
+          m_threadCount = threadCount;
+        }
+
       protected:
 
+        /// Fills every row of the destination noise map with @a fillRow,
+        /// distributing the rows between GetThreadCount() threads, and calls
+        /// the callback for each row from the calling thread.
+        ///
+        /// @pre The destination noise map has been resized.
+        void FillRows (const NoiseMapRowFiller& fillRow);
+
         /// The callback function that Build() calls each time it fills a row
         /// of the noise map with coherent-noise values.
         ///
@@ -1465,6 +1539,12 @@ namespace noise
         /// Source noise module that will generate the coherent-noise values.
         const module::Module* m_pSourceModule;
 
+        /// Precision of the noise generated by the Build() method.
+        NoisePrecision m_precision;
+
+        /// Number of threads used by the Build() method.
+        int m_threadCount;
+
     };
 
     /// Builds a cylindrical noise map.
@@ -1596,7 +1676,10 @@ namespace noise
     /// bounds of the noise map, in units.
     ///
     /// To make a tileable noise map with no seams at the edges, call the
-    /// EnableSeamless() method.
+    /// EnableSeamless() method.  If the source module already repeats over
+    /// the bounds of the noise map (see noise::module::Perlin::SetPeriod()),
+    /// also call EnablePeriodicSource() so that each point is evaluated once
+    /// instead of four times.
     class NoiseMapBuilderPlane: public NoiseMapBuilder
     {
 
@@ -1618,6 +1701,27 @@ namespace noise
           m_isSeamlessEnabled = enable;
         }
 
+        /// Declares that the source module is periodic over the bounds of
+        /// the noise map.
+        ///
+        /// @param enable A flag that declares or stops declaring the source
+        /// module periodic.
+        ///
+        /// A periodic source module returns the same value at (x, z),
+        /// (x + width, z) and (x, z + height), where width and height are
+        /// the extents of the bounds; for example, a graph of periodic
+        /// noise modules whose period is the extent of the bounds.  Such a
+        /// noise map is already seamless, so with seamless tiling enabled
+        /// Build() evaluates each point once, instead of blending the four
+        /// values at the corresponding points of the neighboring tiles.
+        ///
+        /// The builder does not check the source module; if it does not
+        /// repeat, the noise map has seams.
+        void EnablePeriodicSource (bool enable = true)
+        {
+          m_isPeriodicSourceEnabled = enable;
+        }
+
         /// Returns the lower x boundary of the planar noise map.
         ///
         /// @returns The lower x boundary of the planar noise map, in units.
@@ -1663,6 +1767,18 @@ namespace noise
           return m_isSeamlessEnabled;
         }
 
+        /// Determines if the source module is declared periodic.
+        ///
+        /// @returns
+        /// - @a true if the source module is declared periodic.
+        /// - @a false if it is not.
+        ///
+        /// See EnablePeriodicSource().
+        bool IsPeriodicSourceEnabled () const
+        {
+          return m_isPeriodicSourceEnabled;
+        }
+
         /// Sets the boundaries of the planar noise map.
         ///
         /// @param lowerXBound The lower x boundary of the noise map, in
@@ -1697,6 +1813,10 @@ namespace noise
         /// A flag specifying whether seamless tiling is enabled.
         bool m_isSeamlessEnabled;
 
+        /// A flag specifying whether the source module is periodic over the
+        /// bounds of the noise map.
+        bool m_isPeriodicSourceEnabled;
+
         /// Lower x boundary of the planar noise map, in units.
         double m_lowerXBound;
 
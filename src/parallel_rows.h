@@ -0,0 +1,40 @@
+#pragma once
+
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+// divisão de um laço sobre linhas entre threads, usada pela geração da
+// malha e do heightmap dos chunks e pelo diamond-square
+namespace wega
+{
+    // nenhuma thread fica com menos linhas que isso
+    static constexpr unsigned int MIN_ROWS_PER_THREAD = 64;
+
+    // chama f(r0, r1) em faixas contíguas de [0, rows) divididas entre
+    // `thread_count` threads (0 = todos os núcleos). Com uma thread só, f é
+    // chamada direto na thread atual
+    template <typename F>
+    void ForRows(unsigned int rows, unsigned int thread_count, const F& f)
+    {
+        unsigned int threads = thread_count > 0 ? thread_count : std::max(1u, std::thread::hardware_concurrency());
+        threads = std::min(threads, std::max(1u, rows / MIN_ROWS_PER_THREAD));
+
+        if (threads == 1)
+        {
+            f(0u, rows);
+            return;
+        }
+
+        std::vector<std::thread> workers;
+        for (unsigned int t = 0; t < threads; t++)
+        {
+            unsigned int r0 = rows * t / threads;
+            unsigned int r1 = rows * (t + 1) / threads;
+            workers.emplace_back([=, &f]() { f(r0, r1); });
+        }
+
+        for (auto& worker : workers)
+            worker.join();
+    }
+}
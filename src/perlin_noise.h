@@ -26,10 +26,13 @@
 //----------------------------------------------------------------------------------------
 
 # pragma once
+# include <cmath>
+# include <cstddef>
 # include <cstdint>
 # include <numeric>
 # include <algorithm>
 # include <random>
+# include "cpu_features.h"
 
 namespace siv
 {
@@ -37,7 +40,9 @@ namespace siv
 	{
 	private:
 
-		std::int32_t p[512];
+		// the 256 shuffled values twice, plus 3 bytes of padding so that
+		// noiseRowAvx2 can fetch any entry with a 32-bit gather
+		std::uint8_t p[512 + 3] = {};
 
 		static double Fade(double t) noexcept
 		{
@@ -57,6 +62,114 @@ namespace siv
 			return ((h & 1) == 0 ? u : -u) + ((h & 2) == 0 ? v : -v);
 		}
 
+		// Grad(hash, x, y, 0)
+		static double Grad(std::int32_t hash, double x, double y) noexcept
+		{
+			const std::int32_t h = hash & 15;
+			const double u = h < 8 ? x : y;
+			const double v = h < 4 ? y : h == 12 || h == 14 ? x : 0.0;
+			return ((h & 1) == 0 ? u : -u) + ((h & 2) == 0 ? v : -v);
+		}
+
+		// acc[i] += noise(x[i], y) * amp
+		void noiseRow(const double* x, std::size_t count, double y, double amp, double* acc) const
+		{
+			static const bool s_avx2 = wega::HasAvx2();
+
+			if (s_avx2)
+			{
+				noiseRowAvx2(x, count, y, amp, acc);
+			}
+			else
+			{
+				noiseRowScalar(x, count, y, amp, acc);
+			}
+		}
+
+		void noiseRowScalar(const double* x, std::size_t count, double y, double amp, double* acc) const
+		{
+			for (std::size_t i = 0; i < count; ++i)
+			{
+				acc[i] += noise(x[i], y) * amp;
+			}
+		}
+
+		// four samples per iteration with the same operations as noise(x, y),
+		// so the results are identical. y is shared by the row, so its cell
+		// and fade are computed once
+		WEGA_TARGET_AVX2 void noiseRowAvx2(const double* x, std::size_t count, double y, double amp, double* acc) const
+		{
+			const double fy = std::floor(y);
+			const double yf = y - fy;
+			const __m128i Y = _mm_set1_epi32(static_cast<std::int32_t>(fy) & 255);
+			const __m128i mask = _mm_set1_epi32(255);
+			const __m128i one_i = _mm_set1_epi32(1);
+			const __m256d one = _mm256_set1_pd(1.0);
+			const __m256d y0 = _mm256_set1_pd(yf);
+			const __m256d y1 = _mm256_set1_pd(yf - 1);
+			const __m256d v = _mm256_set1_pd(Fade(yf));
+			const __m256d vamp = _mm256_set1_pd(amp);
+			std::size_t i = 0;
+
+			for (; i + 4 <= count; i += 4)
+			{
+				const __m256d xv = _mm256_loadu_pd(x + i);
+				const __m256d fx = _mm256_floor_pd(xv);
+				const __m128i X = _mm_and_si128(_mm256_cvttpd_epi32(fx), mask);
+				const __m256d x0 = _mm256_sub_pd(xv, fx);
+				const __m256d x1 = _mm256_sub_pd(x0, one);
+				const __m256d u = FadeAvx2(x0);
+
+				const __m128i A = _mm_add_epi32(PermAvx2(X), Y);
+				const __m128i B = _mm_add_epi32(PermAvx2(_mm_add_epi32(X, one_i)), Y);
+				const __m128i AA = PermAvx2(A), AB = PermAvx2(_mm_add_epi32(A, one_i));
+				const __m128i BA = PermAvx2(B), BB = PermAvx2(_mm_add_epi32(B, one_i));
+
+				const __m256d n = LerpAvx2(v, LerpAvx2(u, GradAvx2(PermAvx2(AA), x0, y0),
+					GradAvx2(PermAvx2(BA), x1, y0)),
+					LerpAvx2(u, GradAvx2(PermAvx2(AB), x0, y1),
+					GradAvx2(PermAvx2(BB), x1, y1)));
+				_mm256_storeu_pd(acc + i, _mm256_add_pd(_mm256_loadu_pd(acc + i), _mm256_mul_pd(n, vamp)));
+			}
+
+			noiseRowScalar(x + i, count - i, y, amp, acc + i);
+		}
+
+		// p[i] for each lane; the gather reads 4 bytes and keeps the first
+		WEGA_TARGET_AVX2 __m128i PermAvx2(__m128i i) const
+		{
+			const int* table = reinterpret_cast<const int*>(p);
+			return _mm_and_si128(_mm_i32gather_epi32(table, i, 1), _mm_set1_epi32(255));
+		}
+
+		WEGA_TARGET_AVX2 static __m256d FadeAvx2(__m256d t) noexcept
+		{
+			const __m256d inner = _mm256_add_pd(_mm256_mul_pd(t, _mm256_sub_pd(_mm256_mul_pd(t, _mm256_set1_pd(6.0)),
+				_mm256_set1_pd(15.0))), _mm256_set1_pd(10.0));
+			return _mm256_mul_pd(_mm256_mul_pd(_mm256_mul_pd(t, t), t), inner);
+		}
+
+		WEGA_TARGET_AVX2 static __m256d LerpAvx2(__m256d t, __m256d a, __m256d b) noexcept
+		{
+			return _mm256_add_pd(a, _mm256_mul_pd(t, _mm256_sub_pd(b, a)));
+		}
+
+		// Grad(hash, x, y) with masks: the negations flip the sign bit
+		WEGA_TARGET_AVX2 static __m256d GradAvx2(__m128i hash, __m256d x, __m256d y) noexcept
+		{
+			const __m256i h = _mm256_cvtepi32_epi64(_mm_and_si128(hash, _mm_set1_epi32(15)));
+			const __m256d lt8 = _mm256_castsi256_pd(_mm256_cmpgt_epi64(_mm256_set1_epi64x(8), h));
+			const __m256d lt4 = _mm256_castsi256_pd(_mm256_cmpgt_epi64(_mm256_set1_epi64x(4), h));
+			const __m256d is_x = _mm256_castsi256_pd(_mm256_or_si256(_mm256_cmpeq_epi64(h, _mm256_set1_epi64x(12)),
+				_mm256_cmpeq_epi64(h, _mm256_set1_epi64x(14))));
+
+			const __m256d u = _mm256_blendv_pd(y, x, lt8);
+			const __m256d v = _mm256_blendv_pd(_mm256_and_pd(x, is_x), y, lt4);
+			const __m256d u_sign = _mm256_castsi256_pd(_mm256_slli_epi64(_mm256_and_si256(h, _mm256_set1_epi64x(1)), 63));
+			const __m256d v_sign = _mm256_castsi256_pd(_mm256_slli_epi64(_mm256_and_si256(h, _mm256_set1_epi64x(2)), 62));
+			return _mm256_add_pd(_mm256_xor_pd(u, u_sign), _mm256_xor_pd(v, v_sign));
+		}
+
 	public:
 
 		explicit PerlinNoise(std::uint32_t seed = std::default_random_engine::default_seed)
@@ -74,7 +187,7 @@ namespace siv
 		{
 			for (size_t i = 0; i < 256; ++i)
 			{
-				p[i] = i;
+				p[i] = static_cast<std::uint8_t>(i);
 			}
 
 			std::shuffle(std::begin(p), std::begin(p) + 256, std::default_random_engine(seed));
@@ -90,7 +203,7 @@ namespace siv
 		{
 			for (size_t i = 0; i < 256; ++i)
 			{
-				p[i] = i;
+				p[i] = static_cast<std::uint8_t>(i);
 			}
 
 			std::shuffle(std::begin(p), std::begin(p) + 256, urng);
@@ -106,9 +219,27 @@ namespace siv
 			return noise(x, 0.0, 0.0);
 		}
 
+		// noise(x, y, 0.0) without the z axis
 		double noise(double x, double y) const
 		{
-			return noise(x, y, 0.0);
+			const double fx = std::floor(x);
+			const double fy = std::floor(y);
+			const std::int32_t X = static_cast<std::int32_t>(fx) & 255;
+			const std::int32_t Y = static_cast<std::int32_t>(fy) & 255;
+
+			x -= fx;
+			y -= fy;
+
+			const double u = Fade(x);
+			const double v = Fade(y);
+
+			const std::int32_t A = p[X] + Y, AA = p[A], AB = p[A + 1];
+			const std::int32_t B = p[X + 1] + Y, BA = p[B], BB = p[B + 1];
+
+			return Lerp(v, Lerp(u, Grad(p[AA], x, y),
+				Grad(p[BA], x - 1, y)),
+				Lerp(u, Grad(p[AB], x, y - 1),
+				Grad(p[BB], x - 1, y - 1)));
 		}
 
 		double noise(double x, double y, double z) const
@@ -186,6 +317,57 @@ namespace siv
 			return result;
 		}
 
+		// out[i] = octaveNoise(x + i * dx, y, octaves) for i in [0, count). Each
+		// octave multiplies the coordinates by `lacunarity` and the amplitude
+		// by `persistence`; with the defaults the values are the same as
+		// octaveNoise's
+		void octaveNoiseRow(double x, double dx, double y, std::size_t count, std::int32_t octaves, double* out,
+			double lacunarity = 2.0, double persistence = 0.5) const
+		{
+			constexpr std::size_t block = 256;
+			double xs[block];
+
+			for (std::size_t start = 0; start < count; start += block)
+			{
+				const std::size_t n = std::min(block, count - start);
+				double* acc = out + start;
+
+				for (std::size_t i = 0; i < n; ++i)
+				{
+					xs[i] = x + static_cast<double>(start + i) * dx;
+					acc[i] = 0.0;
+				}
+
+				double yo = y;
+				double amp = 1.0;
+
+				for (std::int32_t o = 0; o < octaves; ++o)
+				{
+					noiseRow(xs, n, yo, amp, acc);
+
+					for (std::size_t i = 0; i < n; ++i)
+					{
+						xs[i] *= lacunarity;
+					}
+
+					yo *= lacunarity;
+					amp *= persistence;
+				}
+			}
+		}
+
+		// octaveNoiseRow for `height` rows starting at y, dy apart, stored
+		// one after the other in out (width * height values)
+		void octaveNoiseGrid(double x, double y, double dx, double dy, std::size_t width, std::size_t height,
+			std::int32_t octaves, double* out, double lacunarity = 2.0, double persistence = 0.5) const
+		{
+			for (std::size_t j = 0; j < height; ++j)
+			{
+				octaveNoiseRow(x, dx, y + static_cast<double>(j) * dy, width, octaves, out + j * width,
+					lacunarity, persistence);
+			}
+		}
+
 		double noise0_1(double x) const
 		{
 			return noise(x) * 0.5 + 0.5;
@@ -0,0 +1,116 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+#include <noise/noise.h>
+
+#include "noiseutils.h"
+#include "terrain_noise.h"
+
+// compara os mapas gerados em precisão simples (noise::PRECISION_SINGLE)
+// com os de precisão dupla, rodado por main quando RUN_PRECISION_CHECK está
+// habilitado. Os mapas guardam float, então diferenças abaixo do
+// arredondamento do float não aparecem
+namespace wega
+{
+namespace precision_check
+{
+    struct Difference
+    {
+        double max = 0.0;
+        double mean = 0.0;
+    };
+
+    struct Bounds
+    {
+        double x_lower, x_upper, z_lower, z_upper;
+    };
+
+    // o mapa de main e regiões cada vez mais longe da origem: o erro da
+    // precisão simples não deve crescer com as coordenadas
+    static const Bounds BOUNDS[] = {
+        { 0.0, 2.0, 0.0, 2.0 },
+        { -37.5, -35.5, 12.25, 14.25 },
+        { 1000.0, 1002.0, -2000.0, -1998.0 },
+        { 250000.0, 250002.0, 250000.0, 250002.0 },
+    };
+
+    static const int SEEDS[] = { 0, 1, 42, 123456789 };
+
+    // diferença entre os mapas sz x sz de `source` nos limites `bounds`
+    // gerados nas duas precisões
+    inline Difference Compare(const noise::module::Module& source, const Bounds& bounds, int sz)
+    {
+        noise::utils::NoiseMap maps[2];
+        noise::utils::NoiseMapBuilderPlane builder;
+        builder.SetSourceModule(source);
+        builder.SetDestSize(sz, sz);
+        builder.SetBounds(bounds.x_lower, bounds.x_upper, bounds.z_lower, bounds.z_upper);
+        builder.SetThreadCount(0);
+        for (int i = 0; i < 2; i++)
+        {
+            builder.SetDestNoiseMap(maps[i]);
+            builder.SetPrecision(i == 0 ? noise::PRECISION_DOUBLE : noise::PRECISION_SINGLE);
+            builder.Build();
+        }
+
+        Difference difference;
+        for (int z = 0; z < sz; z++)
+            for (int x = 0; x < sz; x++)
+            {
+                const double d = std::fabs(static_cast<double>(maps[0].GetValue(x, z)) - maps[1].GetValue(x, z));
+                difference.max = std::max(difference.max, d);
+                difference.mean += d;
+            }
+        difference.mean /= static_cast<double>(sz) * sz;
+
+        return difference;
+    }
+
+    // completa a linha do caso com a diferença e a acumula em `total`
+    inline void Report(const Difference& difference, Difference& total, int& cases)
+    {
+        std::cout << ": máxima " << difference.max << ", média " << difference.mean << "\n";
+        total.max = std::max(total.max, difference.max);
+        total.mean += difference.mean;
+        cases++;
+    }
+
+    // um gerador em todas as sementes e limites
+    template <typename Generator>
+    inline void CheckGenerator(const char* name, int sz, Difference& total, int& cases)
+    {
+        for (const int seed : SEEDS)
+            for (const Bounds& bounds : BOUNDS)
+            {
+                Generator generator;
+                generator.SetSeed(seed);
+                std::cout << name << ", semente " << seed << ", x em [" << bounds.x_lower << ", "
+                    << bounds.x_upper << "]";
+                Report(Compare(generator, bounds, sz), total, cases);
+            }
+    }
+
+    inline void Run(int sz = 256)
+    {
+        Difference total;
+        int cases = 0;
+
+        TerrainNoise terrain_noise;
+        for (const Bounds& bounds : BOUNDS)
+        {
+            std::cout << "TerrainNoise, x em [" << bounds.x_lower << ", " << bounds.x_upper << "]";
+            Report(Compare(terrain_noise.GetSource(), bounds, sz), total, cases);
+        }
+
+        CheckGenerator<noise::module::Perlin>("Perlin", sz, total, cases);
+        CheckGenerator<noise::module::Billow>("Billow", sz, total, cases);
+        CheckGenerator<noise::module::RidgedMulti>("RidgedMulti", sz, total, cases);
+
+        std::cout << "total de " << cases << " mapas " << sz << "x" << sz << ": máxima " << total.max
+            << ", média " << total.mean / cases << "\n";
+    }
+}
+}
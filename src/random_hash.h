@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstdint>
+
+// valores aleatórios sem estado: cada valor é o hash de uma chave (semente,
+// camada, posição), então não depende da ordem em que os pontos são
+// gerados nem de quantas threads os geram
+namespace wega
+{
+    // finalizador do SplitMix64: espalha cada bit da entrada por todos os
+    // bits da saída
+    inline std::uint64_t MixBits(std::uint64_t x)
+    {
+        x += 0x9e3779b97f4a7c15ull;
+        x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+        x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+        return x ^ (x >> 31);
+    }
+
+    // chave de uma camada gerada com a semente `seed`
+    inline std::uint64_t HashLayer(int seed, unsigned int layer)
+    {
+        return MixBits(static_cast<std::uint64_t>(layer) << 32 | static_cast<std::uint32_t>(seed));
+    }
+
+    // hash do ponto (x, z) na camada `key`
+    inline std::uint64_t HashPoint(std::uint64_t key, int x, int z)
+    {
+        return MixBits(key ^ (static_cast<std::uint64_t>(static_cast<std::uint32_t>(x)) << 32 | static_cast<std::uint32_t>(z)));
+    }
+
+    // os 53 bits altos de `hash` como um double em [0, 1)
+    inline double HashToUnit(std::uint64_t hash)
+    {
+        return static_cast<double>(hash >> 11) * (1.0 / 9007199254740992.0);
+    }
+}
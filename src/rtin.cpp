@@ -0,0 +1,197 @@
+#include "rtin.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <thread>
+
+namespace wega
+{
+Rtin::Rtin(const Chunk* chunk)
+    : m_chunk(chunk), m_sz(chunk->GetSize())
+{
+    const unsigned int tile = m_sz - 1;
+    assert(tile > 0 && (tile & (tile - 1)) == 0);
+
+    m_triangle_count = tile * tile * 2 - 2;
+    m_coords.resize(4 * static_cast<size_t>(m_triangle_count));
+    m_heights.resize(static_cast<size_t>(m_sz) * m_sz);
+    m_errors.reset(new std::atomic<float>[static_cast<size_t>(m_sz) * m_sz]);
+
+    for (unsigned int i = 0; i < m_triangle_count; i++)
+    {
+        unsigned int id = i + 2;
+        unsigned int ax = 0, az = 0, bx = 0, bz = 0, cx = 0, cz = 0;
+
+        // os dois triângulos da raiz dividem o quadrado pela diagonal
+        if (id & 1)
+            bx = bz = cx = tile;
+        else
+            ax = az = cz = tile;
+
+        // cada bit seguinte do id escolhe a metade esquerda ou direita
+        while ((id >>= 1) > 1)
+        {
+            unsigned int mx = (ax + bx) >> 1;
+            unsigned int mz = (az + bz) >> 1;
+
+            if (id & 1)
+            {
+                bx = ax; bz = az;
+                ax = cx; az = cz;
+            }
+            else
+            {
+                ax = bx; az = bz;
+                bx = cx; bz = cz;
+            }
+            cx = mx; cz = mz;
+        }
+
+        m_coords[4 * i] = static_cast<unsigned short>(ax);
+        m_coords[4 * i + 1] = static_cast<unsigned short>(az);
+        m_coords[4 * i + 2] = static_cast<unsigned short>(bx);
+        m_coords[4 * i + 3] = static_cast<unsigned short>(bz);
+    }
+
+    for (size_t i = 0; i < static_cast<size_t>(m_sz) * m_sz; i++)
+        m_errors[i].store(0.0f, std::memory_order_relaxed);
+}
+
+void Rtin::UpdateTriangles(unsigned int first, unsigned int last)
+{
+    const unsigned int tile = m_sz - 1;
+    // os triângulos do último nível não têm filhos
+    const unsigned int parent_count = m_triangle_count - tile * tile;
+
+    for (unsigned int i = first; i < last; i++)
+    {
+        const unsigned int ax = m_coords[4 * i];
+        const unsigned int az = m_coords[4 * i + 1];
+        const unsigned int bx = m_coords[4 * i + 2];
+        const unsigned int bz = m_coords[4 * i + 3];
+        const unsigned int mx = (ax + bx) >> 1;
+        const unsigned int mz = (az + bz) >> 1;
+        const unsigned int cx = mx + mz - az;
+        const unsigned int cz = mz + ax - mx;
+
+        const size_t middle = static_cast<size_t>(mz) * m_sz + mx;
+        const double interpolated = (m_heights[az * m_sz + ax] + m_heights[bz * m_sz + bx]) / 2.0;
+        float error = static_cast<float>(std::fabs(interpolated - m_heights[middle]));
+
+        if (i < parent_count)
+        {
+            // os vértices do meio dos filhos pertencem ao nível seguinte, que
+            // já foi concluído
+            const size_t left = static_cast<size_t>((az + cz) >> 1) * m_sz + ((ax + cx) >> 1);
+            const size_t right = static_cast<size_t>((bz + cz) >> 1) * m_sz + ((bx + cx) >> 1);
+            error = std::max({error, m_errors[left].load(std::memory_order_relaxed),
+                m_errors[right].load(std::memory_order_relaxed)});
+        }
+
+        // os dois triângulos que compartilham a hipotenusa escrevem no mesmo
+        // vértice e podem estar em threads diferentes
+        float current = m_errors[middle].load(std::memory_order_relaxed);
+        while (current < error && !m_errors[middle].compare_exchange_weak(current, error, std::memory_order_relaxed))
+            ;
+    }
+}
+
+void Rtin::Update(unsigned int thread_count)
+{
+    unsigned int threads = thread_count > 0 ? thread_count : std::max(1u, std::thread::hardware_concurrency());
+
+    for (unsigned int z = 0; z < m_sz; z++)
+        for (unsigned int x = 0; x < m_sz; x++)
+    {
+        m_heights[z * m_sz + x] = m_chunk->GetHeight(x, z);
+        m_errors[z * m_sz + x].store(0.0f, std::memory_order_relaxed);
+    }
+
+    // o nível l da hierarquia são os ids com l + 2 bits, ou seja, os
+    // triângulos [2^(l + 1) - 2, 2^(l + 2) - 2). Cada nível só lê os erros do
+    // nível seguinte, então os triângulos de um mesmo nível são independentes
+    unsigned int level_end = m_triangle_count;
+    while (level_end > 0)
+    {
+        unsigned int level_begin = 0;
+        while (2 * (level_begin + 2) - 2 < level_end)
+            level_begin = 2 * (level_begin + 2) - 2;
+
+        const unsigned int count = level_end - level_begin;
+        const unsigned int level_threads = std::min(threads, std::max(1u, count / MIN_TRIANGLES_PER_THREAD));
+
+        if (level_threads == 1)
+            UpdateTriangles(level_begin, level_end);
+        else
+        {
+            std::vector<std::thread> workers;
+            for (unsigned int t = 0; t < level_threads; t++)
+            {
+                unsigned int first = level_begin + static_cast<unsigned int>(static_cast<unsigned long long>(count) * t / level_threads);
+                unsigned int last = level_begin + static_cast<unsigned int>(static_cast<unsigned long long>(count) * (t + 1) / level_threads);
+                workers.emplace_back([this, first, last]() { UpdateTriangles(first, last); });
+            }
+
+            for (auto& worker : workers)
+                worker.join();
+        }
+
+        level_end = level_begin;
+    }
+}
+
+GLuint Rtin::VertexIndex(unsigned int x, unsigned int z) const
+{
+    const unsigned int px = (x + m_chunk->GetOriginX()) % m_sz;
+    const unsigned int pz = (z + m_chunk->GetOriginZ()) % m_sz;
+
+    return pz * m_sz + px;
+}
+
+void Rtin::AddTriangles(unsigned int ax, unsigned int az, unsigned int bx, unsigned int bz,
+    unsigned int cx, unsigned int cz, float max_error, std::vector<GLuint>& indices) const
+{
+    const unsigned int mx = (ax + bx) >> 1;
+    const unsigned int mz = (az + bz) >> 1;
+    const unsigned int leg = (ax > cx ? ax - cx : cx - ax) + (az > cz ? az - cz : cz - az);
+
+    if (leg > 1 && m_errors[static_cast<size_t>(mz) * m_sz + mx].load(std::memory_order_relaxed) > max_error)
+    {
+        AddTriangles(cx, cz, ax, az, mx, mz, max_error, indices);
+        AddTriangles(bx, bz, cx, cz, mx, mz, max_error, indices);
+        return;
+    }
+
+    // a grade do Chunk usa (tl, bl, tr): no plano xz, (b - a) x (c - a) < 0
+    const long long cross = (static_cast<long long>(bx) - ax) * (static_cast<long long>(cz) - az)
+        - (static_cast<long long>(bz) - az) * (static_cast<long long>(cx) - ax);
+    indices.push_back(VertexIndex(ax, az));
+    if (cross < 0)
+    {
+        indices.push_back(VertexIndex(bx, bz));
+        indices.push_back(VertexIndex(cx, cz));
+    }
+    else
+    {
+        indices.push_back(VertexIndex(cx, cz));
+        indices.push_back(VertexIndex(bx, bz));
+    }
+}
+
+void Rtin::GetIndices(double max_error, std::vector<GLuint>& indices) const
+{
+    const unsigned int tile = m_sz - 1;
+
+    indices.clear();
+    AddTriangles(0, 0, tile, tile, tile, 0, static_cast<float>(max_error), indices);
+    AddTriangles(tile, tile, 0, 0, 0, tile, static_cast<float>(max_error), indices);
+}
+
+double Rtin::ScreenSpaceError(double pixels, double distance, double fov, double viewport_height)
+{
+    const double pi = 3.14159265358979323846;
+    // tamanho no mundo de um pixel à distância `distance`
+    return pixels * 2.0 * distance * std::tan(fov * pi / 360.0) / viewport_height;
+}
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include "chunk.h"
+
+namespace wega
+{
+    // malha adaptativa por bissecção da aresta mais longa (right-triangulated
+    // irregular network, como no martini da Mapbox) sobre o heightmap de um
+    // Chunk com 2^k + 1 amostras por lado. Update calcula, para cada vértice
+    // que divide a hipotenusa de algum triângulo da hierarquia, o maior erro
+    // de altura introduzido ao não dividi-lo (incluindo os descendentes);
+    // GetIndices desce a hierarquia só onde esse erro passa do limite. Os
+    // índices apontam para os vértices do próprio Chunk, então a malha usa o
+    // mesmo vertex buffer da grade uniforme
+    class Rtin
+    {
+        // níveis da hierarquia com menos triângulos que isso não são divididos
+        // entre threads
+        static constexpr unsigned int MIN_TRIANGLES_PER_THREAD = 4096;
+
+        const Chunk* m_chunk;
+        unsigned int m_sz;
+        unsigned int m_triangle_count;
+        // (ax, az, bx, bz) da hipotenusa de cada triângulo da hierarquia; o
+        // triângulo i tem id = i + 2 e seus filhos são 2 * id e 2 * id + 1
+        std::vector<unsigned short> m_coords;
+        std::vector<double> m_heights;
+        // erro de cada vértice; atômico porque os dois triângulos que dividem
+        // a mesma hipotenusa podem ser atualizados por threads diferentes
+        std::unique_ptr<std::atomic<float>[]> m_errors;
+
+        void UpdateTriangles(unsigned int first, unsigned int last);
+        void AddTriangles(unsigned int ax, unsigned int az, unsigned int bx, unsigned int bz,
+            unsigned int cx, unsigned int cz, float max_error, std::vector<GLuint>& indices) const;
+        GLuint VertexIndex(unsigned int x, unsigned int z) const;
+    public:
+        explicit Rtin(const Chunk* chunk);
+
+        Rtin(const Rtin&) = delete;
+        Rtin& operator=(const Rtin&) = delete;
+
+        // recalcula os erros a partir do heightmap atual do chunk, nível por
+        // nível da hierarquia (do mais fino ao mais grosso), dividindo cada
+        // nível entre `thread_count` threads (0 = todos os núcleos)
+        void Update(unsigned int thread_count = 0);
+        // triângulos (no winding da grade do Chunk) cujo erro de altura em
+        // relação ao heightmap é no máximo `max_error`, em unidades do mundo
+        void GetIndices(double max_error, std::vector<GLuint>& indices) const;
+
+        // erro no mundo que corresponde a `pixels` na tela a uma distância
+        // `distance` da câmera, para uma projeção com campo de visão vertical
+        // `fov` (em graus) e `viewport_height` pixels de altura
+        static double ScreenSpaceError(double pixels, double distance, double fov, double viewport_height);
+    };
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include <vector>
+
+namespace wega
+{
+    // buffer de vértices persistentemente mapeado (glBufferStorage com
+    // GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT) dividido em `slot_count`
+    // slots usados em rodízio. A CPU escreve direto no slot devolvido por
+    // Acquire enquanto a GPU ainda pode estar lendo os anteriores; um
+    // glFenceSync por slot impede que um slot seja reescrito antes de a GPU
+    // terminar os comandos emitidos enquanto ele estava em uso
+    class StreamBuffer
+    {
+        GLuint m_buffer;
+        GLsizeiptr m_slot_size;
+        unsigned int m_slot_count, m_current;
+        char* m_data;
+        std::vector<GLsync> m_fences;
+    public:
+        StreamBuffer(GLsizeiptr slot_size, unsigned int slot_count = 3)
+            : m_slot_size(slot_size), m_slot_count(slot_count), m_current(slot_count - 1),
+              m_fences(slot_count, nullptr)
+        {
+            const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+            glGenBuffers(1, &m_buffer);
+            glBindBuffer(GL_ARRAY_BUFFER, m_buffer);
+            glBufferStorage(GL_ARRAY_BUFFER, slot_size * slot_count, nullptr, flags);
+            m_data = static_cast<char*>(glMapBufferRange(GL_ARRAY_BUFFER, 0, slot_size * slot_count, flags));
+        }
+
+        ~StreamBuffer()
+        {
+            for (GLsync fence : m_fences)
+                if (fence != nullptr)
+                    glDeleteSync(fence);
+
+            glBindBuffer(GL_ARRAY_BUFFER, m_buffer);
+            glUnmapBuffer(GL_ARRAY_BUFFER);
+            glDeleteBuffers(1, &m_buffer);
+        }
+
+        StreamBuffer(const StreamBuffer&) = delete;
+        StreamBuffer& operator=(const StreamBuffer&) = delete;
+
+        // encerra o slot atual (os comandos já emitidos que o leem ficam
+        // protegidos por uma fence) e devolve o próximo, esperando a GPU
+        // liberá-lo se necessário
+        void* Acquire(void)
+        {
+            m_fences[m_current] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+            m_current = (m_current + 1) % m_slot_count;
+
+            GLsync fence = m_fences[m_current];
+            if (fence != nullptr)
+            {
+                GLbitfield flags = 0;
+                GLuint64 timeout = 0;
+                // na primeira tentativa só verifica; depois força o envio dos
+                // comandos pendentes e espera
+                for (;;)
+                {
+                    GLenum status = glClientWaitSync(fence, flags, timeout);
+                    if (status == GL_ALREADY_SIGNALED || status == GL_CONDITION_SATISFIED || status == GL_WAIT_FAILED)
+                        break;
+                    flags = GL_SYNC_FLUSH_COMMANDS_BIT;
+                    timeout = 1000000;
+                }
+                glDeleteSync(fence);
+                m_fences[m_current] = nullptr;
+            }
+
+            return m_data + m_current * m_slot_size;
+        }
+
+        GLuint GetBuffer(void) const { return m_buffer; }
+        // offset do slot atual dentro do buffer, em bytes
+        GLintptr GetOffset(void) const { return m_current * m_slot_size; }
+        GLsizeiptr GetSlotSize(void) const { return m_slot_size; }
+    };
+}
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <noise/noise.h>
+
+#include <cmath>
+
+namespace wega
+{
+    // grafo de módulos do libnoise usado para gerar o heightmap. Os módulos
+    // guardam ponteiros uns para os outros, então o objeto não pode ser
+    // copiado. Nenhum módulo do grafo tem estado mutável (não há Cache), então
+    // GetValue pode ser chamado de várias threads ao mesmo tempo. O grafo é
+    // compilado uma vez em um noise::module::Program, que é o que vai para o
+    // NoiseMapBuilder
+    class TerrainNoise
+    {
+        noise::module::RidgedMulti m_ridged;
+        noise::module::Billow m_base;
+        noise::module::ScaleBias m_flattener;
+        noise::module::Perlin m_perlin;
+        noise::module::Add m_adder;
+        noise::module::Voronoi m_voronoi;
+        noise::module::Select m_selector;
+        noise::module::Turbulence m_turbulence;
+        noise::module::Program m_program;
+    public:
+        TerrainNoise()
+        {
+            m_ridged.SetOctaveCount(8);
+            m_ridged.SetFrequency(2);
+            m_ridged.SetLacunarity(1.2);
+
+            m_base.SetFrequency(2.0);
+            m_base.SetOctaveCount(8);
+            m_base.SetLacunarity(2.5);
+
+            m_flattener.SetSourceModule(0, m_base);
+            m_flattener.SetScale(0.02);
+            m_flattener.SetBias(-0.75);
+
+            m_perlin.SetSeed(123456789);
+            m_perlin.SetOctaveCount(8);
+            m_perlin.SetFrequency(2.0);
+            m_perlin.SetPersistence(1 / 4);
+            m_perlin.SetLacunarity(1.5);
+
+            m_voronoi.SetFrequency(1);
+            m_voronoi.SetDisplacement(10);
+
+            m_selector.SetSourceModule(0, m_flattener);
+            m_selector.SetSourceModule(1, m_ridged);
+            m_selector.SetControlModule(m_perlin);
+            m_selector.SetBounds(0.8, 1000.0);
+            m_selector.SetEdgeFalloff(0.9);
+
+            m_turbulence.SetSourceModule(0, m_selector);
+            m_turbulence.SetFrequency(2.0);
+            // 1/4 é divisão inteira: a potência é 0 e a turbulência não
+            // desloca nada, então a grade de deslocamento
+            // (Turbulence::SetFieldResolution) não é habilitada aqui
+            m_turbulence.SetPower(1/4);
+
+            m_adder.SetSourceModule(1, m_perlin);
+            m_adder.SetSourceModule(0, m_voronoi);
+
+            // o programa guarda os parâmetros do ScaleBias; o período dos
+            // geradores continua podendo ser mudado depois
+            m_program.Compile(m_turbulence);
+        }
+
+        TerrainNoise(const TerrainNoise&) = delete;
+        TerrainNoise& operator=(const TerrainNoise&) = delete;
+
+        // faz o grafo inteiro se repetir a cada `extent` unidades nos três
+        // eixos (0 desativa). extent vezes a frequência de cada módulo
+        // precisa ser inteiro, já que o período dos módulos é contado em
+        // células da grade do ruído
+        void SetPeriod(double extent)
+        {
+            const auto period = [extent](double frequency)
+            {
+                return static_cast<int>(std::lround(extent * frequency));
+            };
+
+            m_ridged.SetPeriod(period(m_ridged.GetFrequency()));
+            m_base.SetPeriod(period(m_base.GetFrequency()));
+            m_perlin.SetPeriod(period(m_perlin.GetFrequency()));
+            m_voronoi.SetPeriod(period(m_voronoi.GetFrequency()));
+            m_turbulence.SetPeriod(period(m_turbulence.GetFrequency()));
+        }
+
+        // grafo compilado, passado para o NoiseMapBuilder
+        const noise::module::Module& GetSource(void) const { return m_program; }
+        // módulo final do grafo, avaliado módulo a módulo
+        const noise::module::Module& GetGraph(void) const { return m_turbulence; }
+    };
+}